@@ -28,11 +28,16 @@
 
 #include <vector> //std::vector
 #include <string> //std::string
+#include <algorithm> //std::fill, std::copy
+#include <functional> //std::function
+#include <utility> //std::pair
+#include <memory> //std::unique_ptr
 
 #include "Globals.hpp"
 #include "Exceptions.hpp"
 
 using namespace std;
+using hashing::TWordHashSize;
 
 namespace tries {
 
@@ -42,6 +47,164 @@ namespace tries {
     template<TTrieSize N> struct SFrequencyResult {
         TFrequencySize result[N];
     };
+
+    //This typedef defines a probability result type, which is an array of
+    //N log10 probabilities. The value with index [0] will contain the
+    //probability of the last word given all the preceding N-1 words etc.
+    template<TTrieSize N> struct SProbabilityResult {
+        TLogProbSize result[N];
+    };
+
+    //The smoothing methods for computing the N-gram probabilities
+    enum ESmoothing {
+        //The stupid back-off of Brants et al., the scores are not normalized
+        STUPID_BACKOFF_SMOOTHING = 0,
+        //The interpolated modified Kneser-Ney of Chen & Goodman
+        KNESER_NEY_SMOOTHING = STUPID_BACKOFF_SMOOTHING + 1
+    };
+
+    //This structure stores the data of an N-gram given to the N-gram visitors
+    typedef struct {
+        //The N-gram frequency
+        TFrequencySize freq;
+        //The N-gram log10 probability, if the probabilities are computed
+        TLogProbSize prob;
+        //The N-gram log10 back-off weight, if the probabilities are computed
+        TLogProbSize backoff;
+    } SNGramData;
+
+    //The N-gram visitor function type, gets the N-gram words and data
+    typedef function<void(const vector<string> & words, const SNGramData & data)> TNGramVisitor;
+
+    //The continuation of a context: the word following it and the frequency
+    //of the N-gram made of the context and the word, @see topContinuations
+    typedef pair<string, TFrequencySize> TContinuation;
+
+    /**
+     * This is the cursor over the stored N-grams matching a pattern, @see
+     * ATrie::findNGrams. The N-grams are found one at a time, as the cursor
+     * is moved, so they are never all materialized. The trie must not be
+     * changed or destroyed while its cursor is in use.
+     */
+    class ANGramCursor {
+    public:
+
+        /**
+         * Moves the cursor to the next matching N-gram
+         * @param words the out parameter for the N-gram words
+         * @param freq the out parameter for the N-gram frequency
+         * @return true if there is the next N-gram, false if all the N-grams are found
+         */
+        virtual bool next(vector<string> & words, TFrequencySize & freq) = 0;
+
+        virtual ~ANGramCursor() {
+        }
+    };
+
+    //This structure stores the memory usage of one N-gram level of a trie, in bytes
+    struct SMemoryUsage {
+        //The number of the stored N-grams
+        size_t numNGrams;
+        //The entry arrays and the key/value pairs of the hash map nodes
+        size_t entries;
+        //The hash map bucket arrays
+        size_t buckets;
+        //The hash map node overhead: the node pointers and the heap block overhead
+        size_t nodes;
+        //The heap allocated word strings
+        size_t strings;
+        //The query caches
+        size_t caches;
+        //The number of the stored entries that are not N-grams of the trie, e.g.
+        //the context entries replicated in the shards, they are in the bytes above
+        size_t numReplicas;
+
+        /**
+         * Allows to get the total memory usage of the level
+         * @return the total number of bytes
+         */
+        inline size_t getTotal() const {
+            return entries + buckets + nodes + strings + caches;
+        }
+
+        /**
+         * Allows to add the memory usage of another level, e.g. of a shard
+         * @param other the memory usage to add
+         */
+        inline void add(const SMemoryUsage & other) {
+            numNGrams += other.numNGrams;
+            entries += other.entries;
+            buckets += other.buckets;
+            nodes += other.nodes;
+            strings += other.strings;
+            caches += other.caches;
+            numReplicas += other.numReplicas;
+        }
+    };
+
+    //This structure stores the memory usage of the trie's N-gram levels, the value
+    //with index [0] is the 1-gram level, i.e. the dictionary, and so forth. The
+    //memory not belonging to any level, e.g. the trie objects, is stored separately.
+    template<TTrieSize N> struct SMemoryStatistics {
+        SMemoryUsage levels[N];
+        size_t other;
+
+        /**
+         * Allows to get the total memory usage of the trie
+         * @return the total number of bytes
+         */
+        inline size_t getTotal() const {
+            size_t total = other;
+            for (TTrieSize idx = 0; idx < N; idx++) {
+                total += levels[idx].getTotal();
+            }
+            return total;
+        }
+    };
+
+    //This structure stores the hot region usage of one N-gram level of a trie. The
+    //hot region is the leading part of the level's entries, the ones of the most
+    //frequent words, that is small enough to stay in the processor caches.
+    struct SHotRegionUsage {
+        //The number of bytes of the hot region
+        size_t hotBytes;
+        //The number of the found level entries
+        size_t numProbes;
+        //The number of the found level entries within the hot region
+        size_t numHotProbes;
+
+        /**
+         * Allows to add the hot region usage of another level, e.g. of a shard
+         * @param other the hot region usage to add
+         */
+        inline void add(const SHotRegionUsage & other) {
+            hotBytes += other.hotBytes;
+            numProbes += other.numProbes;
+            numHotProbes += other.numHotProbes;
+        }
+    };
+
+    //This structure stores the hot region usage of the trie's N-gram levels, the
+    //value with index [0] is the 1-gram level, i.e. the dictionary, and so forth.
+    template<TTrieSize N> struct SHotRegionStatistics {
+        SHotRegionUsage levels[N];
+    };
+
+    //This structure stores the state of a left to right sentence query, i.e.
+    //the context ids of the longest N-grams ending with the last queried word.
+    //The value with index [0] is the context of the 1-gram, i.e. the word id,
+    //the value with index [1] is the context of the 2-gram and so forth.
+    //The undefined context means that the N-gram is not present in the trie.
+    template<TTrieSize N> struct SQueryState {
+        TContextId contexts[N - 1];
+
+        /**
+         * Resets the state to the beginning of a sentence, where there is no context
+         */
+        inline void reset() {
+            fill(contexts, contexts + (N - 1), UNDEFINED_CONTEXT_ID);
+        }
+    };
    
     
     /**
@@ -55,20 +218,25 @@ namespace tries {
     template<TTrieSize N, bool doCache>
     class ATrie {
     public:
+        //The type of the trie's partitions, @see getPartition
+        typedef ATrie<N, doCache> TPartition;
+
         
         /**
          * This method adds a words to the trie
          * @param tokens the array of tokens/words to add the trie from
+         * @param hashes the array of the tokens' word hashes, @see TextTokenizer
          */
-        virtual void addWords(vector<string> &tokens) = 0;
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) = 0;
 
         /**
          * This method adds a new n-gram into the trie
          * @param tokens the array of tokens to add the trie from
+         * @param hashes the array of the tokens' word hashes, @see TextTokenizer
          * @param idx the index to start with
          * @param n the value of "n" for the n-gram (the number of elements in the n-gram).
          */
-        virtual void addNGram(vector<string> &tokens, const int idx, const int n ) = 0;
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int idx, const int n ) = 0;
 
         /**
          * Returns the maximum length of the considered N-Grams
@@ -112,14 +280,350 @@ namespace tries {
          * freqs[3] = frequency( [word4 word5] )
          * freqs[4] = frequency( [word5] )
          * @param ngram the given N-gram vector is expected to have exactly N elements (see the template parameters)
+         * @param hashes the N-gram words' hashes, @see TextTokenizer
          * @param freqs the array into which the frequencies will be placed.
          */
-        virtual void queryNGramFreqs( const vector<string> & ngram, SFrequencyResult<N> & freqs ) = 0;
+        virtual void queryNGramFreqs( const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs ) = 0;
+
+        /**
+         * This method queries the frequencies of a batch of N-grams, the same as
+         * queryNGramFreqs does for every one of them. The tries may interleave the
+         * lookups of several N-grams to hide the memory latency, by default the
+         * N-grams are just queried one by one.
+         * @param words the words of the N-grams, N words per N-gram, one N-gram after another
+         * @param hashes the words' hashes, @see TextTokenizer
+         * @param freqs the vector into which the frequencies will be placed, one entry per N-gram
+         * @param numInFlight the maximum number of the interleaved lookups
+         */
+        virtual void queryNGramFreqsBatch(const vector<string> & words, const vector<TWordHashSize> & hashes,
+                                          vector< SFrequencyResult<N> > & freqs,
+                                          const size_t numInFlight = DEFAULT_LOOKUPS_IN_FLIGHT) {
+            const size_t count = words.size() / N;
+            freqs.resize(count);
+            vector<string> ngram(N);
+            vector<TWordHashSize> ngramHashes(N);
+            for (size_t idx = 0; idx < count; idx++) {
+                copy(words.begin() + idx * N, words.begin() + (idx + 1) * N, ngram.begin());
+                copy(hashes.begin() + idx * N, hashes.begin() + (idx + 1) * N, ngramHashes.begin());
+                queryNGramFreqs(ngram, ngramHashes, freqs[idx]);
+            }
+        }
+
+        /**
+         * This method queries the trie for all the N-grams ending with the given
+         * word, given the state of the sentence's previous words. The state is then
+         * advanced to the given word. This way a sentence is queried word by word,
+         * with at most N lookups per word and without hashing the preceding words
+         * again. The state is to be reset at the beginning of every sentence.
+         * @param state the query state of the previous word, is changed to the state of the given word
+         * @param word the next sentence word
+         * @param hash the next sentence word's hash, @see TextTokenizer
+         * @param freqs the array into which the frequencies will be placed,
+         *              as for queryNGramFreqs with the N-gram ending with the given
+         *              word, the frequencies of the N-grams longer than the
+         *              sentence prefix are zero.
+         * @throws Exception in case this trie does not support the query states
+         */
+        virtual void queryNextWord(SQueryState<N> & state, const string & word, const TWordHashSize hash,
+                                   SFrequencyResult<N> & freqs) throw (Exception) {
+            throw Exception("The query states are not supported by this trie!");
+        }
+
+        /**
+         * This method queries the trie for all the N-grams ending at every word
+         * of the sentence. By default the N-grams ending with every word are
+         * queried independently with queryNGramFreqs, the tries supporting the
+         * query states do it word by word with queryNextWord.
+         * @param tokens the sentence words
+         * @param hashes the sentence words' hashes, @see TextTokenizer
+         * @param freqs the vector into which the frequencies will be placed, one
+         *              element per word, @see queryNextWord
+         */
+        virtual void scoreSentence(const vector<string> & tokens, const vector<TWordHashSize> & hashes,
+                                   vector< SFrequencyResult<N> > & freqs) {
+            freqs.resize(tokens.size());
+
+            //The N-gram window, the words before the sentence beginning are empty
+            vector<string> ngram(N);
+            vector<TWordHashSize> ngramHashes(N, 0);
+            for (size_t idx = 0; idx < tokens.size(); idx++) {
+                //Shift the window by one word
+                for (TTrieSize pos = 0; pos < (N - 1); pos++) {
+                    ngram[pos].swap(ngram[pos + 1]);
+                    ngramHashes[pos] = ngramHashes[pos + 1];
+                }
+                ngram[N - 1] = tokens[idx];
+                ngramHashes[N - 1] = hashes[idx];
+
+                queryNGramFreqs(ngram, ngramHashes, freqs[idx]);
+
+                //The N-grams reaching before the sentence beginning are not present
+                if (idx < (N - 1)) {
+                    fill(freqs[idx].result, freqs[idx].result + (N - 1 - idx), 0);
+                }
+            }
+        }
+
+        /**
+         * This method computes the smoothed log10 probabilities and back-off
+         * weights of all the stored N-grams, the ARPA way. It is to be called
+         * once the trie is filled in, the N-grams added afterwards make the
+         * probabilities stale and they need to be computed again.
+         * @param smoothing the smoothing method
+         * @throws Exception in case this trie does not support the probabilities
+         */
+        virtual void computeProbs(const ESmoothing smoothing) throw (Exception) {
+            throw Exception("The probabilities are not supported by this trie!");
+        }
+
+        /**
+         * Allows to test if the probabilities are computed, @see computeProbs
+         * @return true if the probabilities can be queried, otherwise false
+         */
+        virtual bool hasProbs() const { return false; }
+
+        /**
+         * This method will get the N-gram in a form of a vector, e.g.:
+         *      [word1 word2 word3 word4 word5]
+         * and will compute the log10 probabilities of the last word given its contexts:
+         * probs[0] = log10 P( word5 | word1 word2 word3 word4 )
+         * probs[1] = log10 P( word5 | word2 word3 word4 )
+         * probs[2] = log10 P( word5 | word3 word4 )
+         * probs[3] = log10 P( word5 | word4 )
+         * probs[4] = log10 P( word5 )
+         * The missing N-grams back off to the shorter ones.
+         * @param ngram the given N-gram vector is expected to have exactly N elements (see the template parameters)
+         * @param hashes the N-gram words' hashes, @see TextTokenizer
+         * @param probs the array into which the log10 probabilities will be placed.
+         * @throws Exception in case the probabilities are not computed
+         */
+        virtual void queryNGramProbs(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                     SProbabilityResult<N> & probs) throw (Exception) {
+            throw Exception("The probabilities are not supported by this trie!");
+        }
+
+        /**
+         * This method adds a new N-gram with the given log10 probability and back-off
+         * weight into the trie, e.g. from an ARPA file. The N-gram's prefixes are added
+         * too, if needed. The frequencies of the added N-grams are not changed.
+         * @param ngram the N-gram words, 1 <= ngram.size() <= N
+         * @param hashes the N-gram words' hashes, @see TextTokenizer
+         * @param prob the N-gram's log10 probability
+         * @param backoff the N-gram's log10 back-off weight
+         * @throws Exception in case this trie does not support the probabilities
+         */
+        virtual void addNGramProb(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TLogProbSize prob, const TLogProbSize backoff) throw (Exception) {
+            throw Exception("The probabilities are not supported by this trie!");
+        }
+
+        /**
+         * Adds the given frequency to the given N-gram, e.g. when the counts
+         * of a saved trie are loaded. The missing words and N-gram prefixes
+         * are added with zero frequencies. Does not re-set the query cache.
+         * @param ngram the N-gram words, 1 <= ngram.size() <= N
+         * @param hashes the words' hashes, @see TextTokenizer
+         * @param freq the frequency to add
+         * @throws Exception in case this trie does not support adding the frequencies
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception) {
+            throw Exception("Adding the N-gram frequencies is not supported by this trie!");
+        }
+
+        /**
+         * Freezes the filled in trie: the build time structures are rewritten
+         * into the compact read-only ones and released. The query results stay
+         * the same, but no words or N-grams can be added to the trie after that.
+         * The tries that have no build time structures do nothing.
+         * @throws Exception in case the trie can not be compacted
+         */
+        virtual void compact() throw (Exception) {
+        }
+
+        /**
+         * Allows to get the number of the stored N-grams of the given level
+         * @param L the N-gram level, 1 <= L <= N
+         * @return the number of the stored L-grams
+         * @throws Exception in case this trie does not support the N-gram iteration
+         */
+        virtual size_t getNumNGrams(const TTrieSize L) const throw (Exception) {
+            throw Exception("The N-gram iteration is not supported by this trie!");
+        }
+
+        /**
+         * This method calls the visitor for all the stored N-grams of the given
+         * level, in no particular order. The N-gram words are recovered from the
+         * stored ids, the probabilities are given if they are computed.
+         * @param L the N-gram level, 1 <= L <= N
+         * @param visitor the visitor function
+         * @throws Exception in case this trie does not support the N-gram iteration
+         */
+        virtual void visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception) {
+            throw Exception("The N-gram iteration is not supported by this trie!");
+        }
+
+        /**
+         * This method calls the visitor for the N-grams of the given level in
+         * the given chunk. The chunks are disjoint and together they contain all
+         * the N-grams visited by visitNGrams, so different chunks can be visited
+         * by different threads at once, as long as the trie is not changed.
+         * By default the first chunk has all the N-grams and the others are empty.
+         * @param L the N-gram level, 1 <= L <= N
+         * @param chunkIdx the chunk index, 0 <= chunkIdx < numChunks
+         * @param numChunks the number of chunks, > 0
+         * @param visitor the visitor function
+         * @throws Exception in case this trie does not support the N-gram iteration
+         */
+        virtual void visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                      const TNGramVisitor & visitor) const throw (Exception) {
+            if (chunkIdx == 0) {
+                visitNGrams(L, visitor);
+            }
+        }
+
+        /**
+         * Builds the forward continuation index, i.e. the words following every
+         * stored context sorted by the decreasing frequency, @see topContinuations.
+         * It is to be built once the trie is filled in, the N-grams added afterwards
+         * are not in the index until it is built again.
+         * @throws Exception in case this trie does not support the continuations
+         */
+        virtual void buildContinuations() throw (Exception) {
+            throw Exception("The continuations are not supported by this trie!");
+        }
+
+        /**
+         * Allows to test if the continuation index is built, @see buildContinuations
+         * @return true if the continuations can be queried, otherwise false
+         */
+        virtual bool hasContinuations() const { return false; }
+
+        /**
+         * This method gives the k most frequent words following the given context,
+         * i.e. the k most frequent N-grams starting with it, in the decreasing order
+         * of their frequencies, the words of equal frequencies are in no particular
+         * order. The time needed is proportional to k.
+         * @param context the context words, 1 <= context.size() <= N - 1
+         * @param hashes the context words' hashes, @see TextTokenizer
+         * @param k the maximum number of continuations to give
+         * @param result the out parameter for the continuations, fewer than k if
+         *               there are not as many, empty if the context is not stored
+         * @throws Exception in case the continuation index is not built
+         */
+        virtual void topContinuations(const vector<string> & context, const vector<TWordHashSize> & hashes,
+                                      const size_t k, vector<TContinuation> & result) const throw (Exception) {
+            throw Exception("The continuations are not supported by this trie!");
+        }
+
+        /**
+         * This method opens the cursor over the stored N-grams matching the given
+         * pattern, in no particular order. The pattern words are either words or
+         * the NGRAM_PATTERN_WILDCARD that matches any word, the level of the found
+         * N-grams is the pattern length. The N-grams with zero frequencies, e.g. the
+         * prefixes added by addNGramFreq, are not found.
+         * @param pattern the pattern words, 1 <= pattern.size() <= N
+         * @param hashes the pattern words' hashes, @see TextTokenizer, the wildcards' ones are ignored
+         * @return the cursor, see ANGramCursor
+         * @throws Exception in case this trie does not support the N-gram patterns
+         */
+        virtual unique_ptr<ANGramCursor> findNGrams(const vector<string> & pattern, const vector<TWordHashSize> & hashes) const throw (Exception) {
+            throw Exception("The N-gram patterns are not supported by this trie!");
+        }
+
+        /**
+         * Allows to get the exact breakdown of the memory used by the trie's
+         * data structures per N-gram level. In contrast to the process wide
+         * statistics of the StatisticsMonitor it tells where the bytes go.
+         * @param stats the out parameter to store the statistics into
+         * @throws Exception in case this trie does not support the memory accounting
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+            throw Exception("The memory accounting is not supported by this trie!");
+        }
+
+        /**
+         * Turns the counting of the found level entries on or off, the counters
+         * are reset when it is turned on, @see getHotRegionStatistics.
+         * The counting slows the queries down a bit, so it is off by default.
+         * @param isCounting true to count the found entries, otherwise false
+         * @throws Exception in case this trie has no hot regions
+         */
+        virtual void setHotRegionCounting(const bool isCounting) throw (Exception) {
+            throw Exception("The hot regions are not supported by this trie!");
+        }
+
+        /**
+         * Allows to get the hot region sizes of the levels and the number of the
+         * level entries found in them, since the counting was turned on.
+         * @param stats the out parameter to store the statistics into
+         * @throws Exception in case this trie has no hot regions
+         */
+        virtual void getHotRegionStatistics(SHotRegionStatistics<N> & stats) const throw (Exception) {
+            throw Exception("The hot regions are not supported by this trie!");
+        }
 
         /**
          * Allows to force reset of internal query caches, if they exist
          */
         virtual void resetQueryCache() = 0;
+
+        /**
+         * Allows to get the number of the independent partitions of the trie.
+         * The partitions can be filled in concurrently, without locking, as
+         * long as every partition is filled in by one thread only.
+         * @return the number of partitions, one by default
+         */
+        virtual size_t getNumPartitions() const { return 1; }
+
+        /**
+         * Allows to get the partition with the given index. The concrete tries
+         * return their partitions' concrete type, see TPartition, so that the
+         * builders instantiated on the concrete trie types fill them in directly.
+         * @param idx the partition index, 0 <= idx < getNumPartitions()
+         * @return the partition, the trie itself by default
+         */
+        virtual ATrie<N, doCache> & getPartition(const size_t idx) { return *this; }
+
+        /**
+         * Allows to get the number of threads that fill in the trie at once. In
+         * contrast to the partitions every thread adds all the words and N-grams
+         * of its own lines into the whole trie. The room for every batch of lines
+         * is made in advance, @see reserve.
+         * @return the number of the builder threads, zero by default, i.e. the trie is not thread safe
+         */
+        virtual size_t getNumBuildThreads() const { return 0; }
+
+        /**
+         * Makes room for the words and N-grams of the given number of tokens,
+         * before several threads add them at once, @see getNumBuildThreads.
+         * Is called when no other thread is using the trie. Does nothing by default.
+         * @param numTokens the number of tokens, bounds the number of the new words and N-grams of every level
+         * @throws Exception in case the room can not be made
+         */
+        virtual void reserve(const size_t numTokens) throw (Exception) {}
+
+        /**
+         * Allows to get the index of the partition storing the given word
+         * and all the N-grams ending with this word. The partitioned tries
+         * use getHashPartitionIndex, so that the builders compute it inline.
+         * @param hash the word's hash
+         * @return the partition index, 0 by default
+         */
+        virtual size_t getPartitionIndex(const TWordHashSize hash) const { return 0; }
+
+        /**
+         * Maps the word's hash onto one of the given number of partitions
+         * @param hash the word's hash
+         * @param numParts the number of partitions, must be > 0
+         * @return the partition index
+         */
+        static inline size_t getHashPartitionIndex(const TWordHashSize hash, const size_t numParts) {
+            //Use the upper hash bits, the lower ones pick the buckets inside the partition
+            return (hash >> 32) % numParts;
+        }
+
+        virtual ~ATrie() {}
     };
     
     //Handy type definitions for the tries of different sizes and with.without caches
@@ -0,0 +1,244 @@
+/*
+ * File:   AdaptiveMap.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 10:12 AM
+ */
+
+#ifndef ADAPTIVEMAP_HPP
+#define	ADAPTIVEMAP_HPP
+
+#include <stdint.h>       // uint8_t
+#include <cstddef>        // size_t
+#include <unordered_map>  // std::unordered_map
+
+#include "MemoryUtils.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    //The default number of key/value pairs stored inline by the adaptive map
+    #define ADAPTIVE_MAP_INLINE_CAPACITY 4
+
+    /**
+     * This is an adaptive map intended for the N-gram level entries of a word.
+     * Most of the words have only a handful of contexts at the higher N-gram
+     * levels, so up to K key/value pairs are stored inline, in a small array
+     * sorted by the key and scanned linearly. Such a map does not need any
+     * heap allocations and a lookup into it touches one or two cache lines.
+     * Once there are more than K pairs, the map switches to an unordered_map.
+     * Note: The keys and values must be trivially copyable, e.g. integers and PODs.
+     * The value of a new key is value initialized, i.e. zeroed for the PODs.
+     * @param TKey the key type
+     * @param TValue the value type
+     * @param K the maximum number of inline stored pairs
+     */
+    template<typename TKey, typename TValue, uint8_t K = ADAPTIVE_MAP_INLINE_CAPACITY>
+    class AdaptiveMap {
+    public:
+        //The type of the map used for the large number of pairs
+        typedef unordered_map<TKey, TValue> TLargeMap;
+
+        /**
+         * The basic constructor, creates an empty map
+         */
+        AdaptiveMap() : _size(0) {
+        }
+
+        /**
+         * The move constructor, needed for storing the maps in vectors
+         * @param other the map to move from
+         */
+        AdaptiveMap(AdaptiveMap && other) noexcept : _size(other._size), _store(other._store) {
+            other._size = 0;
+        }
+
+        /**
+         * The move assignment operator
+         * @param other the map to move from
+         * @return this map
+         */
+        AdaptiveMap & operator=(AdaptiveMap && other) noexcept {
+            if (this != &other) {
+                clear();
+                _size = other._size;
+                _store = other._store;
+                other._size = 0;
+            }
+            return *this;
+        }
+
+        /**
+         * Gets the value of the given key, inserts a new value initialized value if needed
+         * @param key the key to look for
+         * @return the reference to the value
+         */
+        inline TValue & operator[](const TKey & key) {
+            if (_size <= K) {
+                //Look for the key or for the position to insert it at
+                uint8_t idx = 0;
+                while ((idx < _size) && (_store.small.keys[idx] < key)) {
+                    idx++;
+                }
+                if ((idx < _size) && (_store.small.keys[idx] == key)) {
+                    return _store.small.values[idx];
+                }
+                if (_size < K) {
+                    //Shift the larger pairs and insert the new one
+                    for (uint8_t pos = _size; pos > idx; pos--) {
+                        _store.small.keys[pos] = _store.small.keys[pos - 1];
+                        _store.small.values[pos] = _store.small.values[pos - 1];
+                    }
+                    _store.small.keys[idx] = key;
+                    _store.small.values[idx] = TValue();
+                    _size++;
+                    return _store.small.values[idx];
+                }
+                //There is no more room, switch to the large map
+                growLarge();
+            }
+            return (*_store.large)[key];
+        }
+
+        /**
+         * Looks up the value of the given key
+         * @param key the key to look for
+         * @return the pointer to the value or NULL if the key is not present
+         */
+        inline const TValue * find(const TKey & key) const {
+            if (_size <= K) {
+                for (uint8_t idx = 0; idx < _size; idx++) {
+                    if (_store.small.keys[idx] == key) {
+                        return &_store.small.values[idx];
+                    }
+                }
+                return NULL;
+            } else {
+                typename TLargeMap::const_iterator found = _store.large->find(key);
+                return (found != _store.large->end()) ? &found->second : NULL;
+            }
+        }
+
+        /**
+         * Allows to get the number of stored pairs
+         * @return the number of stored pairs
+         */
+        inline size_t size() const {
+            return (_size <= K) ? _size : _store.large->size();
+        }
+
+        /**
+         * Allows to check if the pairs are stored inline
+         * @return true if the map is small and stores its pairs inline, otherwise false
+         */
+        inline bool isSmall() const {
+            return (_size <= K);
+        }
+
+        /**
+         * Adds up the heap memory used by the map, not including the map object itself.
+         * The inline stored pairs do not use any heap memory.
+         * @param entries the bytes of the key/value pairs
+         * @param buckets the bytes of the large map's bucket array
+         * @param nodes the bytes of the large map's node and heap block overhead
+         */
+        inline void addHeapBytes(size_t & entries, size_t & buckets, size_t & nodes) const {
+            if (_size > K) {
+                const size_t numPairs = _store.large->size();
+                entries += sizeof (TLargeMap) + numPairs * sizeof (typename TLargeMap::value_type);
+                buckets += memory::getHashMapBucketBytes(*_store.large);
+                nodes += memory::getHeapBlockBytes(sizeof (TLargeMap)) - sizeof (TLargeMap)
+                        + numPairs * memory::getHashMapNodeOverheadBytes<TLargeMap>();
+            }
+        }
+
+        /**
+         * Calls the given function for all the stored pairs, in no particular order
+         * @param func the function to call with the key and the value as arguments
+         */
+        template<typename TFunction>
+        inline void forEach(TFunction func) const {
+            if (_size <= K) {
+                for (uint8_t idx = 0; idx < _size; idx++) {
+                    func(_store.small.keys[idx], _store.small.values[idx]);
+                }
+            } else {
+                for (typename TLargeMap::const_iterator it = _store.large->begin(); it != _store.large->end(); ++it) {
+                    func(it->first, it->second);
+                }
+            }
+        }
+
+        /**
+         * Removes all the pairs from the map and releases the large map
+         */
+        void clear() {
+            if (_size > K) {
+                delete _store.large;
+            }
+            _size = 0;
+        }
+
+        ~AdaptiveMap() {
+            clear();
+        }
+
+    private:
+        //The size value indicating that the large map is used
+        static const uint8_t LARGE_SIZE = K + 1;
+
+        //The number of inline stored pairs or LARGE_SIZE if the large map is used
+        uint8_t _size;
+
+        //The storage is either the inline arrays or the large map pointer
+        union {
+
+            struct {
+                //The keys, sorted in the increasing order
+                TKey keys[K];
+                //The values, in the order of keys
+                TValue values[K];
+            } small;
+            //The large map
+            TLargeMap * large;
+        } _store;
+
+        //The copy constructor and assignment are made private as we do not intend to copy maps
+        AdaptiveMap(const AdaptiveMap & other);
+        AdaptiveMap & operator=(const AdaptiveMap & other);
+
+        /**
+         * Moves the inline stored pairs into a newly allocated large map
+         */
+        void growLarge() {
+            TLargeMap * large = new TLargeMap();
+            for (uint8_t idx = 0; idx < _size; idx++) {
+                large->insert(make_pair(_store.small.keys[idx], _store.small.values[idx]));
+            }
+            _store.large = large;
+            _size = LARGE_SIZE;
+        }
+    };
+}
+
+#endif	/* ADAPTIVEMAP_HPP */
+
@@ -0,0 +1,163 @@
+/* 
+ * File:   ArpaReader.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:40 PM
+ */
+
+#ifndef ARPAREADER_HPP
+#define	ARPAREADER_HPP
+
+#include <fstream>      // std::ifstream
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "ATrie.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace arpa {
+
+        //The number of ARPA file lines parsed in one batch
+        #define ARPA_READ_BATCH_LINES 100000
+
+        /**
+         * This is the ARPA file reader, it fills in the given trie with the
+         * N-gram probabilities and back-off weights, @see ATrie::addNGramProb.
+         * The file is read in batches of lines and the batches are pipelined:
+         * while a batch is parsed by several threads, the previous batch is
+         * put into the trie and the next one is read from the file.
+         * The N-grams longer than N are skipped.
+         * @param N - the maximum level of the considered N-gram, i.e. the N value
+         * @param doCache - the trie's query caching flag
+         */
+        template<TTrieSize N, bool doCache>
+        class ArpaReader {
+        public:
+            /**
+             * The basic constructor
+             * @param trie the trie to fill in
+             * @param fstr the ARPA file stream to read from
+             * @param numThreads the number of parsing threads, must be positive
+             * @throws Exception if the number of threads is zero
+             */
+            ArpaReader(ATrie<N, doCache> & trie, ifstream & fstr, const size_t numThreads) throw (Exception);
+
+            /**
+             * Reads the ARPA file and fills in the trie
+             * @throws Exception if the file is malformed
+             */
+            void read() throw (Exception);
+
+            virtual ~ArpaReader();
+
+        private:
+
+            /**
+             * This structure stores one parsed ARPA N-gram line
+             */
+            typedef struct {
+                //The N-gram words
+                vector<string> words;
+                //The N-gram word hashes
+                vector<TWordHashSize> hashes;
+                //The log10 probability
+                TLogProbSize prob;
+                //The log10 back-off weight
+                TLogProbSize backoff;
+            } SArpaEntry;
+
+            /**
+             * This structure stores one batch of the N-gram lines
+             */
+            typedef struct {
+                //The lines
+                vector<string> lines;
+                //The N-gram levels of the lines
+                vector<TTrieSize> levels;
+                //The parsed lines
+                vector<SArpaEntry> entries;
+                //The parsing errors of every parsing thread, if any
+                vector<string> errors;
+            } SArpaBatch;
+
+            //The trie to fill in
+            ATrie<N, doCache> & _trie;
+            //The ARPA file stream
+            ifstream & _fstr;
+            //The number of parsing threads
+            const size_t _numThreads;
+
+            //The level of the current N-grams section, zero if in no section
+            TTrieSize _level;
+            //True once the end of the ARPA data is reached
+            bool _isEnd;
+            //The numbers of the N-grams per level given in the header and the read ones
+            vector<size_t> _expected;
+            vector<size_t> _actual;
+
+            /**
+             * Reads the ARPA header up to the first N-grams section
+             * @throws Exception if the header is malformed
+             */
+            void readHeader() throw (Exception);
+
+            /**
+             * Reads the next batch of the N-gram lines, the sections are tracked
+             * @param batch the batch to fill in, is cleared first
+             * @throws Exception if a section header is malformed
+             */
+            void readBatch(SArpaBatch & batch) throw (Exception);
+
+            /**
+             * Parses every numThreads'th line of the batch starting from the given one,
+             * the parsing error is stored in the batch under the first line index
+             * @param batch the batch to parse
+             * @param first the index of the first line to parse, also the parsing thread index
+             */
+            void parseBatch(SArpaBatch & batch, const size_t first);
+
+            /**
+             * Puts the parsed N-grams of the batch into the trie
+             * @param batch the parsed batch
+             * @throws Exception if the batch could not be parsed
+             */
+            void addBatch(SArpaBatch & batch) throw (Exception);
+
+            /**
+             * Parses the N-grams section header, e.g. "\3-grams:"
+             * @param line the header line
+             * @return the section's N-gram level
+             * @throws Exception if the header is malformed
+             */
+            static TTrieSize parseSectionLevel(const string & line) throw (Exception);
+
+            //The copy constructor
+            ArpaReader(const ArpaReader& orig);
+        };
+    }
+}
+
+#endif	/* ARPAREADER_HPP */
+
@@ -0,0 +1,79 @@
+/* 
+ * File:   ArpaWriter.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 05:25 PM
+ */
+
+#ifndef ARPAWRITER_HPP
+#define	ARPAWRITER_HPP
+
+#include <fstream>      // std::ofstream
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "ATrie.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace arpa {
+
+        /**
+         * This is the ARPA file writer, it exports the N-gram probabilities
+         * and back-off weights of the given trie. The N-grams of every level
+         * are iterated over with ATrie::visitNGrams, which recovers their
+         * words from the stored ids.
+         * @param N - the maximum level of the considered N-gram, i.e. the N value
+         * @param doCache - the trie's query caching flag
+         */
+        template<TTrieSize N, bool doCache>
+        class ArpaWriter {
+        public:
+            /**
+             * The basic constructor
+             * @param trie the trie to export
+             * @param fstr the ARPA file stream to write into
+             */
+            ArpaWriter(ATrie<N, doCache> & trie, ofstream & fstr);
+
+            /**
+             * Writes the ARPA file
+             * @throws Exception if the trie has no probabilities or can not be iterated over
+             */
+            void write() throw (Exception);
+
+            virtual ~ArpaWriter();
+
+        private:
+            //The trie to export
+            ATrie<N, doCache> & _trie;
+            //The ARPA file stream
+            ofstream & _fstr;
+
+            //The copy constructor
+            ArpaWriter(const ArpaWriter& orig);
+        };
+    }
+}
+
+#endif	/* ARPAWRITER_HPP */
+
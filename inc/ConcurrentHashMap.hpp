@@ -0,0 +1,264 @@
+/* 
+ * File:   ConcurrentHashMap.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:10 PM
+ */
+
+#ifndef CONCURRENTHASHMAP_HPP
+#define	CONCURRENTHASHMAP_HPP
+
+#include <stdint.h>       // uint64_t
+#include <cstddef>        // size_t
+#include <atomic>         // std::atomic
+#include <thread>         // std::this_thread::yield
+#include <limits>         // std::numeric_limits
+
+#include "Exceptions.hpp"
+#include "HashingUtils.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    //The minimum number of the concurrent map slots, must be a power of two
+    #define CONCURRENT_MAP_MIN_CAPACITY 1024
+    //The maximum load factor of the concurrent map, as the numerator and the denominator
+    #define CONCURRENT_MAP_MAX_LOAD_NUM 1
+    #define CONCURRENT_MAP_MAX_LOAD_DEN 2
+
+    /**
+     * This is an insertion optimized concurrent hash map, with open addressing
+     * and linear probing, that gives the integer keys dense ids and counts.
+     * Several threads can insert the keys and add to their counts at once
+     * without any locks: a new key claims an empty slot with a compare and
+     * swap and the counts are increased with an atomic fetch and add. The id
+     * of a new key is assigned by the thread that has claimed its slot, the
+     * other threads inserting the same key wait until it is published.
+     * The map does not grow while it is inserted into, the room for the new
+     * keys is made in advance, when no other thread uses the map, @see reserve.
+     * The key ids stay the same when the map grows.
+     * Note: The zero key marks the empty slots and can not be inserted.
+     * @param TKey the integer key type
+     * @param TId the integer id type, the ids start with one
+     * @param TCount the integer count type
+     */
+    template<typename TKey, typename TId, typename TCount>
+    class ConcurrentHashMap {
+    public:
+
+        //The map slot, the id is zero until the key's id is published
+        struct SSlot {
+            //The key, zero if the slot is empty
+            atomic<TKey> key;
+            //The key's id
+            atomic<TId> id;
+            //The key's count
+            atomic<TCount> count;
+        };
+
+        /**
+         * The basic constructor, creates an empty map without slots
+         */
+        ConcurrentHashMap() : _slots(NULL), _capacity(0), _size(0) {
+        }
+
+        /**
+         * Makes room for the given number of new keys, so that they can be
+         * inserted without exceeding the maximum load factor. Is not thread safe,
+         * no other thread may use the map at the same time.
+         * @param numNew the maximum number of the new keys to be inserted
+         * @throws Exception in case the ids of the new keys would not fit the id type
+         */
+        void reserve(const size_t numNew) throw (Exception) {
+            const size_t required = size() + numNew;
+            if (required > numeric_limits<TId>::max()) {
+                throw Exception("The concurrent hash map ids are exhausted!");
+            }
+            if (required * CONCURRENT_MAP_MAX_LOAD_DEN > _capacity * CONCURRENT_MAP_MAX_LOAD_NUM) {
+                rehash(getCapacity(required));
+            }
+        }
+
+        /**
+         * Rehashes the map into the smallest number of slots for its keys.
+         * Is not thread safe, no other thread may use the map at the same time.
+         */
+        void shrink() {
+            const size_t capacity = getCapacity(size());
+            if (capacity < _capacity) {
+                rehash(capacity);
+            }
+        }
+
+        /**
+         * Gets the slot of the given key, claims a new slot for it if needed.
+         * Is thread safe, the room for the key must have been made, @see reserve.
+         * @param key the key to look for, not zero
+         * @param onNew the function called with the id of a new key before the
+         *              id is published, e.g. to store the key's data by its id
+         * @return the key's slot, with the key's id published
+         */
+        template<typename TOnNew>
+        inline SSlot & insert(const TKey key, TOnNew onNew) {
+            for (size_t idx = getIndex(key);; idx = (idx + 1) & (_capacity - 1)) {
+                SSlot & slot = _slots[idx];
+                TKey current = slot.key.load(memory_order_acquire);
+                if (current == 0) {
+                    if (slot.key.compare_exchange_strong(current, key, memory_order_acq_rel)) {
+                        //The slot is claimed, give the key the next id and publish it
+                        const TId id = _size.fetch_add(1, memory_order_relaxed) + 1;
+                        onNew(id);
+                        slot.id.store(id, memory_order_release);
+                        return slot;
+                    }
+                    //Another thread has claimed the slot, the current is its key now
+                }
+                if (current == key) {
+                    //The key is claimed by another thread, wait until its id is published
+                    while (slot.id.load(memory_order_acquire) == 0) {
+                        this_thread::yield();
+                    }
+                    return slot;
+                }
+            }
+        }
+
+        /**
+         * Looks up the slot of the given key. May run concurrently with the insertions,
+         * then the slots of the keys being inserted may be found with the zero id.
+         * @param key the key to look for, not zero
+         * @return the key's slot or NULL if the key is not present
+         */
+        inline const SSlot * find(const TKey key) const {
+            if (_capacity == 0) {
+                return NULL;
+            }
+            for (size_t idx = getIndex(key);; idx = (idx + 1) & (_capacity - 1)) {
+                const SSlot & slot = _slots[idx];
+                const TKey current = slot.key.load(memory_order_acquire);
+                if (current == key) {
+                    return &slot;
+                }
+                if (current == 0) {
+                    return NULL;
+                }
+            }
+        }
+
+        /**
+         * Calls the given function for all the stored keys, in no particular order.
+         * Is not to be used while the keys are inserted.
+         * @param func the function to call with the key, the id and the count as arguments
+         */
+        template<typename TFunction>
+        inline void forEach(TFunction func) const {
+            for (size_t idx = 0; idx < _capacity; idx++) {
+                const SSlot & slot = _slots[idx];
+                const TKey key = slot.key.load(memory_order_relaxed);
+                if (key != 0) {
+                    func(key, slot.id.load(memory_order_relaxed), slot.count.load(memory_order_relaxed));
+                }
+            }
+        }
+
+        /**
+         * Allows to get the number of the stored keys, i.e. the maximum id
+         * @return the number of the stored keys
+         */
+        inline size_t size() const {
+            return _size.load(memory_order_relaxed);
+        }
+
+        /**
+         * Allows to get the number of bytes of the slots array
+         * @return the slots array bytes
+         */
+        inline size_t getSlotBytes() const {
+            return _capacity * sizeof (SSlot);
+        }
+
+        ~ConcurrentHashMap() {
+            delete[] _slots;
+        }
+
+    private:
+        //The slots array
+        SSlot * _slots;
+        //The number of slots, a power of two
+        size_t _capacity;
+        //The number of stored keys
+        atomic<size_t> _size;
+
+        //The copy constructor and assignment are made private as we do not intend to copy maps
+        ConcurrentHashMap(const ConcurrentHashMap & other);
+        ConcurrentHashMap & operator=(const ConcurrentHashMap & other);
+
+        /**
+         * Gives the index of the key's first probed slot
+         * @param key the key
+         * @return the slot index
+         */
+        inline size_t getIndex(const TKey key) const {
+            return hashing::fmix64(key) & (_capacity - 1);
+        }
+
+        /**
+         * Gives the smallest capacity for the given number of keys
+         * @param numKeys the number of keys
+         * @return the number of slots, a power of two
+         */
+        static inline size_t getCapacity(const size_t numKeys) {
+            size_t capacity = CONCURRENT_MAP_MIN_CAPACITY;
+            while (numKeys * CONCURRENT_MAP_MAX_LOAD_DEN > capacity * CONCURRENT_MAP_MAX_LOAD_NUM) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        /**
+         * Moves the keys into the new slots array of the given capacity
+         * @param capacity the new number of slots, a power of two
+         */
+        void rehash(const size_t capacity) {
+            SSlot * slots = new SSlot[capacity]();
+            for (size_t oldIdx = 0; oldIdx < _capacity; oldIdx++) {
+                const SSlot & slot = _slots[oldIdx];
+                const TKey key = slot.key.load(memory_order_relaxed);
+                if (key != 0) {
+                    size_t idx = hashing::fmix64(key) & (capacity - 1);
+                    while (slots[idx].key.load(memory_order_relaxed) != 0) {
+                        idx = (idx + 1) & (capacity - 1);
+                    }
+                    slots[idx].key.store(key, memory_order_relaxed);
+                    slots[idx].id.store(slot.id.load(memory_order_relaxed), memory_order_relaxed);
+                    slots[idx].count.store(slot.count.load(memory_order_relaxed), memory_order_relaxed);
+                }
+            }
+            delete[] _slots;
+            _slots = slots;
+            _capacity = capacity;
+        }
+    };
+}
+
+#endif	/* CONCURRENTHASHMAP_HPP */
+
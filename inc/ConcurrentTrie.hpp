@@ -0,0 +1,374 @@
+/* 
+ * File:   ConcurrentTrie.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:25 PM
+ */
+
+#ifndef CONCURRENTTRIE_HPP
+#define	CONCURRENTTRIE_HPP
+
+#include <vector>       // std::vector
+#include <string>       // std::string
+#include <algorithm>    // std::fill
+
+#include "ATrie.hpp"
+#include "ConcurrentHashMap.hpp"
+#include "Globals.hpp"
+#include "HashingUtils.hpp"
+#include "Logger.hpp"
+
+using namespace std;
+using namespace hashing;
+
+namespace tries {
+
+    /**
+     * This is a concurrent ITrie interface implementation class. It is a
+     * HashMapTrie that several threads can fill in at once: the words and
+     * the N-grams of every level get their dense ids and frequencies from a
+     * lock-free ConcurrentHashMap. The N-gram keys are the id of the last
+     * word and the context id of the preceding words, as in the HashMapTrie.
+     * In contrast to the partitioned tries every thread adds all the words
+     * and N-grams of its own lines and there is no merge phase afterwards.
+     * The room for the words and N-grams of every batch of lines is made in
+     * advance, @see reserve, as the maps do not grow while they are filled in.
+     * In the hash verification mode the words colliding with the hash of another
+     * word are stored under the next keys of their collision chain, @see getCollisionKey
+     * Note: The trie has no query cache and does not support the word queries.
+     * @param N - the maximum level of the considered N-gram, i.e. the N value
+     * @param doCache - the indicative flag to cache the queries, is ignored
+     */
+    template<TTrieSize N, bool doCache>
+    class ConcurrentTrie final : public ATrie<N, doCache> {
+    public:
+        //The trie is its own only partition
+        typedef ConcurrentTrie TPartition;
+
+        /**
+         * The basic class constructor
+         * @param numThreads the number of threads filling in the trie, must be > 0
+         * @throws Exception in case the number of threads is zero
+         */
+        explicit ConcurrentTrie(const size_t numThreads) throw (Exception);
+
+        /**
+         * Is thread safe, the room for the words must have been made, @see reserve
+         * For more details @see ITrie
+         */
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) {
+            for (size_t idx = 0; idx < tokens.size(); idx++) {
+                getOrCreateWord(tokens[idx], hashes[idx]).count.fetch_add(1, memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Is thread safe, the room for the N-grams must have been made, @see reserve
+         * For more details @see ITrie
+         */
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int base_idx, const int n) {
+            //The context of the first word is the word id itself
+            TContextId context = getOrCreateWord(tokens[base_idx], hashes[base_idx]).id.load(memory_order_relaxed);
+
+            //The prefixes of the N-gram get the zero frequency entries, their ids are the next level contexts
+            for (int idx = 1; idx < n; idx++) {
+                const TWordSlot & word = getOrCreateWord(tokens[base_idx + idx], hashes[base_idx + idx]);
+                TNGramSlot & entry = getOrCreateEntry(idx + 1, word.id.load(memory_order_relaxed), context);
+                if (idx == n - 1) {
+                    entry.count.fetch_add(1, memory_order_relaxed);
+                } else {
+                    context = entry.id.load(memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * Returns the trie itself, as its concrete type
+         * For more details @see ITrie
+         */
+        virtual ConcurrentTrie & getPartition(const size_t idx) {
+            return *this;
+        }
+
+        /**
+         * There is no query cache
+         * For more details @see ITrie
+         */
+        virtual void resetQueryCache() {
+        }
+
+        /**
+         * Is not supported as the N-gram maps are not indexed by the last word
+         * For more details @see ITrie
+         */
+        virtual void queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception);
+
+        /**
+         * Is not supported as the N-gram maps are not indexed by the last word
+         * For more details @see ITrie
+         */
+        virtual SFrequencyResult<N> & queryWordFreqs(const string & word) throw (Exception);
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs) {
+            //First just clean the array
+            fill(freqs.result, freqs.result + N, 0);
+
+            //Get the last 1-gram's word frequency
+            const TWordSlot * endWord = findWord(ngram[N - 1], hashes[N - 1]);
+            if (endWord == NULL) {
+                return;
+            }
+            freqs.result[N - 1] = endWord->count.load(memory_order_relaxed);
+
+            //Get the ids of the N-gram words, the unknown words get the undefined id
+            TWordId wordIds[N];
+            for (TTrieSize idx = 0; idx < (N - 1); idx++) {
+                const TWordSlot * word = findWord(ngram[idx], hashes[idx]);
+                wordIds[idx] = (word != NULL) ? word->id.load(memory_order_relaxed) : UNDEFINED_WORD_ID;
+            }
+            const TWordId endWordId = endWord->id.load(memory_order_relaxed);
+
+            //Now compute the frequencies of all longer N-grams with N >= 2,
+            //the first missing N-gram means that the longer ones are missing too
+            for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+                const TTrieSize startIdx = N - L;
+                TContextId context = wordIds[startIdx];
+                for (TTrieSize idx = startIdx + 1; idx < (N - 1); idx++) {
+                    const TNGramSlot * prefix = findEntry(idx - startIdx + 1, wordIds[idx], context);
+                    if (prefix == NULL) {
+                        return;
+                    }
+                    context = prefix->id.load(memory_order_relaxed);
+                }
+                const TNGramSlot * entry = findEntry(L, endWordId, context);
+                if (entry == NULL) {
+                    return;
+                }
+                freqs.result[startIdx] = entry->count.load(memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Is not thread safe
+         * For more details @see ATrie
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception);
+
+        /**
+         * Shrinks the maps and the id arrays to fit, the trie can still be added to
+         * For more details @see ATrie
+         */
+        virtual void compact() throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual size_t getNumNGrams(const TTrieSize L) const throw (Exception) {
+            return (L == 1) ? words.size() : levels[L - MINIMUM_CONTEXT_LEVEL].size();
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception);
+
+        /**
+         * The slot arrays of the maps are the level entries
+         * For more details @see ATrie
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual size_t getNumBuildThreads() const {
+            return numThreads;
+        }
+
+        /**
+         * Makes room in the maps of all levels and in the id arrays
+         * For more details @see ATrie
+         */
+        virtual void reserve(const size_t numTokens) throw (Exception);
+
+        virtual ~ConcurrentTrie();
+
+    private:
+        //Stores the minimum context level
+        static const TTrieSize MINIMUM_CONTEXT_LEVEL;
+
+        //The salt of the dictionary keys of the colliding words, @see getCollisionKey
+        static const uint64_t WORD_COLLISION_SALT = 0x9E3779B97F4A7C15ULL;
+
+        //The dictionary map type, maps the word hashes to the word ids and frequencies
+        typedef ConcurrentHashMap<uint64_t, TWordId, TFrequencySize> TWordMap;
+        typedef typename TWordMap::SSlot TWordSlot;
+
+        //The N-gram level map type, maps the N-gram keys, @see getNGramKey,
+        //to the N-gram context ids and frequencies
+        typedef ConcurrentHashMap<uint64_t, TContextId, TFrequencySize> TLevelMap;
+        typedef typename TLevelMap::SSlot TNGramSlot;
+
+        //The context entry storing the N-gram's last word and the context of the preceding words
+        typedef struct {
+            //The id of the last word
+            TWordId word;
+            //The context id of the preceding words
+            TContextId context;
+        } SContextEntry;
+
+        //The number of threads filling in the trie
+        const size_t numThreads;
+
+        //The dictionary map
+        TWordMap words;
+
+        //The words indexed by the word ids
+        vector<string> wordsById;
+
+        //The N-gram level maps for n>=2 and <= N
+        TLevelMap levels[N - 1];
+
+        //The arrays storing the context entries for n>=2 and <= N, indexed by the context id
+        vector<SContextEntry> contexts[N - 1];
+
+        /**
+         * The copy constructor, is made private as we do not intend to copy this class objects
+         * @param orig the object to copy from
+         */
+        ConcurrentTrie(const ConcurrentTrie& orig);
+
+        /**
+         * Gives the dictionary key of the word, the zero key is reserved for the empty slots
+         * @param hash the word's hash
+         * @return the dictionary key
+         */
+        static inline uint64_t getWordKey(const TWordHashSize hash) {
+            return (hash != 0) ? hash : 1;
+        }
+
+        /**
+         * Gives the level map key of the N-gram, it is never zero as the word ids start with one
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the level map key
+         */
+        static inline uint64_t getNGramKey(const TWordId wordId, const TContextId context) {
+            return (static_cast<uint64_t> (context) << 32) | wordId;
+        }
+
+        /**
+         * Gives the next dictionary key of the collision chain, the words colliding
+         * with the word stored under the given key are stored under the next keys
+         * @param key the dictionary key
+         * @return the next dictionary key
+         */
+        static inline uint64_t getCollisionKey(const uint64_t key) {
+            return getWordKey(fmix64(key ^ WORD_COLLISION_SALT));
+        }
+
+        /**
+         * Gets the slot of the given word, registers a new word with zero frequency if needed.
+         * In the hash verification mode a colliding word gets a slot of its own under the
+         * next key of the collision chain, the thread registering it logs the collision.
+         * @param token the word to get the slot for
+         * @param hash the word's hash
+         * @return the word's slot
+         */
+        inline TWordSlot & getOrCreateWord(const string & token, const TWordHashSize hash) {
+            uint64_t key = getWordKey(hash);
+            const TWordSlot * collided = NULL;
+            while (true) {
+                TWordSlot & slot = words.insert(key, [&] (const TWordId id) {
+                    wordsById[id] = token;
+                    if (collided != NULL) {
+                        LOG_WARNING << "Hash collision: '" << token << "' and '" << wordsById[collided->id.load(memory_order_relaxed)]
+                                    << "' both have hash " << hash << ", '" << token << "' is put into the collision chain" << END_LOG;
+                    }
+                });
+#if HASH_VERIFICATION_MODE
+                if (wordsById[slot.id.load(memory_order_relaxed)] != token) {
+                    collided = &slot;
+                    key = getCollisionKey(key);
+                    continue;
+                }
+#endif
+                return slot;
+            }
+        }
+
+        /**
+         * Gets the N-gram slot of the given level, creates a new one with zero frequency if needed.
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the N-gram slot
+         */
+        inline TNGramSlot & getOrCreateEntry(const TTrieSize L, const TWordId wordId, const TContextId context) {
+            vector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+            return levels[L - MINIMUM_CONTEXT_LEVEL].insert(getNGramKey(wordId, context), [&] (const TContextId id) {
+                SContextEntry & entry = levelContexts[id];
+                entry.word = wordId;
+                entry.context = context;
+            });
+        }
+
+        /**
+         * Looks up the slot of the given word
+         * @param word the word to look for
+         * @param hash the word's hash
+         * @return the pointer to the word's slot or NULL if the word is not known
+         */
+        inline const TWordSlot * findWord(const string & word, const TWordHashSize hash) const {
+            uint64_t key = getWordKey(hash);
+            const TWordSlot * slot = words.find(key);
+#if HASH_VERIFICATION_MODE
+            //Follow the collision chain until the word or an empty slot is found
+            while ((slot != NULL) && (wordsById[slot->id.load(memory_order_relaxed)] != word)) {
+                key = getCollisionKey(key);
+                slot = words.find(key);
+            }
+#endif
+            return slot;
+        }
+
+        /**
+         * Looks up the N-gram slot of the given level
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the pointer to the N-gram slot or NULL if there is no such N-gram
+         */
+        inline const TNGramSlot * findEntry(const TTrieSize L, const TWordId wordId, const TContextId context) const {
+            return levels[L - MINIMUM_CONTEXT_LEVEL].find(getNGramKey(wordId, context));
+        }
+    };
+
+    typedef ConcurrentTrie<N_GRAM_PARAM, true> TFiveCacheConcurrentTrie;
+    typedef ConcurrentTrie<N_GRAM_PARAM, false> TFiveNoCacheConcurrentTrie;
+}
+
+#endif	/* CONCURRENTTRIE_HPP */
+
@@ -0,0 +1,464 @@
+/* 
+ * File:   EliasFano.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 08:40 PM
+ */
+
+#ifndef ELIASFANO_HPP
+#define	ELIASFANO_HPP
+
+#include <stdint.h>       // uint8_t, uint64_t
+#include <cstddef>        // size_t
+#include <vector>         // std::vector
+#include <utility>        // std::pair
+#include <functional>     // std::function
+#include <algorithm>      // std::sort
+#include <unordered_map>  // std::unordered_map
+
+#include "LargePages.hpp"
+#include "MemoryUtils.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    //The number of the ones, and of the zeros, between the select samples of an Elias-Fano sequence
+    #define ELIAS_FANO_SELECT_SAMPLE 256
+
+    //The number of the 64 bit words per rank block of the Elias-Fano sequence high bits
+    #define ELIAS_FANO_RANK_BLOCK_WORDS 8
+
+    //The array of the 64 bit words of a bit vector, its pages follow the large table policies
+    typedef vector<uint64_t, memory::LargeTableAllocator<uint64_t> > TBitWords;
+
+    /**
+     * Allows to get the number of bits needed to store the given value
+     * @param value the value
+     * @return the number of bits, zero for the zero value
+     */
+    inline uint8_t getBitWidth(const uint64_t value) {
+        return (value == 0) ? 0 : (64 - __builtin_clzll(value));
+    }
+
+    /**
+     * Finds the position of the set bit of the given rank in the word
+     * @param word the word, must have more than rank set bits
+     * @param rank the rank of the set bit, starting from zero
+     * @return the position of the set bit, starting from the lowest bit
+     */
+    inline uint8_t selectInWord(uint64_t word, uint32_t rank) {
+        uint8_t pos = 0;
+        //Skip the whole bytes first then the single bits
+        uint32_t count = __builtin_popcountll(word & 0xFFu);
+        while (rank >= count) {
+            rank -= count;
+            word >>= 8;
+            pos += 8;
+            count = __builtin_popcountll(word & 0xFFu);
+        }
+        while (rank > 0) {
+            word &= word - 1;
+            rank--;
+        }
+        return pos + __builtin_ctzll(word);
+    }
+
+    /**
+     * This is the array of the fixed width integers packed into 64 bit words,
+     * an integer may span two words. The width of zero bits is allowed, then
+     * all the integers are zero and no memory is used for them.
+     */
+    class BitPackedArray {
+    public:
+
+        /**
+         * The basic constructor, creates an empty array
+         */
+        BitPackedArray() : _width(0), _mask(0), _size(0) {
+        }
+
+        /**
+         * Re-creates the array with the given width and size, the integers are zeroed
+         * @param width the integer width in bits, at most 64
+         * @param size the number of integers
+         */
+        void reset(const uint8_t width, const size_t size) {
+            _width = width;
+            _mask = (width == 64) ? ~uint64_t(0) : ((uint64_t(1) << width) - 1);
+            _size = size;
+            _words.assign((width > 0) ? ((size * width + 63) / 64) : 0, 0);
+            _words.shrink_to_fit();
+        }
+
+        /**
+         * Sets the integer, may be done once per integer after the reset
+         * @param idx the integer index
+         * @param value the integer value, must fit into the width
+         */
+        inline void set(const size_t idx, const uint64_t value) {
+            if (_width > 0) {
+                const size_t bit = idx * _width;
+                const size_t wordIdx = bit >> 6;
+                const uint8_t offset = bit & 63;
+                _words[wordIdx] |= value << offset;
+                if (offset + _width > 64) {
+                    _words[wordIdx + 1] |= value >> (64 - offset);
+                }
+            }
+        }
+
+        /**
+         * Gets the integer
+         * @param idx the integer index
+         * @return the integer value
+         */
+        inline uint64_t get(const size_t idx) const {
+            if (_width == 0) {
+                return 0;
+            }
+            const size_t bit = idx * _width;
+            const size_t wordIdx = bit >> 6;
+            const uint8_t offset = bit & 63;
+            uint64_t value = _words[wordIdx] >> offset;
+            if (offset + _width > 64) {
+                value |= _words[wordIdx + 1] << (64 - offset);
+            }
+            return value & _mask;
+        }
+
+        /**
+         * Allows to get the integer width
+         * @return the integer width in bits
+         */
+        inline uint8_t getWidth() const {
+            return _width;
+        }
+
+        /**
+         * Allows to get the number of bytes used by the packed integers
+         * @return the number of bytes
+         */
+        inline size_t getBytes() const {
+            return memory::getVectorBytes(_words);
+        }
+
+    private:
+        //The integer width in bits
+        uint8_t _width;
+        //The mask of the integer bits
+        uint64_t _mask;
+        //The number of integers
+        size_t _size;
+        //The packed integers
+        TBitWords _words;
+    };
+
+    /**
+     * This is the Elias-Fano encoding of a non-decreasing sequence of integers:
+     *      "Efficient Storage and Retrieval by Content and Address of Static Files"
+     *      Peter Elias, Journal of the ACM, 1974
+     * as used for the N-gram tries in:
+     *      "Efficient Data Structures for Massive N-Gram Datasets"
+     *      Giulio Ermanno Pibiri, Rossano Venturini, SIGIR 2017
+     * 
+     * Every value is split into its l low bits, which are bit packed, and its
+     * high bits, which are stored in unary as the gaps of a bit vector: the
+     * value with the index i sets the bit number i + (value >> l). With l being
+     * about log2(u / n), for n values smaller than u, the sequence takes about
+     * 2 + log2(u / n) bits per value. The high bits of any value, and the
+     * first value of any high bits bucket, are found by a select query. The
+     * positions of every k-th one and of every k-th zero are sampled and the
+     * number of ones before every block of a few words is stored. So a select
+     * is a binary search over the blocks between two samples, which are just a
+     * few unless the ones or the zeros are very sparse there, followed by the
+     * scan of one block. This gives the access, and the successor search within
+     * one bucket, @see nextGEQ, in practically constant time, even for the
+     * skewed sequences such as the N-gram keys of the frequent words.
+     */
+    class EliasFanoSequence {
+    public:
+        //The number of the high bits per rank block
+        static const size_t BLOCK_BITS = ELIAS_FANO_RANK_BLOCK_WORDS * 64;
+
+        /**
+         * The basic constructor, creates an empty sequence
+         */
+        EliasFanoSequence() : _size(0), _numLowBits(0), _lowMask(0), _maxHigh(0) {
+        }
+
+        /**
+         * Encodes the given sequence, replacing the current one
+         * @param size the number of values
+         * @param getValue the function giving the value of the given index,
+         *                 the values must not decrease with the index
+         */
+        void build(const size_t size, const function<uint64_t(const size_t)> & getValue);
+
+        /**
+         * Gets the value with the given index
+         * @param idx the value index, must be smaller than the size
+         * @return the value
+         */
+        inline uint64_t access(const size_t idx) const {
+            return ((select1(idx) - idx) << _numLowBits) | _lowBits.get(idx);
+        }
+
+        /**
+         * Searches for the successor of the given value
+         * @param value the value to search for
+         * @param found the out parameter for the found value, is set if it is found
+         * @return the index of the first value that is greater or equal to the
+         *         given value, or the size of the sequence if there is no such value
+         */
+        inline size_t nextGEQ(const uint64_t value, uint64_t & found) const {
+            const uint64_t high = value >> _numLowBits;
+            if (high > _maxHigh) {
+                return _size;
+            }
+
+            //The bucket of the high bits starts after the previous bucket's end
+            //zero, the ones before it are the values with the smaller high bits
+            const size_t start = (high == 0) ? 0 : (select0(high - 1) + 1);
+            size_t wordIdx = start >> 6;
+            uint64_t word = ~_highBits[wordIdx] & (~uint64_t(0) << (start & 63));
+            while (word == 0) {
+                word = ~_highBits[++wordIdx];
+            }
+            const size_t end = (wordIdx << 6) + __builtin_ctzll(word);
+
+            //The bucket values differ in the low bits only, and the buckets of
+            //the dense regions can be long, so the low bits are binary searched
+            const uint64_t low = value & _lowMask;
+            size_t first = start - high;
+            size_t last = end - high;
+            while (first < last) {
+                const size_t middle = first + (last - first) / 2;
+                if (_lowBits.get(middle) < low) {
+                    first = middle + 1;
+                } else {
+                    last = middle;
+                }
+            }
+            if (first < (end - high)) {
+                found = (high << _numLowBits) | _lowBits.get(first);
+                return first;
+            }
+
+            //All the bucket values are smaller, the successor is the
+            //first value of the following non empty bucket, if any
+            if (first >= _size) {
+                return _size;
+            }
+            wordIdx = end >> 6;
+            word = _highBits[wordIdx] & (~uint64_t(0) << (end & 63));
+            while (word == 0) {
+                word = _highBits[++wordIdx];
+            }
+            const size_t pos = (wordIdx << 6) + __builtin_ctzll(word);
+            found = (uint64_t(pos - first) << _numLowBits) | _lowBits.get(first);
+            return first;
+        }
+
+        /**
+         * Allows to get the number of values
+         * @return the number of values
+         */
+        inline size_t size() const {
+            return _size;
+        }
+
+        /**
+         * Allows to get the number of bytes used by the sequence
+         * @return the number of bytes
+         */
+        inline size_t getBytes() const {
+            return _lowBits.getBytes() + memory::getVectorBytes(_highBits)
+                    + memory::getVectorBytes(_onesSamples) + memory::getVectorBytes(_zerosSamples)
+                    + memory::getVectorBytes(_blockOnes);
+        }
+
+    private:
+        //The number of values
+        size_t _size;
+        //The number of the low bits per value
+        uint8_t _numLowBits;
+        //The mask of the low bits
+        uint64_t _lowMask;
+        //The high bits of the largest value
+        uint64_t _maxHigh;
+        //The low bits of the values
+        BitPackedArray _lowBits;
+        //The high bits of the values in unary, there is one extra zero at the end
+        TBitWords _highBits;
+        //The positions of every ELIAS_FANO_SELECT_SAMPLE-th one of the high bits
+        TBitWords _onesSamples;
+        //The positions of every ELIAS_FANO_SELECT_SAMPLE-th zero of the high bits
+        TBitWords _zerosSamples;
+        //The numbers of the ones before the rank blocks of the high bits
+        TBitWords _blockOnes;
+
+        /**
+         * Finds the position of the one of the given rank in the high bits
+         * @param rank the rank of the one, i.e. the index of the value
+         * @return the bit position
+         */
+        inline size_t select1(const size_t rank) const {
+            //Find the last block with at most rank ones before it, between the samples
+            const size_t sample = rank / ELIAS_FANO_SELECT_SAMPLE;
+            size_t first = _onesSamples[sample] / BLOCK_BITS;
+            size_t last = ((sample + 1) < _onesSamples.size()) ? (_onesSamples[sample + 1] / BLOCK_BITS) : (_blockOnes.size() - 1);
+            while (first < last) {
+                const size_t middle = last - (last - first) / 2;
+                if (_blockOnes[middle] <= rank) {
+                    first = middle;
+                } else {
+                    last = middle - 1;
+                }
+            }
+
+            //Scan the block
+            size_t left = rank - _blockOnes[first];
+            size_t wordIdx = first * ELIAS_FANO_RANK_BLOCK_WORDS;
+            uint64_t word = _highBits[wordIdx];
+            size_t count = __builtin_popcountll(word);
+            while (left >= count) {
+                left -= count;
+                word = _highBits[++wordIdx];
+                count = __builtin_popcountll(word);
+            }
+            return (wordIdx << 6) + selectInWord(word, left);
+        }
+
+        /**
+         * Finds the position of the zero of the given rank in the high bits
+         * @param rank the rank of the zero, i.e. the high bits of a bucket
+         * @return the bit position
+         */
+        inline size_t select0(const size_t rank) const {
+            //Find the last block with at most rank zeros before it, between the samples
+            const size_t sample = rank / ELIAS_FANO_SELECT_SAMPLE;
+            size_t first = _zerosSamples[sample] / BLOCK_BITS;
+            size_t last = ((sample + 1) < _zerosSamples.size()) ? (_zerosSamples[sample + 1] / BLOCK_BITS) : (_blockOnes.size() - 1);
+            while (first < last) {
+                const size_t middle = last - (last - first) / 2;
+                if ((middle * BLOCK_BITS - _blockOnes[middle]) <= rank) {
+                    first = middle;
+                } else {
+                    last = middle - 1;
+                }
+            }
+
+            //Scan the block
+            size_t left = rank - (first * BLOCK_BITS - _blockOnes[first]);
+            size_t wordIdx = first * ELIAS_FANO_RANK_BLOCK_WORDS;
+            uint64_t word = ~_highBits[wordIdx];
+            size_t count = __builtin_popcountll(word);
+            while (left >= count) {
+                left -= count;
+                word = ~_highBits[++wordIdx];
+                count = __builtin_popcountll(word);
+            }
+            return (wordIdx << 6) + selectInWord(word, left);
+        }
+    };
+
+    /**
+     * This is the table of the values stored by their ranks: the distinct
+     * values are stored once, ordered by the decreasing number of their
+     * occurrences, and every value is stored as the bit packed index, the
+     * rank, into them. The N-gram frequencies have few distinct values, most
+     * of which are small, so the ranks take just a few bits.
+     * @param TValue the value type
+     */
+    template<typename TValue>
+    class RankedValueTable {
+    public:
+
+        /**
+         * Ranks and stores the given values, replacing the current ones
+         * @param size the number of values
+         * @param getValue the function giving the value of the given index
+         */
+        void build(const size_t size, const function<TValue(const size_t)> & getValue) {
+            //Count the distinct values and order them by the number of occurrences
+            unordered_map<TValue, uint64_t> ranks;
+            for (size_t idx = 0; idx < size; idx++) {
+                ranks[getValue(idx)]++;
+            }
+            vector< pair<uint64_t, TValue> > counts;
+            counts.reserve(ranks.size());
+            for (auto it = ranks.begin(); it != ranks.end(); ++it) {
+                counts.push_back(make_pair(it->second, it->first));
+            }
+            sort(counts.begin(), counts.end(), [] (const pair<uint64_t, TValue> & first, const pair<uint64_t, TValue> & second) {
+                return (first.first > second.first) || ((first.first == second.first) && (first.second < second.second));
+            });
+
+            _values.clear();
+            _values.reserve(counts.size());
+            for (auto it = counts.begin(); it != counts.end(); ++it) {
+                ranks[it->second] = _values.size();
+                _values.push_back(it->second);
+            }
+            _values.shrink_to_fit();
+
+            _ranks.reset(getBitWidth(_values.empty() ? 0 : (_values.size() - 1)), size);
+            for (size_t idx = 0; idx < size; idx++) {
+                _ranks.set(idx, ranks[getValue(idx)]);
+            }
+        }
+
+        /**
+         * Gets the value with the given index
+         * @param idx the value index
+         * @return the value
+         */
+        inline TValue get(const size_t idx) const {
+            return _values[_ranks.get(idx)];
+        }
+
+        /**
+         * Allows to get the number of distinct values
+         * @return the number of distinct values
+         */
+        inline size_t getNumDistinct() const {
+            return _values.size();
+        }
+
+        /**
+         * Allows to get the number of bytes used by the table
+         * @return the number of bytes
+         */
+        inline size_t getBytes() const {
+            return memory::getVectorBytes(_values) + _ranks.getBytes();
+        }
+
+    private:
+        //The distinct values ordered by the decreasing number of occurrences
+        vector<TValue> _values;
+        //The ranks of the values
+        BitPackedArray _ranks;
+    };
+}
+
+#endif	/* ELIASFANO_HPP */
+
@@ -0,0 +1,359 @@
+/* 
+ * File:   EliasFanoTrie.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 09:05 PM
+ */
+
+#ifndef ELIASFANOTRIE_HPP
+#define	ELIASFANOTRIE_HPP
+
+#include <vector>       // std::vector
+#include <string>       // std::string
+#include <limits>       // std::numeric_limits
+#include <algorithm>    // std::lower_bound, std::fill
+
+#include "ATrie.hpp"
+#include "HashMapTrie.hpp"
+#include "EliasFano.hpp"
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * This is the read only trie of the N-gram counts compressed with Elias-Fano:
+     *      "Efficient Data Structures for Massive N-Gram Datasets"
+     *      Giulio Ermanno Pibiri, Rossano Venturini, SIGIR 2017
+     * 
+     * The trie is filled in as a HashMapTrie, which is then converted by compact:
+     *   1. The dictionary: the words are sorted by their hashes and their index is
+     *      their id, a word is found by a binary search of its hash. The words'
+     *      text is kept for the verification of the hashes and for the visitors;
+     *   2. The levels 2 to N: an N-gram is the pair of the id of its last word
+     *      and the id of its preceding words' context, as in HashMapTrie. The pairs
+     *      are sorted and stored as one Elias-Fano sequence of w * K + c, where K
+     *      is the number of the contexts. The index of the pair in the sequence is
+     *      the N-gram's id, i.e. the context id of its extensions. An N-gram is
+     *      found by one successor search, @see EliasFanoSequence::nextGEQ;
+     *   3. The frequencies of every level are stored by their ranks among the
+     *      level's distinct frequencies, @see RankedValueTable.
+     * Once compacted the trie can not be changed, the word queries, the
+     * probabilities and the continuations are not supported.
+     * @param N the maximum level of the considered N-gram, i.e. the N value
+     * @param doCache the indicative flag to cache the queries, is not used
+     */
+    template<TTrieSize N, bool doCache>
+    class EliasFanoTrie final : public ATrie<N, doCache> {
+    public:
+        //The trie the N-grams are counted in before they are compressed
+        typedef HashMapTrie<N, doCache> TMemTrie;
+        //The trie is its own only partition
+        typedef EliasFanoTrie TPartition;
+
+        /**
+         * The basic constructor
+         */
+        EliasFanoTrie();
+
+        /**
+         * For more details @see ATrie
+         * @throws Exception in case the trie is compacted
+         */
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) {
+            getMemTrie().addWords(tokens, hashes);
+        }
+
+        /**
+         * For more details @see ATrie
+         * @throws Exception in case the trie is compacted
+         */
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int idx, const int n) {
+            getMemTrie().addNGram(tokens, hashes, idx, n);
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception) {
+            getMemTrie().addNGramFreq(ngram, hashes, freq);
+        }
+
+        /**
+         * Returns the trie itself, as its concrete type
+         * For more details @see ATrie
+         */
+        virtual EliasFanoTrie & getPartition(const size_t idx) {
+            return *this;
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void resetQueryCache() {
+            if (_memTrie != NULL) {
+                _memTrie->resetQueryCache();
+            }
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual SFrequencyResult<N> & queryWordFreqs(const string & word) throw (Exception);
+
+        /**
+         * The N-grams are looked up in the same order as in HashMapTrie, the
+         * contexts of the longer N-grams are found level by level.
+         * For more details @see ATrie
+         */
+        virtual void queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs) {
+            if (_memTrie != NULL) {
+                _memTrie->queryNGramFreqs(ngram, hashes, freqs);
+                return;
+            }
+
+            //First just clean the array
+            fill(freqs.result, freqs.result + N, 0);
+
+            //Get the ids of the N-gram words
+            TWordId wordIds[N];
+            for (TTrieSize idx = 0; idx < N; idx++) {
+                wordIds[idx] = getWordId(ngram[idx], hashes[idx]);
+            }
+
+            //Get the last 1-gram's word frequency
+            const TWordId endWordId = wordIds[N - 1];
+            if (endWordId == UNKNOWN_WORD) {
+                return;
+            }
+            freqs.result[N - 1] = _wordFreqs.get(endWordId);
+
+            //Now get the frequencies of all longer N-grams with N >= 2,
+            //the first missing N-gram means that the longer ones are missing too
+            for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+                //Find the context of the L-gram words preceding the end word,
+                //the context of the first word is the word id itself
+                const TTrieSize startIdx = N - L;
+                if (wordIds[startIdx] == UNKNOWN_WORD) {
+                    return;
+                }
+                size_t context = wordIds[startIdx];
+                for (TTrieSize idx = startIdx + 1; idx < (N - 1); idx++) {
+                    context = findNGram(idx - startIdx + 1, wordIds[idx], context);
+                    if (context == UNKNOWN_NGRAM) {
+                        return;
+                    }
+                }
+
+                //Get the L-gram's frequency
+                const size_t id = findNGram(L, endWordId, context);
+                if (id == UNKNOWN_NGRAM) {
+                    return;
+                }
+                freqs.result[startIdx] = _levels[L - MINIMUM_CONTEXT_LEVEL].freqs.get(id);
+            }
+        }
+
+        /**
+         * Compresses the counted N-grams and releases the HashMapTrie they are
+         * counted in, the trie can not be changed after that.
+         * For more details @see ATrie
+         */
+        virtual void compact() throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual size_t getNumNGrams(const TTrieSize L) const throw (Exception) {
+            if (_memTrie != NULL) {
+                return _memTrie->getNumNGrams(L);
+            }
+            return (L == 1) ? _wordHashes.size() : _levels[L - MINIMUM_CONTEXT_LEVEL].keys.size();
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception) {
+            visitNGramsChunk(L, 0, 1, visitor);
+        }
+
+        /**
+         * The chunks are the equal ranges of the N-gram ids
+         * For more details @see ATrie
+         */
+        virtual void visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                      const TNGramVisitor & visitor) const throw (Exception);
+
+        /**
+         * The Elias-Fano sequences and the ranked frequencies are the entries,
+         * the words' text is the strings.
+         * For more details @see ATrie
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception);
+
+        virtual ~EliasFanoTrie();
+
+    private:
+        //Stores the minimum context level
+        static const TTrieSize MINIMUM_CONTEXT_LEVEL;
+
+        //The value of the missing word id
+        static const TWordId UNKNOWN_WORD;
+
+        //The value of the missing N-gram id
+        static const size_t UNKNOWN_NGRAM;
+
+        //The compressed N-gram level
+        typedef struct {
+            //The number of the contexts K, the keys of the pairs are w * K + c
+            uint64_t numContexts;
+            //The sorted keys of the word and context pairs
+            EliasFanoSequence keys;
+            //The frequencies of the N-grams, in the order of the keys
+            RankedValueTable<TFrequencySize> freqs;
+        } SLevel;
+
+        //The trie the N-grams are counted in, is NULL once the trie is compacted
+        TMemTrie * _memTrie;
+
+        //The sorted hashes of the words, indexed by the word ids
+        vector<TWordHashSize, memory::LargeTableAllocator<TWordHashSize> > _wordHashes;
+
+        //The text of the concatenated words, in the order of the word ids
+        vector<char> _wordChars;
+
+        //The offsets of the words' text, there is one extra offset
+        EliasFanoSequence _wordOffsets;
+
+        //The frequencies of the words, in the order of the word ids
+        RankedValueTable<TFrequencySize> _wordFreqs;
+
+        //The compressed levels for n>=2 and <= N
+        SLevel _levels[N - 1];
+
+        /**
+         * The copy constructor, is made private as we do not intend to copy this class objects
+         * @param orig the object to copy
+         */
+        EliasFanoTrie(const EliasFanoTrie & orig);
+
+        /**
+         * Allows to get the trie the N-grams are counted in
+         * @return the trie the N-grams are counted in
+         * @throws Exception in case the trie is compacted
+         */
+        inline TMemTrie & getMemTrie() const throw (Exception) {
+            if (_memTrie == NULL) {
+                throw Exception("The Elias-Fano trie can not be changed once it is compacted!");
+            }
+            return *_memTrie;
+        }
+
+        /**
+         * Gets the word with the given id
+         * @param wordId the word id
+         * @return the word
+         */
+        inline string getWord(const TWordId wordId) const {
+            const size_t begin = _wordOffsets.access(wordId);
+            return string(_wordChars.data() + begin, _wordOffsets.access(wordId + 1) - begin);
+        }
+
+        /**
+         * Gets the id of the given word
+         * @param word the word to look for
+         * @param hash the word's hash
+         * @return the word id or UNKNOWN_WORD if the word is not known
+         */
+        inline TWordId getWordId(const string & word, const TWordHashSize hash) const {
+            auto found = lower_bound(_wordHashes.begin(), _wordHashes.end(), hash);
+            if ((found == _wordHashes.end()) || (*found != hash)) {
+                return UNKNOWN_WORD;
+            }
+            TWordId wordId = found - _wordHashes.begin();
+#if HASH_VERIFICATION_MODE
+            //The colliding words, if any, have the same hash and are stored next to each other
+            while (true) {
+                const size_t begin = _wordOffsets.access(wordId);
+                if (!word.compare(0, string::npos, _wordChars.data() + begin, _wordOffsets.access(wordId + 1) - begin)) {
+                    break;
+                }
+                wordId++;
+                if ((wordId == _wordHashes.size()) || (_wordHashes[wordId] != hash)) {
+                    return UNKNOWN_WORD;
+                }
+            }
+#endif
+            return wordId;
+        }
+
+        /**
+         * Looks up the N-gram of the given level
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the N-gram id or UNKNOWN_NGRAM if there is no such N-gram
+         */
+        inline size_t findNGram(const TTrieSize L, const TWordId wordId, const size_t context) const {
+            if (wordId == UNKNOWN_WORD) {
+                return UNKNOWN_NGRAM;
+            }
+            const SLevel & level = _levels[L - MINIMUM_CONTEXT_LEVEL];
+            const uint64_t key = wordId * level.numContexts + context;
+            uint64_t found = 0;
+            const size_t id = level.keys.nextGEQ(key, found);
+            return ((id < level.keys.size()) && (found == key)) ? id : UNKNOWN_NGRAM;
+        }
+
+        /**
+         * Builds the dictionary from the words of the counting trie
+         * @param wordIds the out parameter for the word ids indexed by the counting trie's word ids
+         */
+        void buildDictionary(vector<TContextId> & wordIds);
+
+        /**
+         * Builds the compressed level from the entries of the counting trie
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordIds the word ids indexed by the counting trie's word ids
+         * @param contextIds the ids of the level L-1 N-grams indexed by their
+         *                   counting trie's ids, for L = 2 these are the word ids
+         * @param ngramIds the out parameter for the ids of the level's N-grams
+         *                 indexed by their counting trie's ids
+         */
+        void buildLevel(const TTrieSize L, const vector<TContextId> & wordIds,
+                        const vector<TContextId> & contextIds, vector<TContextId> & ngramIds);
+    };
+
+    typedef EliasFanoTrie<N_GRAM_PARAM, true> TFiveCacheEliasFanoTrie;
+    typedef EliasFanoTrie<N_GRAM_PARAM, false> TFiveNoCacheEliasFanoTrie;
+}
+
+#endif	/* ELIASFANOTRIE_HPP */
+
@@ -0,0 +1,250 @@
+/* 
+ * File:   FlatHashMap.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:20 PM
+ */
+
+#ifndef FLATHASHMAP_HPP
+#define	FLATHASHMAP_HPP
+
+#include <stdint.h>       // uint32_t, uint64_t
+#include <cstddef>        // size_t
+
+#include "MemoryUtils.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    //The initial number of the flat map slots, must be a power of two
+    #define FLAT_MAP_INITIAL_CAPACITY 4
+    //The maximum load factor of the flat map, as the numerator and the denominator
+    #define FLAT_MAP_MAX_LOAD_NUM 3
+    #define FLAT_MAP_MAX_LOAD_DEN 4
+    //The Fibonacci hashing multiplier spreading the sequential keys over the slots
+    #define FLAT_MAP_HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+
+    /**
+     * This is a flat, open addressing, hash map with linear probing. The key/value
+     * pairs are stored in one array of slots so that a lookup touches one or two
+     * cache lines and there is no per-pair heap allocation. It has the interface
+     * of the AdaptiveMap so that the maps are interchangeable in the tries.
+     * Note: The keys must be integers, the zero key marks the empty slots so the
+     * value of the zero key is stored separately. The values must be trivially
+     * copyable, e.g. integers and PODs. The value of a new key is value initialized.
+     * Note: The value references are invalidated by inserting new keys.
+     * @param TKey the integer key type
+     * @param TValue the value type
+     */
+    template<typename TKey, typename TValue>
+    class FlatHashMap {
+    public:
+
+        /**
+         * The basic constructor, creates an empty map
+         */
+        FlatHashMap() : _slots(NULL), _capacity(0), _size(0), _hasZeroKey(false), _zeroValue() {
+        }
+
+        /**
+         * The move constructor, needed for storing the maps in vectors
+         * @param other the map to move from
+         */
+        FlatHashMap(FlatHashMap && other) noexcept : _slots(other._slots), _capacity(other._capacity),
+        _size(other._size), _hasZeroKey(other._hasZeroKey), _zeroValue(other._zeroValue) {
+            other._slots = NULL;
+            other._capacity = 0;
+            other._size = 0;
+            other._hasZeroKey = false;
+        }
+
+        /**
+         * The move assignment operator
+         * @param other the map to move from
+         * @return this map
+         */
+        FlatHashMap & operator=(FlatHashMap && other) noexcept {
+            if (this != &other) {
+                delete[] _slots;
+                _slots = other._slots;
+                _capacity = other._capacity;
+                _size = other._size;
+                _hasZeroKey = other._hasZeroKey;
+                _zeroValue = other._zeroValue;
+                other._slots = NULL;
+                other._capacity = 0;
+                other._size = 0;
+                other._hasZeroKey = false;
+            }
+            return *this;
+        }
+
+        /**
+         * Gets the value of the given key, inserts a new value initialized value if needed
+         * @param key the key to look for
+         * @return the reference to the value
+         */
+        inline TValue & operator[](const TKey & key) {
+            if (key == TKey()) {
+                if (!_hasZeroKey) {
+                    _hasZeroKey = true;
+                    _zeroValue = TValue();
+                }
+                return _zeroValue;
+            }
+            if ((_size + 1) * FLAT_MAP_MAX_LOAD_DEN > _capacity * FLAT_MAP_MAX_LOAD_NUM) {
+                grow();
+            }
+            SSlot & slot = _slots[findSlot(key)];
+            if (slot.key == TKey()) {
+                slot.key = key;
+                slot.value = TValue();
+                _size++;
+            }
+            return slot.value;
+        }
+
+        /**
+         * Looks up the value of the given key
+         * @param key the key to look for
+         * @return the pointer to the value or NULL if the key is not present
+         */
+        inline const TValue * find(const TKey & key) const {
+            if (key == TKey()) {
+                return _hasZeroKey ? &_zeroValue : NULL;
+            }
+            if (_capacity == 0) {
+                return NULL;
+            }
+            const SSlot & slot = _slots[findSlot(key)];
+            return (slot.key == key) ? &slot.value : NULL;
+        }
+
+        /**
+         * Allows to get the number of stored pairs
+         * @return the number of stored pairs
+         */
+        inline size_t size() const {
+            return _size + (_hasZeroKey ? 1 : 0);
+        }
+
+        /**
+         * Calls the given function for all the stored pairs, in no particular order
+         * @param func the function to call with the key and the value as arguments
+         */
+        template<typename TFunction>
+        inline void forEach(TFunction func) const {
+            if (_hasZeroKey) {
+                func(TKey(), _zeroValue);
+            }
+            for (uint32_t idx = 0; idx < _capacity; idx++) {
+                if (_slots[idx].key != TKey()) {
+                    func(_slots[idx].key, _slots[idx].value);
+                }
+            }
+        }
+
+        /**
+         * Adds up the heap memory used by the map, not including the map object
+         * itself. The empty slots and the heap block overhead are counted as buckets.
+         * @param entries the bytes of the key/value pairs
+         * @param buckets the bytes of the empty slots
+         * @param nodes the bytes of the node overhead, there are no nodes
+         */
+        inline void addHeapBytes(size_t & entries, size_t & buckets, size_t & nodes) const {
+            const size_t arrayBytes = _capacity * sizeof (SSlot);
+            entries += _size * sizeof (SSlot);
+            buckets += memory::getHeapBlockBytes(arrayBytes) - _size * sizeof (SSlot);
+        }
+
+        /**
+         * Removes all the pairs from the map and releases the slots
+         */
+        void clear() {
+            delete[] _slots;
+            _slots = NULL;
+            _capacity = 0;
+            _size = 0;
+            _hasZeroKey = false;
+        }
+
+        ~FlatHashMap() {
+            delete[] _slots;
+        }
+
+    private:
+
+        //The slot storing a key/value pair, the zero key means the slot is empty
+        typedef struct {
+            TKey key;
+            TValue value;
+        } SSlot;
+
+        //The slots array
+        SSlot * _slots;
+        //The number of slots, a power of two
+        uint32_t _capacity;
+        //The number of used slots
+        uint32_t _size;
+        //True if the zero key is present
+        bool _hasZeroKey;
+        //The value of the zero key
+        TValue _zeroValue;
+
+        //The copy constructor and assignment are made private as we do not intend to copy maps
+        FlatHashMap(const FlatHashMap & other);
+        FlatHashMap & operator=(const FlatHashMap & other);
+
+        /**
+         * Finds the slot of the given non zero key, or the empty slot to put it into
+         * @param key the key to look for
+         * @return the slot index
+         */
+        inline uint32_t findSlot(const TKey & key) const {
+            const uint32_t mask = _capacity - 1;
+            uint32_t idx = ((uint64_t) key * FLAT_MAP_HASH_MULTIPLIER) >> 32 & mask;
+            while ((_slots[idx].key != TKey()) && (_slots[idx].key != key)) {
+                idx = (idx + 1) & mask;
+            }
+            return idx;
+        }
+
+        /**
+         * Doubles the number of slots and re-inserts the stored pairs
+         */
+        void grow() {
+            SSlot * const oldSlots = _slots;
+            const uint32_t oldCapacity = _capacity;
+            _capacity = (oldCapacity == 0) ? FLAT_MAP_INITIAL_CAPACITY : (oldCapacity * 2);
+            _slots = new SSlot[_capacity]();
+            for (uint32_t idx = 0; idx < oldCapacity; idx++) {
+                if (oldSlots[idx].key != TKey()) {
+                    _slots[findSlot(oldSlots[idx].key)] = oldSlots[idx];
+                }
+            }
+            delete[] oldSlots;
+        }
+    };
+}
+
+#endif	/* FLATHASHMAP_HPP */
+
@@ -26,6 +26,8 @@
 #ifndef GLOBALS_HPP
 #define	GLOBALS_HPP
 
+#include <stdint.h> // uint32_t, uint64_t
+
 //This is the pattern used for file path separation
 #define PATH_SEPARATION_SYMBOLS "/\\"
 //This is a delimiter used in the text corpus and test files
@@ -38,12 +40,138 @@
 #define BYTES_ONE_MB 1024
 //The considered maximum length of the N-gram
 #define N_GRAM_PARAM 5u
+//The default number of shards in the sharded trie
+#define DEFAULT_NUMBER_OF_SHARDS 4
+//The number of text lines read at once when a partitioned trie is built in parallel
+#define TRIE_BUILD_BATCH_LINES 100000
+//The number of text lines read at once when a concurrent trie is built, the trie makes room for
+//every batch in advance so the smaller batches keep the unused room small
+#define CONCURRENT_BUILD_BATCH_LINES 10000
+//The default directory of the segmented trie's segment files
+#define DEFAULT_SEGMENT_DIR "/tmp"
+//The default maximum number of N-grams in the segmented trie's in-memory trie
+#define DEFAULT_SEGMENT_NGRAMS 1000000
+//The number of the segmented trie's segments that triggers a background merge
+#define SEGMENT_MERGE_FACTOR 4
 
 //The command line option values for debug levels
 #define INFO_PARAM_VALUE "info"
 #define DEBUG_PARAM_VALUE "debug"
 #define DEBUG_OPTION_VALUES "{" INFO_PARAM_VALUE ", " DEBUG_PARAM_VALUE "}"
 
+//The command line options for the trie type, the number of its shards and its segments
+#define TRIE_OPTION_PREFIX "--trie="
+#define SHARDS_OPTION_PREFIX "--shards="
+#define SEGMENT_DIR_OPTION_PREFIX "--segment-dir="
+#define SEGMENT_NGRAMS_OPTION_PREFIX "--segment-ngrams="
+#define HASH_MAP_TRIE_VALUE "hashmap"
+#define SHARDED_TRIE_VALUE "sharded"
+#define SEGMENTED_TRIE_VALUE "segmented"
+#define CONCURRENT_TRIE_VALUE "concurrent"
+#define ELIAS_FANO_TRIE_VALUE "eliasfano"
+#define TRIE_OPTION_VALUES "{" HASH_MAP_TRIE_VALUE ", " SHARDED_TRIE_VALUE ", " SEGMENTED_TRIE_VALUE ", " CONCURRENT_TRIE_VALUE ", " ELIAS_FANO_TRIE_VALUE "}"
+
+//The command line option for the smoothed probabilities computed after the trie is built
+#define SMOOTHING_OPTION_PREFIX "--smoothing="
+#define STUPID_BACKOFF_VALUE "stupid-backoff"
+#define KNESER_NEY_VALUE "kneser-ney"
+#define SMOOTHING_OPTION_VALUES "{" STUPID_BACKOFF_VALUE ", " KNESER_NEY_VALUE "}"
+
+//The command line option for the most frequent continuations of the test queries' contexts
+#define TOP_K_OPTION_PREFIX "--top-k="
+
+//The wildcard word of the N-gram patterns matching any word, @see ATrie::findNGrams,
+//and the command line option listing the stored N-grams matching a pattern
+#define NGRAM_PATTERN_WILDCARD "*"
+#define FIND_OPTION_PREFIX "--find="
+
+//The command line options for loading the trie from and saving it into an ARPA file
+#define LOAD_ARPA_OPTION "--load-arpa"
+#define SAVE_ARPA_OPTION_PREFIX "--save-arpa="
+
+//The command line options for loading and saving the trie counts, @see TrieSegment
+#define LOAD_COUNTS_OPTION_PREFIX "--load-counts="
+#define SAVE_COUNTS_OPTION_PREFIX "--save-counts="
+
+//The command line options for the multi-process build of the trie counts, @see ProcessBuilder:
+//the number of builder processes, the range counted by a builder process and the counts files merge
+#define PROCESSES_OPTION_PREFIX "--processes="
+#define BUILD_RANGE_OPTION_PREFIX "--build-range="
+#define MERGE_COUNTS_OPTION_PREFIX "--merge-counts="
+//The maximum number of attempts to count one range of the multi-process build
+#define BUILD_RANGE_ATTEMPTS 3
+
+//The command line option for the trie counts dump, @see TrieDumper
+#define DUMP_OPTION_PREFIX "--dump="
+//The maximum number of N-grams per dump chunk file, the chunk is sorted in memory
+#define DUMP_CHUNK_NGRAMS 1000000
+//The largest frequency with its own count-of-counts entry, the higher ones are counted together
+#define DUMP_COUNT_OF_COUNTS 10
+
+//The command line options for the pages and the NUMA placement of the large trie tables, @see LargePages.hpp
+#define HUGE_PAGES_OPTION_PREFIX "--huge-pages="
+#define REGULAR_PAGES_VALUE "none"
+#define TRANSPARENT_PAGES_VALUE "transparent"
+#define EXPLICIT_PAGES_VALUE "explicit"
+#define HUGE_PAGES_OPTION_VALUES "{" REGULAR_PAGES_VALUE ", " TRANSPARENT_PAGES_VALUE ", " EXPLICIT_PAGES_VALUE "}"
+#define NUMA_OPTION_PREFIX "--numa="
+#define LOCAL_NUMA_VALUE "local"
+#define INTERLEAVE_NUMA_VALUE "interleave"
+#define NUMA_OPTION_VALUES "{" LOCAL_NUMA_VALUE ", " INTERLEAVE_NUMA_VALUE "}"
+
+//The hot region size of every compacted trie level, the entries of the most frequent
+//words that fit into it are expected to stay in the L2/L3 caches, @see SHotRegionUsage
+#define HOT_REGION_BYTES (256u * 1024u)
+//The command line option reporting the hot region hit rates of the test queries
+#define HOT_STATS_OPTION "--hot-stats"
+
+//The command line option disabling the trie compaction after it is filled in
+#define NO_COMPACT_OPTION "--no-compact"
+
+//The command line options for the query server and its load generating client
+#define SERVE_OPTION_PREFIX "--serve="
+#define WORKERS_OPTION_PREFIX "--workers="
+#define CLIENT_OPTION_PREFIX "--client="
+#define CONNECTIONS_OPTION_PREFIX "--connections="
+#define REQUESTS_OPTION_PREFIX "--requests="
+#define BATCH_OPTION_PREFIX "--batch="
+#define DEFAULT_CLIENT_CONNECTIONS 4
+#define DEFAULT_CLIENT_REQUESTS 10000
+#define DEFAULT_CLIENT_BATCH_SIZE 64
+
+//The lookup benchmark option and the default number of in-flight lookups of the batched queries
+#define BENCH_LOOKUPS_OPTION "--bench-lookups"
+#define DEFAULT_LOOKUPS_IN_FLIGHT 8
+//The maximum number of the distinct N-grams looked up by the lookup benchmark and
+//the minimum number of the N-gram lookups done by the lookup benchmark per measurement
+#define BENCH_LOOKUPS_MAX_NGRAMS 200000
+#define BENCH_LOOKUPS_MIN_QUERIES 1000000
+//The maximum number of in-flight lookups measured by the lookup benchmark
+#define BENCH_LOOKUPS_MAX_IN_FLIGHT 64
+
+//The build benchmark option and the maximum number of the builder threads measured by it
+#define BENCH_BUILD_OPTION "--bench-build"
+#define BENCH_BUILD_MAX_THREADS 64
+
+//The hash verification mode: if enabled the tries compare the word string
+//stored per word hash with the looked up word, and reject false matches.
+//Can be disabled from the command line of the compiler with -DHASH_VERIFICATION_MODE=0
+#ifndef HASH_VERIFICATION_MODE
+#define HASH_VERIFICATION_MODE 1
+#endif
+
+//The trie policy combinations mode: if enabled all the combinations of the hash
+//and map policies of the HashMapTrie are instantiated and can be chosen from the
+//command line. Can be disabled from the command line of the compiler with
+//-DTRIE_POLICY_COMBINATIONS=0 for faster builds, then the defaults are used.
+#ifndef TRIE_POLICY_COMBINATIONS
+#define TRIE_POLICY_COMBINATIONS 1
+#endif
+
+//The hash and map policy options, @see TriePolicies.hpp
+#define HASH_OPTION_PREFIX "--hash="
+#define MAP_OPTION_PREFIX "--map="
+
 //The following type definitions are important for storing the Tries information
 namespace tries {
     //This typedef if used in the tries in order to specify the type of the N-gram level N
@@ -53,14 +181,35 @@ namespace tries {
     //WARNING: Do not use smaller size as I get overflows
     //for "unsigned short int" on a text large corpus!
     typedef unsigned int TFrequencySize;
+
+    //The word identifier type, the words get dense sequential ids
+    typedef uint32_t TWordId;
+
+    //The context identifier type, the N-grams of every level get dense
+    //sequential ids, the id of an N-gram is the context id of its extensions
+    typedef uint32_t TContextId;
+
+    //The undefined word and context id value, the valid ids start from one
+    #define UNDEFINED_WORD_ID 0
+    #define UNDEFINED_CONTEXT_ID 0
+
+    //The type of the stored log10 probabilities and back-off weights
+    typedef float TLogProbSize;
+
+    //The log10 probability used for the impossible events, as in the ARPA files
+    #define ZERO_LOG_PROB -99.0f
+
+    //The unknown word token of the ARPA files
+    #define UNKNOWN_WORD_STR "<unk>"
+
+    //The constant back-off weight of the stupid back-off smoothing
+    #define STUPID_BACKOFF_WEIGHT 0.4
 }
 
 //The following type definitions are important for creating hashes
 namespace hashing {
-    //This is the smallest size which I've tested and it works for the hash without collisions
-    typedef unsigned int TWordHashSize;
-    //This is the hash reference size which should be twice as long as the TWordHashSize
-    typedef unsigned long int TReferenceHashSize;
+    //The word hash is 64 bit, the 32 bit hashes are known to collide on large corpora
+    typedef uint64_t TWordHashSize;
 }
 
 #endif	/* GLOBALS_HPP */
@@ -37,11 +37,17 @@
  */
 #include <utility>        // std::pair, std::make_pair
 #include <unordered_map>  // std::unordered_map
+#include <sstream>        // std::stringstream
+#include <limits>         // std::numeric_limits
+#include <algorithm>      // std::fill
+#include <atomic>         // std::atomic
 
 #include "ATrie.hpp"
+#include "TriePolicies.hpp"
 #include "Globals.hpp"
 #include "HashingUtils.hpp"
 #include "Logger.hpp"
+#include "LargePages.hpp"
 
 #ifndef HASHMAPTRIE_HPP
 #define	HASHMAPTRIE_HPP
@@ -53,7 +59,12 @@ namespace tries {
    
     /**
      * This is a HashMpa based ITrie interface implementation class.
-     * Note 1: This implementation uses the unsigned long for the hashes it is not optimal
+     * Note 1: This implementation uses 64 bit hashes for words only, the words and
+     *         the N-grams of each level get dense sequential 32 bit ids. An N-gram is
+     *         stored under the id of its last word and the id of its preceding words'
+     *         context, its own id is then the context id of its extensions. This is
+     *         the context offsets encoding of Pauls & Klein. The hash collisions of
+     *         words are handled by the hash verification mode.
      * Note 2: the unordered_map might be not as efficient as a hash_map with respect to memory usage but it is supposed to be faster
      * 
      * This implementation is chosen because it resembles the ordered array implementation from:
@@ -69,10 +80,22 @@ namespace tries {
      *       17. listopadu 15, 708 33, Ostrava-Poruba, Czech Republic
      *       {daniel.robenek.st, jan.platos, vaclav.snasel}@vsb.cz
      * 
+     * The word hash function and the map types are the policy template parameters,
+     * @see TriePolicies.hpp, so that the alternatives can be measured on a corpus.
+     * @param N - the maximum level of the considered N-gram, i.e. the N value
+     * @param doCache - the indicative flag to cache the queries
+     * @param THashPolicy - the hash policy giving the dictionary keys of the words
+     * @param TMapPolicy - the map policy giving the dictionary and the level map types
+     * 
+     * The class is final and the N-gram insertion and lookup methods are defined
+     * in the header. The builders and the query loops instantiated on this trie
+     * type call them directly so that the compiler can inline them.
      */
-    template<TTrieSize N, bool doCache>
-    class HashMapTrie : public ATrie<N, doCache> {
+    template<TTrieSize N, bool doCache, typename THashPolicy = MurmurHashPolicy, typename TMapPolicy = AdaptiveMapPolicy>
+    class HashMapTrie final : public ATrie<N, doCache> {
     public:
+        //The trie is its own only partition
+        typedef HashMapTrie TPartition;
 
         /**
          * The basic class constructor
@@ -82,14 +105,73 @@ namespace tries {
         /**
          * Does not re-set the internal query cache
          * For more details @see ITrie
+         * @throws Exception in case the trie is compacted
          */
-        virtual void addWords(vector<string> &tokens);
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) {
+            checkNotCompact();
+
+            //Add the words to the trie and update frequencies;
+            for (size_t idx = 0; idx < tokens.size(); idx++) {
+                //Insert a new or get an existing entry
+                const TWordId wordId = getOrCreateWordId(tokens[idx], hashes[idx]);
+                if (wordId != UNDEFINED_WORD_ID) {
+                    //Update/increase the frequency
+                    SWordEntry & entry = wordsById[wordId];
+                    entry.freq++;
+                    LOG_DEBUG << "freq( " << wordId << " ) = " << entry.freq << END_LOG;
+                }
+            }
+        }
 
         /**
          * Does not re-set the internal query cache
          * For more details @see ITrie
+         * @throws Exception in case the trie is compacted
+         */
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int base_idx, const int n) {
+            checkNotCompact();
+
+            if (Logger::ReportingLevel() >= Logger::DEBUG) {
+                printDebugNGram(tokens, base_idx, n);
+            }
+
+            //The context of the first word is the word id itself
+            TContextId context = getOrCreateWordId(tokens[base_idx], hashes[base_idx]);
+            if (context == UNDEFINED_CONTEXT_ID) {
+                return;
+            }
+
+            //Put the N-grams into the trie with N >= 2, the prefixes of the N-gram
+            //get the zero frequency entries, their ids are the next level contexts
+            for (int idx = 1; idx < n; idx++) {
+                const TWordId wordId = getOrCreateWordId(tokens[base_idx + idx], hashes[base_idx + idx]);
+                if (wordId == UNDEFINED_WORD_ID) {
+                    return;
+                }
+
+                //Get/Create the entry for this word and context in the Trie level of the N-gram
+                SNGramEntry & entry = getOrCreateEntry(idx + 1, wordId, context);
+
+                //If this is the end of this N-gram
+                if (idx == n - 1) {
+                    //Increase the frequency of the N-gram
+                    entry.freq++;
+                    LOG_DEBUG << n << "-gram: freq( " << wordId << ", " << context << " ) = " << entry.freq << END_LOG;
+                } else {
+                    //Otherwise the N-gram's prefix id is the next context
+                    LOG_DEBUG << n << "-gram: Cn( " << wordId << ", " << context << " ) = " << entry.id << END_LOG;
+                    context = entry.id;
+                }
+            }
+        }
+
+        /**
+         * Returns the trie itself, as its concrete type
+         * For more details @see ITrie
          */
-        virtual void addNGram(vector<string> &tokens, const int idx, const int n );
+        virtual HashMapTrie & getPartition(const size_t idx) {
+            return *this;
+        }
 
         /**
          * Does re-set the internal query cache
@@ -114,31 +196,414 @@ namespace tries {
         /**
          * For more details @see ITrie
          */
-        virtual void queryNGramFreqs( const vector<string> & ngram, SFrequencyResult<N> & freqs );
-        
+        virtual void queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs) {
+            //First just clean the array
+            fill(freqs.result, freqs.result + N, 0);
+
+            //Get the ids of the N-gram words, the unknown words get the undefined id
+            TWordId wordIds[N];
+            for (TTrieSize idx = 0; idx < N; idx++) {
+                wordIds[idx] = getWordId(ngram[idx], hashes[idx]);
+            }
+
+            //Get the last 1-gram's word frequency
+            const TWordId endWordId = wordIds[N - 1];
+            if (endWordId == UNDEFINED_WORD_ID) {
+                return;
+            }
+            freqs.result[N - 1] = wordsById[endWordId].freq;
+            LOG_DEBUG << ">> End word id: " << endWordId << END_LOG;
+
+            //Now compute the frequencies of all longer N-grams with N >= 2,
+            //the first missing N-gram means that the longer ones are missing too
+            for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+                //Compute the context of the L-gram words preceding the end word,
+                //the context of the first word is the word id itself
+                const TTrieSize startIdx = N - L;
+                TContextId context = wordIds[startIdx];
+                for (TTrieSize idx = startIdx + 1; idx < (N - 1); idx++) {
+                    const SNGramEntry * prefix = findEntry(idx - startIdx + 1, wordIds[idx], context);
+                    if (prefix == NULL) {
+                        LOG_DEBUG << "-- The level " << L << " context is not found" << END_LOG;
+                        return;
+                    }
+                    context = prefix->id;
+                }
+
+                LOG_DEBUG << "-- The level " << L << " context is " << context << END_LOG;
+
+                //Get the L-gram's frequency
+                const SNGramEntry * entry = findEntry(L, endWordId, context);
+                if (entry == NULL) {
+                    LOG_DEBUG << "-- The level " << L << " entry is not found" << END_LOG;
+                    return;
+                }
+                freqs.result[startIdx] = entry->freq;
+
+                LOG_DEBUG << "-- The level " << L << " frequency " << freqs.result[startIdx] << " is found and stored at index " << startIdx << END_LOG;
+            }
+        }
+
+        /**
+         * Interleaves the lookups of up to numInFlight N-grams. Every lookup is a
+         * state machine doing one dependent memory access per step and prefetching
+         * the entry of its next step, then the next lookup makes its step. This way
+         * the cache misses of the different lookups overlap instead of stalling.
+         * For more details @see ATrie
+         */
+        virtual void queryNGramFreqsBatch(const vector<string> & words, const vector<TWordHashSize> & hashes,
+                                          vector< SFrequencyResult<N> > & freqs,
+                                          const size_t numInFlight = DEFAULT_LOOKUPS_IN_FLIGHT);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void queryNextWord(SQueryState<N> & state, const string & word, const TWordHashSize hash,
+                                   SFrequencyResult<N> & freqs) throw (Exception);
+
+        /**
+         * Queries the sentence word by word, @see queryNextWord
+         * For more details @see ATrie
+         */
+        virtual void scoreSentence(const vector<string> & tokens, const vector<TWordHashSize> & hashes,
+                                   vector< SFrequencyResult<N> > & freqs);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void computeProbs(const ESmoothing smoothing) throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual bool hasProbs() const {
+            return !probs[0].empty();
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void queryNGramProbs(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                     SProbabilityResult<N> & result) throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void addNGramProb(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TLogProbSize prob, const TLogProbSize backoff) throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         * @throws Exception in case the trie is compacted
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception);
+
+        /**
+         * Rewrites the level maps into the sorted flat arrays, @see SCompactLevel,
+         * and releases the maps. The word ids are re-assigned in the decreasing
+         * order of the word frequencies, so the level pairs of the most frequent
+         * words come first and make up the levels' hot regions, @see SHotRegionUsage.
+         * The N-gram ids are not changed.
+         * For more details @see ATrie
+         */
+        virtual void compact() throw (Exception);
+
+        /**
+         * The unknown word 1-gram is counted if the probabilities are computed
+         * For more details @see ATrie
+         */
+        virtual size_t getNumNGrams(const TTrieSize L) const throw (Exception) {
+            if (L == 1) {
+                return (wordsById.size() - 1) + (isUnknownWordVirtual() ? 1 : 0);
+            }
+            return contexts[L - MINIMUM_CONTEXT_LEVEL].size() - 1;
+        }
+
+        /**
+         * Allows to get the number of the N-grams with a non zero frequency, unlike
+         * getNumNGrams it does not count the context entries that were only created
+         * as the prefixes of the counted N-grams, e.g. by the ShardedTrie shards
+         * @param L the N-gram level, MINIMUM_CONTEXT_LEVEL <= L <= N
+         * @return the number of the counted N-grams
+         */
+        size_t getNumCountedNGrams(const TTrieSize L) const;
+
+        /**
+         * If the probabilities are computed and the unknown word is not stored then
+         * the unknown word 1-gram is visited too, so that its probability is exported
+         * For more details @see ATrie
+         */
+        virtual void visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception) {
+            visitNGramsChunk(L, 0, 1, visitor);
+        }
+
+        /**
+         * The chunks are the equal ranges of the N-gram ids, the virtual unknown
+         * word 1-gram is in the last chunk
+         * For more details @see ATrie
+         */
+        virtual void visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                      const TNGramVisitor & visitor) const throw (Exception);
+
+        /**
+         * Groups the N-grams of every level by their context, i.e. by the id
+         * of their prefix, and sorts every group once by the frequency. The
+         * index is also used by findNGrams for the patterns of known prefixes.
+         * For more details @see ATrie
+         */
+        virtual void buildContinuations() throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual bool hasContinuations() const {
+            return !continuations[0].offsets.empty();
+        }
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void topContinuations(const vector<string> & context, const vector<TWordHashSize> & hashes,
+                                      const size_t k, vector<TContinuation> & result) const throw (Exception);
+
+        /**
+         * The N-grams are found by one of the following ways, depending on the pattern:
+         *   1. If the last word is known then the level entries of the word are
+         *      scanned and their words are recovered from the contexts backwards;
+         *   2. If the first word is known and the continuation index is built then
+         *      the N-grams are enumerated forwards, from the first word through the
+         *      continuations of its prefixes, @see buildContinuations;
+         *   3. Otherwise all the N-grams of the level are scanned.
+         * For more details @see ATrie
+         */
+        virtual unique_ptr<ANGramCursor> findNGrams(const vector<string> & pattern, const vector<TWordHashSize> & hashes) const throw (Exception);
+
+        /**
+         * Computes the memory usage from the sizes and capacities of the
+         * containers, the heap block overheads are the ones of glibc malloc.
+         * For more details @see ATrie
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * The found words and the found N-gram entries of the compacted levels are
+         * counted, with the relaxed atomic counters. The hot regions are empty
+         * until the trie is compacted.
+         * For more details @see ATrie
+         */
+        virtual void setHotRegionCounting(const bool isCounting) throw (Exception);
+
+        /**
+         * For more details @see ATrie
+         */
+        virtual void getHotRegionStatistics(SHotRegionStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * This function dissolves the given N-gram context (for N>=2) into the
+         * id of its last word and the id of its sub-context: c(w_1 ... w_n) is
+         * defined by id(w_n) and c(w_1 ... w_(n-1))
+         * @param L the level of the context, i.e. the number of words in it, 2 <= L <= N
+         * @param context the given context to dissolve 
+         * @param subWord the id of the context's last word
+         * @param subContext the sub-context, a context of level L-1
+         */
+        inline void dessolveContext(const TTrieSize L, const TContextId context, TWordId &subWord, TContextId &subContext) const {
+            const SContextEntry & entry = contexts[L - MINIMUM_CONTEXT_LEVEL].at(context);
+            subWord = entry.word;
+            subContext = entry.context;
+        }
+
+        /**
+         * Calls the given function for all the stored words, in the order of their ids
+         * @param func the function to call with the word id, the word and its frequency
+         */
+        template<typename TFunction>
+        inline void forEachWord(TFunction func) const {
+            for (TWordId wordId = 1; wordId < wordsById.size(); wordId++) {
+                func(wordId, wordsById[wordId].word, wordsById[wordId].freq);
+            }
+        }
+
+        /**
+         * Calls the given function for all the N-gram entries of the given level,
+         * the prefix only N-grams with zero frequencies included, in no particular order
+         * @param L the N-gram level, 2 <= L <= N
+         * @param func the function to call with the id of the N-gram's last word,
+         *             the context id of its preceding words, its id and its frequency
+         */
+        template<typename TFunction>
+        inline void forEachEntry(const TTrieSize L, TFunction func) const {
+            if (isCompacted) {
+                const SCompactLevel & level = compactData[L - MINIMUM_CONTEXT_LEVEL];
+                for (TWordId wordId = 0; (wordId + 1) < level.offsets.size(); wordId++) {
+                    for (TContextId pos = level.offsets[wordId]; pos < level.offsets[wordId + 1]; pos++) {
+                        func(wordId, level.keys[pos], level.entries[pos].id, level.entries[pos].freq);
+                    }
+                }
+            } else {
+                const vector<TNTrieEntryPairsMap> & level = data[L - MINIMUM_CONTEXT_LEVEL];
+                for (TWordId wordId = 0; wordId < level.size(); wordId++) {
+                    level[wordId].forEach([&func, wordId] (const TContextId & context, const SNGramEntry & entry) {
+                        func(wordId, context, entry.id, entry.freq);
+                    });
+                }
+            }
+        }
+
         virtual ~HashMapTrie();
 
     private:
         //Stores the minimum context level
         static const TTrieSize MINIMUM_CONTEXT_LEVEL;
         
-        //A tuple storing a word and its frequency
-        typedef pair<string, TFrequencySize> TWordEntryPair;
+        //The word entry storing the word and its frequency
+        typedef struct {
+            //The word itself
+            string word;
+            //The word frequency
+            TFrequencySize freq;
+        } SWordEntry;
 
-        //The N-trie level entry tuple for a word
-        typedef unordered_map<TReferenceHashSize, TFrequencySize> TNTrieEntryPairsMap;
+        //The N-gram entry storing the frequency and the N-gram's context id
+        typedef struct {
+            //The N-gram frequency
+            TFrequencySize freq;
+            //The id of the N-gram on its level, i.e. its context id
+            TContextId id;
+        } SNGramEntry;
+
+        //The context entry storing the N-gram's last word and the context of the preceding words
+        typedef struct {
+            //The id of the last word
+            TWordId word;
+            //The context id of the preceding words
+            TContextId context;
+        } SContextEntry;
+
+        //The probability entry storing the N-gram's log10 probability and
+        //the log10 back-off weight of the N-gram as a context
+        typedef struct {
+            //The log10 probability
+            TLogProbSize prob;
+            //The log10 back-off weight
+            TLogProbSize backoff;
+        } SProbEntry;
+
+        //The N-trie level entry tuple for a word, maps the context ids to N-gram entries.
+        //Most of the words have just a few contexts so the map is adaptive by default.
+        typedef typename TMapPolicy::template TLevelMap<TContextId, SNGramEntry> TNTrieEntryPairsMap;
+
+        //The dictionary map type, maps the word keys to the word ids
+        typedef typename TMapPolicy::template TWordMap<TWordHashSize, TWordId> TWordMap;
         
+        //The vector of a large flat table, its pages follow the large table policies,
+        //@see memory::setLargeTablePolicy
+        template<typename TValue>
+        using TLargeVector = vector<TValue, memory::LargeTableAllocator<TValue> >;
+
+        //The compacted N-gram level, the level map pairs of every word are stored
+        //in the flat arrays sorted by the context ids. Is like a compressed sparse
+        //row matrix with the word ids as the rows and the context ids as the columns.
+        typedef struct {
+            //The offsets of the words' pairs indexed by the word id, the word w
+            //has the pairs [offsets[w], offsets[w + 1]), there is one extra offset
+            TLargeVector<TContextId> offsets;
+            //The context ids of the pairs, sorted per word in the increasing order
+            TLargeVector<TContextId> keys;
+            //The N-gram entries of the pairs, in the order of the keys
+            TLargeVector<SNGramEntry> entries;
+        } SCompactLevel;
+
+        //The continuation entry storing the following word and the N-gram frequency
+        typedef struct {
+            //The id of the following word
+            TWordId word;
+            //The frequency of the N-gram ending with the word
+            TFrequencySize freq;
+        } SContinuationEntry;
+
+        //The forward continuation index of an N-gram level, the N-grams are grouped
+        //by the id of their prefix, i.e. the context id of the preceding words, and
+        //every group is sorted by the decreasing frequency, @see buildContinuations.
+        //The prefix only N-grams have zero frequencies and come last in their groups.
+        typedef struct {
+            //The offsets of the contexts' continuations indexed by the context id,
+            //the context c has [offsets[c], offsets[c + 1]), there is one extra offset
+            TLargeVector<TContextId> offsets;
+            //The continuations, sorted per context by the decreasing frequency
+            TLargeVector<SContinuationEntry> entries;
+        } SContinuationLevel;
+
+        //The cursor over the N-grams matching a pattern, @see findNGrams
+        class NGramPatternCursor;
+
+        //The state of a batched N-gram lookup, @see queryNGramFreqsBatch. The
+        //steps are the same as of queryNGramFreqs: first the words are looked
+        //up, the last one first, then the N-gram levels are probed bottom up.
+        typedef struct {
+            //The index of the looked up N-gram in the batch
+            size_t ngramIdx;
+            //The ids of the N-gram words
+            TWordId wordIds[N];
+            //The number of words still to be looked up
+            TTrieSize numWords;
+            //The level L of the currently looked up L-gram
+            TTrieSize level;
+            //The index of the word to be probed next, the L-gram's last word if
+            //it is N-1 and a word of the L-gram's context otherwise
+            TTrieSize probeIdx;
+            //The context of the words preceding the word to be probed
+            TContextId context;
+        } SLookupState;
+
         //This is the cache entry type the first value is true if the caching 
         //of this result was done, the second contains the cached results.
         typedef pair<bool, SFrequencyResult<N>> TCacheEntry;
 
-        //The map storing the dictionary
-        unordered_map<TWordHashSize, TWordEntryPair> words;
+        //The map storing the dictionary, the words are looked up by their hash policy keys
+        TWordMap words;
+
+        //The dictionary entries indexed by the word ids
+        vector<SWordEntry> wordsById;
+
+        //The collision list, the ids of the words whose keys collide with the key of
+        //the word stored in the dictionary map, is only filled in the hash verification mode
+        unordered_map<TWordHashSize, vector<TWordId> > collidingWords;
+
+        //The arrays storing n-tires for n>=2 and <= N, indexed by the last word id
+        vector<TNTrieEntryPairsMap> data[N-1];
+
+        //The compacted levels for n>=2 and <= N, are used instead of the data maps once compacted
+        SCompactLevel compactData[N-1];
+
+        //The flag indicating that the trie is compacted, @see compact
+        bool isCompacted;
+
+        //The arrays storing the context entries for n>=2 and <= N, indexed by the context id
+        TLargeVector<SContextEntry> contexts[N-1];
+
+        //The forward continuation indexes for n>=2 and <= N, empty unless built
+        SContinuationLevel continuations[N-1];
+
+        //The arrays storing the probabilities for n>=1 and <= N, the 1-grams are
+        //indexed by the word id and the others by the N-gram's context id
+        TLargeVector<SProbEntry> probs[N];
+
+        //The log10 probability of an unknown word
+        TLogProbSize unknownProb;
+
+        //The number of the hot region entries of every level, i.e. the number of
+        //the leading word ids of the dictionary and of the leading pairs of the
+        //compacted levels, set once the trie is compacted
+        size_t hotEntries[N];
+
+        //The flag indicating that the found entries are counted, @see setHotRegionCounting
+        bool isCountingHot;
 
-        //The map storing n-tires for n>=2 and <= N
-        //ToDo: That does nog have to be a map, a simple array should suffice!
-        //ToDo: The key can be just of type byte as we typically consider up to 6-Grams
-        unordered_map<TWordHashSize, TNTrieEntryPairsMap > data[N-1];
+        //The numbers of the found entries and of the found hot region entries per level
+        mutable atomic<size_t> numProbes[N];
+        mutable atomic<size_t> numHotProbes[N];
 
         //The internal query results cache
         unordered_map<TWordHashSize, TCacheEntry > queryCache;
@@ -151,99 +616,295 @@ namespace tries {
 
         /**
          * This function has pure debug purpose, so its impl is ugly
-         * This implementation delivers quite a few hash collisions!
-         * This is not something I want to have at the moment as then
-         * the data structure will need to be more complex. So this
-         * function will not be used.
          * @param tokens the tokens to print
          * @param hash the begin of the n-gram
          * @param n the number of elements in the n-gram
          */
-        void printDebugNGram(vector<string> &tokens, const int hash, const int n );
+        void printDebugNGram(const vector<string> &tokens, const int hash, const int n );
 
         /**
-         * This function computes the result for the given word's hash query:
+         * This function computes the result for the given word's id query:
          * It gets the frequencies of all the stored N-grams ending with the given word
-         * @param hash the hash of the word we are after
+         * @param wordId the id of the word we are after
          * @param result the N-Gram frequency values array, @see RFrequencyResult for more details
          */
-        void queryWordFreqs( TWordHashSize hash, SFrequencyResult<N> & result);
+        void queryWordFreqs( const TWordId wordId, SFrequencyResult<N> & result);
 
         /**
-         * This is a recursive method for querying the N-gram frequencies
-         * @param endWordHash the hash of the last word in the N-grams
-         * @param L the currently considered level of the N-Gram: 0 <= 2 <= N
-         * @param ngram the N-gram words
-         * @param hashes the hashes of the N-gram words
-         * @param freqs the array to put the resulting frequency of the N-gram word_(nStart) .. word_(nEnd) from ngram
-         *              the computed frequency is to be put @ position nStart in the array
+         * Allows to check if the unknown word probability is not stored as a word
+         * @return true if the probabilities are computed and the unknown word is not stored
          */
-        void queryNGramFreqs(const TWordHashSize endWordHash, const TTrieSize L,
-                             const vector<string> & ngram, vector<TWordHashSize> & hashes,
-                             SFrequencyResult<N> & freqs) const ;
-        
+        inline bool isUnknownWordVirtual() const {
+            const string unknown = UNKNOWN_WORD_STR;
+            return hasProbs() && (getWordId(unknown, computeMurmur64Hash(unknown)) == UNDEFINED_WORD_ID);
+        }
+
         /**
-         * Computes the context for the given Words.
-         * For example for hashes =  [w4 w3 w2 w1] and L = 3 this method will compute
-         * context(w4, context(w3,w2))
-         * @param hashes the pre-computed word's hashes on which the context can be computed
-         * @param L the current context level, is <= the number of shash values in hashes
-         * @return the computed context for the N-gram defined by hashes and L
-         */
-        static inline TReferenceHashSize createContext( vector<TWordHashSize> & hashes, const TTrieSize cLevel ) throw(Exception){
-            const TTrieSize currMaxIdx = (cLevel - MINIMUM_CONTEXT_LEVEL);
-            //Define and default initialize the context value
-            TReferenceHashSize context = hashes.at(currMaxIdx);
-            LOG_DEBUG << "initializing context = " << context << END_LOG;
-            
-            if( currMaxIdx > 0 ) {
-                LOG_DEBUG << "There is more than one element to create context from!" << END_LOG;
-                //If there is more than one element we need to create a hash for then iterate
-                for(TTrieSize idx = currMaxIdx; idx > 0; idx-- ) {
-                    LOG_DEBUG << "context( " << hashes.at(idx-1) << ", " << context << " )" << END_LOG;
-                    context = createContext(hashes.at(idx-1), context);
-                    LOG_DEBUG << "                 = " << context << END_LOG;
-                }
+         * Gets the frequency of the N-gram with the given context id
+         * @param L the N-gram level, 1 <= L <= N, the 1-grams are given by the word id
+         * @param id the N-gram's context id
+         * @return the N-gram frequency
+         */
+        TFrequencySize getEntryFreq(const TTrieSize L, const TContextId id) const;
+
+        /**
+         * Computes the context ids of the N-grams' suffixes, i.e. the N-grams
+         * without their first words. The suffixes of the 2-grams are word ids.
+         * @param suffixIds the arrays to fill in, suffixIds[L-1] is for the
+         *                  level L, 2 <= L <= N, and is indexed by the context id
+         */
+        void computeSuffixIds(vector<TContextId> suffixIds[N]) const;
+
+        /**
+         * Computes the probabilities with the stupid back-off smoothing
+         */
+        void computeStupidBackoffProbs();
+
+        /**
+         * Computes the probabilities with the interpolated modified Kneser-Ney smoothing
+         * @param suffixIds the N-grams' suffix ids, @see computeSuffixIds
+         */
+        void computeKneserNeyProbs(const vector<TContextId> suffixIds[N]);
+
+        /**
+         * Checks that the trie is not compacted yet and can be added to
+         * @throws Exception in case the trie is compacted
+         */
+        inline void checkNotCompact() const throw (Exception) {
+            if (isCompacted) {
+                throw Exception("Can not add to the trie, it is compacted!");
+            }
+        }
+
+        /**
+         * Gets the id of the given word, registers a new word with zero frequency if needed.
+         * In the hash verification mode the words colliding with the key of another
+         * word get their own ids from the collision list, @see collidingWords
+         * @param word the word to get the id for
+         * @param hash the word's hash
+         * @return the word id
+         */
+        inline TWordId getOrCreateWordId(const string & token, const TWordHashSize hash) {
+            const TWordHashSize key = THashPolicy::getHash(token, hash);
+            TWordId & id = words[key];
+            if (id == UNDEFINED_WORD_ID) {
+                //This is a new word, give it the next id
+                id = wordsById.size();
+                SWordEntry entry = {token, 0};
+                wordsById.push_back(entry);
+                LOG_DEBUG << "id( " << token << " ) = " << id << END_LOG;
             } else {
-                if( currMaxIdx < 0 ) {
-                    throw Exception("Unable to compute context of level <=1. It does not exist!");
+                if (!isSameWord(wordsById[id], token)) {
+                    return getOrCreateCollidingWordId(token, key, id);
                 }
             }
-            
-            return context;
+            return id;
         }
-        
+
         /**
-         * This function computes the hash of the word
-         * @param str the word to hash
-         * @return the resulting hash
+         * Gets the id of the word colliding with the key of another word, registers a
+         * new word with zero frequency in the collision list if needed and logs it once
+         * @param token the word to get the id for
+         * @param key the word's hash policy key
+         * @param keyId the id of the word stored under the key in the dictionary map
+         * @return the word id
          */
-        static inline TWordHashSize computeHash(const string & str) {
-            //Use the Prime numbers hashing algorithm as it outperforms djb2
-            return computePrimesHash(str);
+        TWordId getOrCreateCollidingWordId(const string & token, const TWordHashSize key, const TWordId keyId);
+
+        /**
+         * Gets the id of the word colliding with the key of another word
+         * @param word the word to look for
+         * @param key the word's hash policy key
+         * @return the word id or UNDEFINED_WORD_ID if the word is not known
+         */
+        TWordId getCollidingWordId(const string & word, const TWordHashSize key) const;
+
+        /**
+         * Gets the N-gram entry of the given level, creates a new one with zero frequency if needed.
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the N-gram entry
+         * @throws Exception in case the level's context ids are exhausted
+         */
+        inline SNGramEntry & getOrCreateEntry(const TTrieSize L, const TWordId wordId, const TContextId context) throw (Exception) {
+            vector<TNTrieEntryPairsMap> & level = data[L - MINIMUM_CONTEXT_LEVEL];
+            //Make sure the level has room for all the known words
+            if (wordId >= level.size()) {
+                level.resize(wordsById.size());
+            }
+
+            SNGramEntry & entry = level[wordId][context];
+            if (entry.id == UNDEFINED_CONTEXT_ID) {
+                //This is a new N-gram, give it the next context id of its level
+                TLargeVector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+                if (levelContexts.size() > numeric_limits<TContextId>::max()) {
+                    stringstream msg;
+                    msg << "The context ids of the level " << L << " are exhausted!";
+                    throw Exception(msg.str());
+                }
+                entry.id = levelContexts.size();
+                SContextEntry ctxEntry = {wordId, context};
+                levelContexts.push_back(ctxEntry);
+            }
+            return entry;
         }
 
         /**
-         * Computes the N-Gram context using the previous context and the current word hash
-         * @param hash the current word hash
-         * @param context the previous context
-         * @return the resulting context
+         * Starts the batched lookup of the given N-gram
+         * @param lookup the lookup state to initialize
+         * @param ngramIdx the index of the N-gram in the batch
+         * @param freqs the N-gram's frequencies, are zeroed
          */
-        static inline TReferenceHashSize createContext(TWordHashSize hash, TReferenceHashSize context) {
-            //Use the Szudzik algorithm as it outperforms Cantor
-            return szudzik(hash, context);
+        inline void startLookup(SLookupState & lookup, const size_t ngramIdx, SFrequencyResult<N> & freqs) const {
+            lookup.ngramIdx = ngramIdx;
+            lookup.numWords = N;
+            fill(freqs.result, freqs.result + N, 0);
         }
 
         /**
-         * This function dissolves the given Ngram context (for N>=2) into a sub-word
-         * hash and a sub-context: c(w_n) is defined by hash(w_n) and c(w_(n-1))
-         * @param context the given context to dissolve 
-         * @param subWord the sub-work
-         * @param subContext the sub-context
+         * Makes one step of the batched lookup, i.e. does one dependent memory
+         * access and prefetches the memory needed by the next step.
+         * @param lookup the lookup state
+         * @param ngram the words of the looked up N-gram
+         * @param hashes the words' hashes
+         * @param freqs the N-gram's frequencies
+         * @return true if the lookup is finished, otherwise false
+         */
+        bool stepLookup(SLookupState & lookup, const string * ngram, const TWordHashSize * hashes,
+                        SFrequencyResult<N> & freqs) const;
+
+        /**
+         * Prefetches the level entry that will be probed by the next lookup step
+         * @param lookup the lookup state
          */
-        static inline void dessolveContext(const TReferenceHashSize context, TWordHashSize &subWord, TReferenceHashSize &subContext){
-            //Use the Szudzik algorithm as it outperforms Cantor
-            unszudzik(context,subWord,subContext);
+        inline void prefetchProbe(const SLookupState & lookup) const {
+            const TTrieSize startIdx = N - lookup.level;
+            const TTrieSize probeLevel = (lookup.probeIdx < (N - 1)) ? (lookup.probeIdx - startIdx + 1) : lookup.level;
+            const TWordId wordId = lookup.wordIds[lookup.probeIdx];
+            if (isCompacted) {
+                //The keys are behind the offsets, only the offsets can be prefetched
+                const TLargeVector<TContextId> & offsets = compactData[probeLevel - MINIMUM_CONTEXT_LEVEL].offsets;
+                if (wordId < offsets.size()) {
+                    __builtin_prefetch(&offsets[wordId]);
+                }
+                return;
+            }
+            const vector<TNTrieEntryPairsMap> & level = data[probeLevel - MINIMUM_CONTEXT_LEVEL];
+            if (wordId < level.size()) {
+                //The map's inline pairs can span two cache lines
+                const char * entry = reinterpret_cast<const char *> (&level[wordId]);
+                __builtin_prefetch(entry);
+                __builtin_prefetch(entry + sizeof (TNTrieEntryPairsMap) - 1);
+            }
+        }
+
+        /**
+         * Gets the id of the given word
+         * @param word the word to look for
+         * @param hash the word's hash
+         * @return the word id or UNDEFINED_WORD_ID if the word is not known
+         */
+        inline TWordId getWordId(const string & word, const TWordHashSize hash) const {
+            const TWordHashSize key = THashPolicy::getHash(word, hash);
+            const TWordId * found = words.find(key);
+            if (found != NULL) {
+                const TWordId wordId = isSameWord(wordsById[*found], word) ? *found : getCollidingWordId(word, key);
+                if (isCountingHot && (wordId != UNDEFINED_WORD_ID)) {
+                    countProbe(1, wordId);
+                }
+                return wordId;
+            }
+            return UNDEFINED_WORD_ID;
+        }
+
+        /**
+         * Looks up the N-gram entry of the given level
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the pointer to the N-gram entry or NULL if there is no such N-gram
+         */
+        inline const SNGramEntry * findEntry(const TTrieSize L, const TWordId wordId, const TContextId context) const {
+            if (isCompacted) {
+                const SCompactLevel & level = compactData[L - MINIMUM_CONTEXT_LEVEL];
+                const SNGramEntry * entry = findCompactEntry(level, wordId, context);
+                if (isCountingHot && (entry != NULL)) {
+                    countProbe(L, entry - level.entries.data());
+                }
+                return entry;
+            }
+            const vector<TNTrieEntryPairsMap> & level = data[L - MINIMUM_CONTEXT_LEVEL];
+            if (wordId < level.size()) {
+                return level[wordId].find(context);
+            }
+            return NULL;
+        }
+
+        /**
+         * Re-assigns the word ids in the dictionary, the context entries and the
+         * 1-gram probabilities, the level maps are re-assigned by compact itself
+         * @param oldIds the old word ids indexed by the new word ids
+         * @param newIds the new word ids indexed by the old word ids
+         */
+        void relabelWords(const vector<TWordId> & oldIds, const vector<TWordId> & newIds);
+
+        /**
+         * Counts the found entry of the given level, @see setHotRegionCounting
+         * @param L the level, 1 <= L <= N
+         * @param pos the entry's word id for the 1-grams and its pair index otherwise
+         */
+        inline void countProbe(const TTrieSize L, const size_t pos) const {
+            numProbes[L - 1].fetch_add(1, memory_order_relaxed);
+            if (pos < hotEntries[L - 1]) {
+                numHotProbes[L - 1].fetch_add(1, memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Looks up the N-gram entry in the compacted level, by a binary search
+         * within the pairs of the given word
+         * @param level the compacted level
+         * @param wordId the id of the N-gram's last word
+         * @param context the context id of the N-gram's preceding words
+         * @return the pointer to the N-gram entry or NULL if there is no such N-gram
+         */
+        static inline const SNGramEntry * findCompactEntry(const SCompactLevel & level, const TWordId wordId, const TContextId context) {
+            if ((wordId + 1) < level.offsets.size()) {
+                const TContextId * begin = level.keys.data() + level.offsets[wordId];
+                const TContextId * end = level.keys.data() + level.offsets[wordId + 1];
+                const TContextId * found = lower_bound(begin, end, context);
+                if ((found != end) && (*found == context)) {
+                    return &level.entries[found - level.keys.data()];
+                }
+            }
+            return NULL;
+        }
+
+        /**
+         * Allows to check that the word stored under the given hash is the given word.
+         * In case the hash verification mode is off, always returns true.
+         * @param entry the word entry found for the given word's hash
+         * @param word the word that was looked for
+         * @return true if the word entry is the entry of the given word, otherwise false
+         */
+        static inline bool isSameWord(const SWordEntry & entry, const string & word) {
+#if HASH_VERIFICATION_MODE
+            return (entry.word == word);
+#else
+            return true;
+#endif
+        }
+        
+        /**
+         * This function computes the hash of the word, it must be the same as
+         * the one computed for the tokens by the TextTokenizer
+         * @param str the word to hash
+         * @return the resulting hash
+         */
+        static inline TWordHashSize computeHash(const string & str) {
+            //Use the 64 bit Murmur hash as the 32 bit prime numbers hash collides on large corpora
+            return computeMurmur64Hash(str);
         }
     };
     
@@ -26,17 +26,21 @@
 #ifndef HASHINGUTILS_HPP
 #define	HASHINGUTILS_HPP
 
-#include <string> //std::string
-#include <cmath>  //floor, sqrt 
+#include <string>  //std::string
+#include <cstring> //std::memcpy
+#include <algorithm> //std::min
+
+#include "Globals.hpp"
 
 using namespace std;
 
 namespace hashing {
 
-    //This is the smallest size which I've tested and it works for the hash without collisions
-    typedef unsigned int TWordHashSize;
-    //This is the hash reference size which should be twice as long as the TWordHashSize
-    typedef unsigned long int TReferenceHashSize;
+    //The multiplication constant and the shift of the MurmurHash64A
+    #define MURMUR_64_M 0xc6a4a7935bd1e995ULL
+    #define MURMUR_64_R 47
+    //The seed of the 64 bit word hash family member used by the tries
+    #define WORD_HASH_SEED 0x5bd1e9955bd1e995ULL
 
     /**
      * This is one of the best known hashing function algorithms (djb2) for the C 
@@ -48,7 +52,7 @@ namespace hashing {
      */
     inline TWordHashSize computeDjb2Hash(const string & str)
     {
-        TWordHashSize hashVal = 5381;
+        uint32_t hashVal = 5381;
         int c;
         const char * c_str = str.c_str();
 
@@ -76,7 +80,7 @@ namespace hashing {
     #define C 86969 /* yet another prime */
     inline TWordHashSize computePrimesHash(const string & str)
     {
-       TWordHashSize h = 31 /* also prime */;
+       uint32_t h = 31 /* also prime */;
        const char * c_str = str.c_str();
        while (*c_str) {
          h = (h * A) ^ (c_str[0] * B);
@@ -86,70 +90,136 @@ namespace hashing {
     }
 
     /**
-     * This function will combine two word references to get one hash map
-     * N-gram level reference. This is a cantor function used for pairing.
-     * http://en.wikipedia.org/wiki/Pairing_function#Cantor_pairing_function
-     * WARNING: does not work good with big numbers! Overflows!
-     * @param x the key word reference
-     * @param y the previous context
-     * @return the context reference for the next N-gram level
+     * This is the finalization mix of the MurmurHash3, it is a bijection
+     * on 64 bit values that makes every input bit affect every output bit.
+     * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp
+     * @param k the value to mix
+     * @return the mixed value
      */
-    inline TReferenceHashSize cantor(TWordHashSize x, TReferenceHashSize y) {
-        return ((x+y)*(x+y+1))/2 + y;
+    inline uint64_t fmix64(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
     }
 
     /**
-     * This function will invert the cuntor encoded context and split it into two things
-     * The previous word and the previous context.  This is an inverse cantor function used for unpairing.
-     * http://en.wikipedia.org/wiki/Pairing_function#Cantor_pairing_function
-     * WARNING: does not work good with big numbers! Overflows!
-     * @param z the current context id
-     * @param x the previous word in the context
-     * @param y the context of the previous word
+     * Mixes the given number of the eight byte blocks into the MurmurHash64A state
+     * @param h the hash state
+     * @param data the pointer to the first block, is moved past the last mixed block
+     * @param nblocks the number of the eight byte blocks to mix
+     * @return the new hash state
      */
-    inline void uncantor(const TReferenceHashSize z, TWordHashSize &x, TReferenceHashSize &y){
-        const TReferenceHashSize w = floor( ( sqrt( 8 * z + 1 ) - 1 ) / 2);
-        const TReferenceHashSize t = ( w * w + w ) / 2;
-        y = (z - t);
-        x = (TWordHashSize) (w - y);
+    inline uint64_t mixMurmur64Blocks(uint64_t h, const char * & data, size_t nblocks) {
+        while (nblocks--) {
+            uint64_t k;
+            memcpy(&k, data, sizeof (uint64_t));
+            data += sizeof (uint64_t);
+
+            k *= MURMUR_64_M;
+            k ^= k >> MURMUR_64_R;
+            k *= MURMUR_64_M;
+
+            h ^= k;
+            h *= MURMUR_64_M;
+        }
+        return h;
     }
 
     /**
-     * This function will combine two word references to get one hash map
-     * N-gram level reference. This is a Szudzik's function used for pairing.
-     * http://szudzik.com/ElegantPairing.pdf
-     * This function is more efficient that than of Cantor as it uses indexes densely
-     * the result of szudzik(N,M) is <= 2*max(M,N), so the risk of owerflows is much smaller!
-     * @param x the key word reference
-     * @param y the previous context
-     * @return the context reference for the next N-gram level
+     * Mixes the tail of less than eight bytes into the MurmurHash64A state and finalizes it
+     * @param h the hash state
+     * @param data the pointer to the tail
+     * @param len the length of the entire hashed data, the tail length is len % 8
+     * @return the resulting hash
      */
-    inline TReferenceHashSize szudzik(TWordHashSize x, TReferenceHashSize y) {
-        return ( x >= y ? (y + x + x * x ) : (x + y * y) );
+    inline uint64_t finishMurmur64Hash(uint64_t h, const char * data, const size_t len) {
+        const unsigned char * tail = (const unsigned char *) data;
+        switch (len & 7) {
+            case 7: h ^= uint64_t(tail[6]) << 48;
+            case 6: h ^= uint64_t(tail[5]) << 40;
+            case 5: h ^= uint64_t(tail[4]) << 32;
+            case 4: h ^= uint64_t(tail[3]) << 24;
+            case 3: h ^= uint64_t(tail[2]) << 16;
+            case 2: h ^= uint64_t(tail[1]) << 8;
+            case 1: h ^= uint64_t(tail[0]);
+                h *= MURMUR_64_M;
+        };
+
+        h ^= h >> MURMUR_64_R;
+        h *= MURMUR_64_M;
+        h ^= h >> MURMUR_64_R;
+
+        return h;
     }
 
     /**
-     * This function will invert the Szudzik's encoded context and split it into two things
-     * The previous word and the previous context.  This is an inverse Szudzik's function used for unpairing.
-     * http://szudzik.com/ElegantPairing.pdf
-     * WARNING: does not work good with big numbers! Owerflows!
-     * @param z the current context id
-     * @param x the previous word in the context
-     * @param y the context of the previous word
+     * This is the MurmurHash64A hash function by Austin Appleby, see
+     * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash2.cpp
+     * It consumes the word eight bytes at a time and has a good distribution
+     * over all the 64 bits. Different seeds give independent family members.
+     * Note: The time complexity is linear in the length of the word, but
+     *       the number of multiplications is eight times less than for the
+     *       byte by byte hashes such as djb2 and the PrimesHash.
+     * @param data the pointer to the word's first character
+     * @param len the length of the word in characters
+     * @param seed the hash family member's seed
+     * @return the resulting hash
      */
-    inline void unszudzik(const TReferenceHashSize z, TWordHashSize &x, TReferenceHashSize &y){
-        const TReferenceHashSize zrf = floor( sqrt( z ) );
-        const TReferenceHashSize zrfs = zrf * zrf;
-        const TReferenceHashSize zmzrfs = z - zrfs;
-        if( zmzrfs < zrf ) {
-            x = zmzrfs;
-            y = zrf;
-        } else {
-            x = zrf;
-            y = zmzrfs - zrf;
+    inline TWordHashSize computeMurmur64Hash(const char * data, const size_t len, const uint64_t seed = WORD_HASH_SEED) {
+        const uint64_t h = mixMurmur64Blocks(seed ^ (len * MURMUR_64_M), data, len / sizeof (uint64_t));
+        return finishMurmur64Hash(h, data, len);
+    }
+
+    /**
+     * Computes the MurmurHash64A hashes of several words in parallel lanes.
+     * The blocks the words have in common are mixed in an interleaved loop,
+     * so the independent multiplication chains of the lanes overlap in the
+     * CPU pipeline. The results are the same as for computeMurmur64Hash.
+     * @param LANES the number of words to hash in parallel
+     * @param data the pointers to the words' first characters
+     * @param len the lengths of the words in characters
+     * @param hashes the out array for the resulting hashes
+     * @param seed the hash family member's seed
+     */
+    template<uint8_t LANES>
+    inline void computeMurmur64Hashes(const char * const data[LANES], const size_t len[LANES],
+                                      TWordHashSize hashes[LANES], const uint64_t seed = WORD_HASH_SEED) {
+        uint64_t h[LANES];
+        const char * ptr[LANES];
+        size_t common = len[0] / sizeof (uint64_t);
+        for (uint8_t lane = 0; lane < LANES; lane++) {
+            h[lane] = seed ^ (len[lane] * MURMUR_64_M);
+            ptr[lane] = data[lane];
+            common = min(common, len[lane] / sizeof (uint64_t));
+        }
+
+        //Mix the common blocks of all the lanes at once
+        for (size_t block = 0; block < common; block++) {
+            for (uint8_t lane = 0; lane < LANES; lane++) {
+                h[lane] = mixMurmur64Blocks(h[lane], ptr[lane], 1);
+            }
+        }
+
+        //Mix the remaining blocks and the tail of every lane
+        for (uint8_t lane = 0; lane < LANES; lane++) {
+            h[lane] = mixMurmur64Blocks(h[lane], ptr[lane], len[lane] / sizeof (uint64_t) - common);
+            hashes[lane] = finishMurmur64Hash(h[lane], ptr[lane], len[lane]);
         }
     }
 
+    /**
+     * Computes the 64 bit MurmurHash64A hash of the given word
+     * @param str the word to hash
+     * @param seed the hash family member's seed
+     * @return the resulting hash
+     */
+    inline TWordHashSize computeMurmur64Hash(const string & str, const uint64_t seed = WORD_HASH_SEED) {
+        return computeMurmur64Hash(str.data(), str.length(), seed);
+    }
+
 }
 
 #endif	/* HASHINGUTILS_HPP */
@@ -0,0 +1,166 @@
+/* 
+ * File:   LargePages.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 07:10 PM
+ */
+
+#ifndef LARGEPAGES_HPP
+#define	LARGEPAGES_HPP
+
+#include <cstddef>      // std::size_t
+#include <new>          // std::bad_alloc, operator new
+
+#include "Exceptions.hpp"
+
+using namespace std;
+
+namespace memory {
+
+    //The huge page size and the minimum size of the tables allocated as the large tables
+    #define HUGE_PAGE_BYTES (2u * 1024u * 1024u)
+
+    //The page policies of the large tables
+    enum EPagePolicy {
+        //The regular pages
+        REGULAR_PAGES = 0,
+        //The transparent huge pages, requested with madvise
+        TRANSPARENT_HUGE_PAGES = REGULAR_PAGES + 1,
+        //The explicit huge pages from the reserved pool, mapped with MAP_HUGETLB,
+        //the transparent huge pages are used if the pool is exhausted
+        EXPLICIT_HUGE_PAGES = TRANSPARENT_HUGE_PAGES + 1
+    };
+
+    //The NUMA placement policies of the large tables
+    enum ENumaPolicy {
+        //The pages are placed on the node of the thread touching them first
+        LOCAL_NUMA = 0,
+        //The pages are interleaved over all the nodes with memory
+        INTERLEAVE_NUMA = LOCAL_NUMA + 1
+    };
+
+    /**
+     * Sets the page and the NUMA policies of the large tables allocated afterwards,
+     * the tables allocated before keep their pages.
+     * @param pages the page policy
+     * @param numa the NUMA placement policy
+     * @throws Exception if the policy is not supported on this platform
+     */
+    void setLargeTablePolicy(const EPagePolicy pages, const ENumaPolicy numa) throw (Exception);
+
+    /**
+     * Allocates a large table, at least HUGE_PAGE_BYTES. The table is mapped
+     * separately, aligned to the huge page size, and the policies are applied
+     * before its pages are touched, @see setLargeTablePolicy.
+     * @param bytes the number of bytes
+     * @return the table memory
+     * @throws bad_alloc if the memory can not be mapped
+     */
+    void * allocateLargeTable(const size_t bytes);
+
+    /**
+     * Releases the table allocated with allocateLargeTable
+     * @param ptr the table memory
+     * @param bytes the number of bytes it was allocated with
+     */
+    void freeLargeTable(void * ptr, const size_t bytes);
+
+    /**
+     * Applies the page policy to the read-only file mapping, i.e. asks for the
+     * transparent huge pages if the huge pages are used. The explicit huge pages
+     * can not back the regular files, so they are the transparent ones here.
+     * @param ptr the mapping start
+     * @param bytes the mapping size
+     */
+    void adviseFileMapping(void * ptr, const size_t bytes);
+
+    /**
+     * Allows to get the number of bytes of the process memory backed by the
+     * huge pages, i.e. the transparent and the explicit ones.
+     * @return the number of bytes, zero if it is not known on this platform
+     */
+    size_t getHugePagesBytes();
+
+    /**
+     * This is the allocator of the large flat tables, e.g. the trie levels.
+     * The arrays of at least HUGE_PAGE_BYTES are allocated with allocateLargeTable,
+     * so the huge page and the NUMA policies apply to them, the smaller ones are
+     * allocated as usual. The allocator has no state, all its instances are equal.
+     * @param TValue the element type
+     */
+    template<typename TValue>
+    class LargeTableAllocator {
+    public:
+        typedef TValue value_type;
+
+        LargeTableAllocator() {
+        }
+
+        template<typename TOther>
+        LargeTableAllocator(const LargeTableAllocator<TOther> & other) {
+        }
+
+        /**
+         * Allocates the array of the given number of elements
+         * @param num the number of elements
+         * @return the array memory
+         */
+        inline TValue * allocate(const size_t num) {
+            const size_t bytes = num * sizeof (TValue);
+            if (bytes >= HUGE_PAGE_BYTES) {
+                return static_cast<TValue *> (allocateLargeTable(bytes));
+            }
+            return static_cast<TValue *> (::operator new(bytes));
+        }
+
+        /**
+         * Releases the array allocated with allocate
+         * @param ptr the array memory
+         * @param num the number of elements it was allocated with
+         */
+        inline void deallocate(TValue * ptr, const size_t num) {
+            const size_t bytes = num * sizeof (TValue);
+            if (bytes >= HUGE_PAGE_BYTES) {
+                freeLargeTable(ptr, bytes);
+            } else {
+                ::operator delete(ptr);
+            }
+        }
+
+        template<typename TOther>
+        struct rebind {
+            typedef LargeTableAllocator<TOther> other;
+        };
+    };
+
+    template<typename TFirst, typename TSecond>
+    inline bool operator==(const LargeTableAllocator<TFirst> & first, const LargeTableAllocator<TSecond> & second) {
+        return true;
+    }
+
+    template<typename TFirst, typename TSecond>
+    inline bool operator!=(const LargeTableAllocator<TFirst> & first, const LargeTableAllocator<TSecond> & second) {
+        return false;
+    }
+}
+
+#endif	/* LARGEPAGES_HPP */
+
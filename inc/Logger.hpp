@@ -29,6 +29,11 @@
 #include <iostream>  // std::cout
 #include <sstream>   // std::stringstream
 #include <vector>    // std::vector
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono
+#include <thread>    // std::thread
+#include <mutex>     // std::mutex
+#include <condition_variable> // std::condition_variable
 
 #include "Exceptions.hpp"
 
@@ -37,8 +42,8 @@ using namespace std;
 #ifndef LOGGER_HPP
 #define	LOGGER_HPP
 
-//Defines the progress bar update period in CPU seconds
-#define PROGRESS_UPDATE_PERIOD 0.1
+//Defines the progress report period in wall-clock milliseconds
+#define PROGRESS_UPDATE_PERIOD_MSEC 1000
 
 //The logging macros to be used that allows for compile-time as well as runtime optimization
 #ifndef LOGER_MAX_LEVEL
@@ -90,22 +95,39 @@ public:
     static inline DebugLevel& ReportingLevel() { return currLEvel; };
 
     /**
-     * The function that start progress bar
+     * The function that starts the progress reporting. A background ticker
+     * thread periodically samples the progress counters and reports the
+     * lines/sec, Mb/sec, the percent of the input consumed, the ETA and the RSS.
      * Works if the current debug level is <= INFO
+     * @param totalBytes the input size in bytes, or zero if it is not known
      */
-    static void startProgressBar();
+    static void startProgressBar(const size_t totalBytes = 0);
 
     /**
-     * The function that updates progress bar
-     * Works if the current debug level is <= INFO
+     * The function that updates the progress, it only increments the
+     * counters so it is cheap enough to be called for every input line.
+     * Is to be called from one thread at a time.
+     * @param numBytes the number of the consumed input bytes
      */
-    static void updateProgressBar();
+    static inline void updateProgressBar(const size_t numBytes) {
+        progressLines.store(progressLines.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        progressBytes.store(progressBytes.load(memory_order_relaxed) + numBytes, memory_order_relaxed);
+    }
 
     /**
-     * The function that stops progress bar
+     * The function that stops the progress reporting, joins the ticker thread
+     * and reports the final progress.
      * Works if the current debug level is <= INFO
      */
     static void stopProgressBar();
+
+    /**
+     * Allows to get the number of bytes from the current position to the end of the stream.
+     * The stream position is not changed.
+     * @param stream the stream to consider
+     * @return the number of the remaining bytes, or zero if it can not be found
+     */
+    static size_t getRemainingBytes(istream & stream);
     
 private:
     //The class constructor, copy constructor and assign operator
@@ -117,17 +139,38 @@ private:
     //Stores the current used message level
     static DebugLevel currLEvel;
     
-    //Stores the progress bar characters
-    static const vector<string> progressChars;
-    
-    //Stores the number of progress characters
-    static const unsigned short int numProgChars;
-    
-    //Stores the current progress element idx
-    static unsigned short int currProgCharIdx;
-    
-    //Stores the last progress update in CPU seconds
-    static double lastProgressUpdate;
+    //Stores the number of the consumed input lines
+    static atomic<size_t> progressLines;
+
+    //Stores the number of the consumed input bytes
+    static atomic<size_t> progressBytes;
+
+    //Stores the input size in bytes, zero if unknown
+    static size_t progressTotalBytes;
+
+    //Stores the progress start time
+    static chrono::steady_clock::time_point progressStart;
+
+    //The progress ticker thread
+    static thread progressTicker;
+
+    //The mutex and the condition to wake up the ticker thread when stopping
+    static mutex progressMutex;
+    static condition_variable progressCondition;
+
+    //The flag indicating that the ticker thread is to stop
+    static bool isProgressStop;
+
+    /**
+     * The body of the progress ticker thread
+     */
+    static void runProgressTicker();
+
+    /**
+     * Reports the current progress
+     * @param isFinal true if this is the final report after the input is consumed
+     */
+    static void reportProgress(const bool isFinal);
     
 };
 
@@ -0,0 +1,111 @@
+/* 
+ * File:   MemoryUtils.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:40 PM
+ */
+
+#ifndef MEMORYUTILS_HPP
+#define	MEMORYUTILS_HPP
+
+#include <cstddef>  //std::size_t
+#include <string>   //std::string
+#include <vector>   //std::vector
+
+using namespace std;
+
+namespace memory {
+
+    //The size of the heap block header and the heap block alignment, as in glibc malloc
+    #define HEAP_BLOCK_HEADER_BYTES sizeof(size_t)
+    #define HEAP_BLOCK_ALIGNMENT_BYTES (2 * sizeof(size_t))
+    //The minimum heap block size, as in glibc malloc
+    #define HEAP_BLOCK_MINIMUM_BYTES (4 * sizeof(size_t))
+
+    /**
+     * Allows to get the size of the heap block allocated for the requested
+     * number of bytes, including the block header and the alignment padding.
+     * Note: The block layout is the one of the glibc malloc, other allocators
+     * have a similar overhead but the exact values can differ slightly.
+     * @param bytes the requested number of bytes
+     * @return the heap block size in bytes, zero if nothing was requested
+     */
+    inline size_t getHeapBlockBytes(const size_t bytes) {
+        if (bytes == 0) {
+            return 0;
+        }
+        const size_t block = (bytes + HEAP_BLOCK_HEADER_BYTES + HEAP_BLOCK_ALIGNMENT_BYTES - 1)
+                & ~(HEAP_BLOCK_ALIGNMENT_BYTES - 1);
+        return (block < HEAP_BLOCK_MINIMUM_BYTES) ? HEAP_BLOCK_MINIMUM_BYTES : block;
+    }
+
+    /**
+     * Allows to get the number of bytes of the vector's element array
+     * @param vec the vector
+     * @return the capacity of the vector in bytes
+     */
+    template<typename TValue, typename TAllocator>
+    inline size_t getVectorBytes(const vector<TValue, TAllocator> & vec) {
+        return vec.capacity() * sizeof (TValue);
+    }
+
+    /**
+     * Allows to get the number of heap bytes used by the string's characters.
+     * The short strings are stored inline, in the string object itself, and
+     * do not use the heap memory at all.
+     * @param str the string
+     * @return the number of the heap bytes, including the heap block overhead
+     */
+    inline size_t getStringHeapBytes(const string & str) {
+        static const size_t INLINE_CAPACITY = string().capacity();
+        return (str.capacity() > INLINE_CAPACITY) ? getHeapBlockBytes(str.capacity() + 1) : 0;
+    }
+
+    /**
+     * Allows to get the number of bytes of the hash map's bucket array.
+     * A map with a single bucket uses the bucket stored in the map object.
+     * @param map the unordered map
+     * @return the bucket array size, including the heap block overhead
+     */
+    template<typename TMap>
+    inline size_t getHashMapBucketBytes(const TMap & map) {
+        return (map.bucket_count() > 1) ? getHeapBlockBytes(map.bucket_count() * sizeof (void *)) : 0;
+    }
+
+    /**
+     * Allows to get the overhead of a hash map node on top of its key/value
+     * pair, i.e. the next node pointer, the alignment and the heap block
+     * overhead. The integer keys use the identity hash so the node does not
+     * cache the hash value, as in the GNU standard library.
+     * @param TMap the unordered map type
+     * @return the node overhead in bytes
+     */
+    template<typename TMap>
+    inline size_t getHashMapNodeOverheadBytes() {
+        typedef typename TMap::value_type TPair;
+        const size_t align = (alignof (TPair) > alignof (void *)) ? alignof (TPair) : alignof (void *);
+        const size_t node = (sizeof (void *) + sizeof (TPair) + align - 1) & ~(align - 1);
+        return getHeapBlockBytes(node) - sizeof (TPair);
+    }
+}
+
+#endif	/* MEMORYUTILS_HPP */
+
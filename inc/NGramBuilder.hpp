@@ -33,6 +33,7 @@
 #include <sstream> //std::stringstream
 
 #include "Globals.hpp"
+#include "TextTokenizer.hpp"
 #include <Exceptions.hpp>
 
 using namespace std;
@@ -41,17 +42,40 @@ namespace tries {
 namespace ngrams {
     /**
      * This class is responsible for splitting a piece of text in a number of ngrams and place it into the trie
+     * @param N the maximum level of the considered N-gram
+     * @param doCache the query caching flag of the trie
+     * @param TTrie the type of the filled in trie, the builders instantiated on the
+     *              concrete final trie types call the trie methods directly,
+     *              without the virtual dispatch, so that they can be inlined
      */
-    template<TTrieSize N, bool doCache>
+    template<TTrieSize N, bool doCache, typename TTrie = ATrie<N, doCache> >
     class NGramBuilder {
     public:
-        NGramBuilder(ATrie<N,doCache> & trie, const char delim);
+        NGramBuilder(TTrie & trie, const char delim);
+
+        /**
+         * The constructor for the builder that fills in only one partition of
+         * the trie. Only the words of this partition and only the N-grams ending
+         * with them are put into it. @see ATrie::getPartition
+         * @param owner the partitioned trie, its partitions are given by ATrie::getHashPartitionIndex
+         * @param partition the partition to fill in
+         * @param partIdx the index of the partition to fill in
+         * @param delim the tokens delimiter
+         */
+        NGramBuilder(const ATrie<N,doCache> & owner, TTrie & partition, const size_t partIdx, const char delim);
 
         /**
          * For the given text will split it into the number of n-grams that will be then put into the trie
          * @param data the string to process, has to be space a separated sequence of tokens
          */
         void processString(const string & data );
+
+        /**
+         * For the given tokenized text will split it into the number of n-grams that will be then put into the trie
+         * @param tokens the text tokens
+         * @param hashes the text tokens' hashes, @see TextTokenizer
+         */
+        void processTokens(const vector<string> & tokens, const vector<TWordHashSize> & hashes);
         
         /**
          * This method build an N-Gram from a string, which is nothing more than
@@ -64,13 +88,16 @@ namespace ngrams {
          * @param n the expected value of N
          * @param delim the delimiter to parse the string into
          * @param ngram the output parameter that will be filled in with the N-gram values
+         * @param hashes the output parameter that will be filled in with the N-gram word hashes
          * @throws Exception in case the resulting N-gram has the number elements other than expected
          */
-        static inline void buildNGram(const string & line, const TTrieSize  n, const char delim, vector<string> & ngram) throw(Exception) {
-            //First clean the vector
+        static inline void buildNGram(const string & line, const TTrieSize  n, const char delim,
+                                      vector<string> & ngram, vector<TWordHashSize> & hashes) throw(Exception) {
+            //First clean the vectors
             ngram.clear();
-            //Tokenise the line
-            tokenize(line, delim, ngram);
+            hashes.clear();
+            //Tokenise the line and hash the tokens
+            TextTokenizer::tokenize(line, delim, ngram, hashes);
             //Check that the number of words in the N-gram is proper
             if( ngram.size() != n) {
                 stringstream msg;
@@ -82,7 +109,13 @@ namespace ngrams {
         virtual ~NGramBuilder();
     private:
         //The trie to store the n-grams 
-        ATrie<N,doCache> & _trie;
+        TTrie & _trie;
+        //The number of partitions of the partitioned trie, one if all the n-grams are stored
+        const size_t _numParts;
+        //The index of the filled partition
+        const size_t _partIdx;
+        //True if only one partition is filled in
+        const bool _isPartial;
         //The tokens delimiter in the string to parse
         const char _delim;
 
@@ -91,22 +124,6 @@ namespace ngrams {
          * @param orig the other builder to copy
          */
         NGramBuilder(const NGramBuilder& orig);
-
-        /**
-         * Tokenise a given string into avector of strings
-         * @param s the string to tokenise
-         * @param delim the delimiter
-         * @param elems the output array
-         */
-        static inline void tokenize(const std::string &data, const char delim, vector<string> & elems) {
-            stringstream stream(data);
-            string token;
-
-            //Read from the string stream
-            while(getline(stream, token, delim)) {
-                elems.push_back(token);
-            }
-        }
     };
 }
 }
@@ -0,0 +1,115 @@
+/* 
+ * File:   NodeHashMap.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:05 PM
+ */
+
+#ifndef NODEHASHMAP_HPP
+#define	NODEHASHMAP_HPP
+
+#include <cstddef>        // size_t
+#include <unordered_map>  // std::unordered_map
+
+#include "MemoryUtils.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * This is a thin wrapper around the node based unordered_map giving it the
+     * interface of the AdaptiveMap, so that the maps are interchangeable in the
+     * tries. Every key/value pair is stored in its own heap allocated node.
+     * @param TKey the key type
+     * @param TValue the value type
+     */
+    template<typename TKey, typename TValue>
+    class NodeHashMap {
+    public:
+        //The type of the wrapped map
+        typedef unordered_map<TKey, TValue> TMap;
+
+        /**
+         * Gets the value of the given key, inserts a new value initialized value if needed
+         * @param key the key to look for
+         * @return the reference to the value
+         */
+        inline TValue & operator[](const TKey & key) {
+            return _map[key];
+        }
+
+        /**
+         * Looks up the value of the given key
+         * @param key the key to look for
+         * @return the pointer to the value or NULL if the key is not present
+         */
+        inline const TValue * find(const TKey & key) const {
+            typename TMap::const_iterator found = _map.find(key);
+            return (found != _map.end()) ? &found->second : NULL;
+        }
+
+        /**
+         * Allows to get the number of stored pairs
+         * @return the number of stored pairs
+         */
+        inline size_t size() const {
+            return _map.size();
+        }
+
+        /**
+         * Calls the given function for all the stored pairs, in no particular order
+         * @param func the function to call with the key and the value as arguments
+         */
+        template<typename TFunction>
+        inline void forEach(TFunction func) const {
+            for (typename TMap::const_iterator it = _map.begin(); it != _map.end(); ++it) {
+                func(it->first, it->second);
+            }
+        }
+
+        /**
+         * Adds up the heap memory used by the map, not including the map object itself
+         * @param entries the bytes of the key/value pairs
+         * @param buckets the bytes of the bucket array
+         * @param nodes the bytes of the node overhead
+         */
+        inline void addHeapBytes(size_t & entries, size_t & buckets, size_t & nodes) const {
+            entries += _map.size() * sizeof (typename TMap::value_type);
+            buckets += memory::getHashMapBucketBytes(_map);
+            nodes += _map.size() * memory::getHashMapNodeOverheadBytes<TMap>();
+        }
+
+        /**
+         * Removes all the pairs from the map
+         */
+        void clear() {
+            _map.clear();
+        }
+
+    private:
+        //The wrapped map
+        TMap _map;
+    };
+}
+
+#endif	/* NODEHASHMAP_HPP */
+
@@ -0,0 +1,124 @@
+/* 
+ * File:   ProcessBuilder.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 06:05 PM
+ */
+
+#ifndef PROCESSBUILDER_HPP
+#define	PROCESSBUILDER_HPP
+
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * This is the multi-process, map-reduce style, builder of the trie counts.
+     * The training file is split into byte ranges aligned to the line beginnings,
+     * @see TrieBuilder::seekRange, and every range is counted by a separate builder
+     * process, the program itself started with the --build-range option. Every
+     * process writes its partial counts file, @see TrieSegment, and the partial
+     * files are then merged into one counts file that can be loaded into any trie.
+     * So the build is not limited by the address space and the allocator of one
+     * process. A failed range process is restarted, the other ranges are kept.
+     * The output of a range process goes into the "<partial file>.log" file which
+     * is kept if the process fails.
+     * Note: On Linux the builder processes run /proc/self/exe, elsewhere the
+     *       given program executable name is used.
+     * @param N - the maximum level of the considered N-gram, i.e. the N value
+     */
+    template<TTrieSize N>
+    class ProcessBuilder {
+    public:
+
+        /**
+         * The basic constructor
+         * @param exeName the program executable, used if /proc/self/exe is not available
+         * @param trainFileName the training file name
+         * @param dirName the directory to write the partial counts files into
+         * @param numProcesses the number of builder processes, i.e. the file ranges, must be > 0
+         * @throws Exception in case the number of processes is zero
+         */
+        ProcessBuilder(const string & exeName, const string & trainFileName,
+                       const string & dirName, const size_t numProcesses) throw (Exception);
+
+        /**
+         * Runs the builder processes, waits for them, restarts the failed ones
+         * up to BUILD_RANGE_ATTEMPTS times, and merges their partial counts
+         * files into the given counts file, the partial files are removed.
+         * @param countsFileName the counts file to write
+         * @throws Exception in case a range failed all its attempts or the counts could not be merged
+         */
+        void build(const string & countsFileName) throw (Exception);
+
+        /**
+         * Counts the N-grams of one range of the training file and writes them
+         * into the partial counts file, this is what a builder process does
+         * @param trainFileName the training file name
+         * @param rangeIdx the range index, 0 <= rangeIdx < numRanges
+         * @param numRanges the number of ranges the file is split into
+         * @param countsFileName the partial counts file to write
+         * @throws Exception in case the training file can not be read or the counts file written
+         */
+        static void buildRange(const string & trainFileName, const size_t rangeIdx,
+                               const size_t numRanges, const string & countsFileName) throw (Exception);
+
+        /**
+         * Merges the counts files into one counts file, the files are merged
+         * pairwise in a balanced way so every N-gram is re-written about log2(K)
+         * times. The merged files are kept, the output may be one of them.
+         * @param fileNames the counts files to merge, must not be empty
+         * @param countsFileName the counts file to write
+         * @throws Exception in case a counts file is not valid or the output can not be written
+         */
+        static void mergeCounts(const vector<string> & fileNames, const string & countsFileName) throw (Exception);
+
+    private:
+        //The program executable
+        const string _exeName;
+        //The training file name
+        const string _trainFileName;
+        //The number of builder processes
+        const size_t _numProcesses;
+        //The partial counts file names, one per range
+        vector<string> _partFileNames;
+
+        /**
+         * Starts the builder process for the given range
+         * @param rangeIdx the range index
+         * @return the process id
+         * @throws Exception in case the process can not be started
+         */
+        int startRange(const size_t rangeIdx) throw (Exception);
+
+        //The copy constructor is made private as we do not intend to copy this class objects
+        ProcessBuilder(const ProcessBuilder & orig);
+    };
+}
+
+#endif	/* PROCESSBUILDER_HPP */
+
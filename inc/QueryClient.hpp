@@ -0,0 +1,96 @@
+/* 
+ * File:   QueryClient.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:10 PM
+ */
+
+#ifndef QUERYCLIENT_HPP
+#define	QUERYCLIENT_HPP
+
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "ATrie.hpp"
+#include "QueryProtocol.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace server {
+
+        /**
+         * This is the client of the N-gram frequency query server, see
+         * QueryServer. It sends batches of N-grams and waits for their
+         * frequencies over one Unix domain socket connection.
+         * @param N - the maximum level of the considered N-gram, i.e. the N value
+         */
+        template<TTrieSize N>
+        class QueryClient {
+        public:
+            /**
+             * The basic constructor, connects to the server
+             * @param socketPath the server's Unix domain socket file path
+             * @throws Exception if the server can not be connected
+             */
+            QueryClient(const string & socketPath) throw (Exception);
+
+            /**
+             * Queries the server for the frequencies of the given N-grams
+             * @param ngrams the N-grams, each of them has exactly N words
+             * @param first the index of the first N-gram to query
+             * @param count the number of N-grams to query, they are taken
+             *              cyclically starting from the first one
+             * @param freqs the vector to put the N-gram frequencies into, is resized
+             *              to count, the frequencies are as in ATrie::queryNGramFreqs
+             * @throws Exception if the server connection fails
+             */
+            void query(const vector< vector<string> > & ngrams, const size_t first, const size_t count,
+                       vector< SFrequencyResult<N> > & freqs) throw (Exception);
+
+            virtual ~QueryClient();
+
+        private:
+            //The server connection socket
+            int _fd;
+            //The next request identifier
+            uint32_t _requestId;
+            //The request and response buffer
+            vector<char> _buffer;
+
+            /**
+             * Receives exactly the given number of bytes
+             * @param data the buffer to receive into
+             * @param size the number of bytes to receive
+             * @throws Exception if the server connection fails
+             */
+            void receive(char * data, const size_t size) throw (Exception);
+
+            //The copy constructor
+            QueryClient(const QueryClient& orig);
+        };
+    }
+}
+
+#endif	/* QUERYCLIENT_HPP */
+
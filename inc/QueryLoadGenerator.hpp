@@ -0,0 +1,99 @@
+/* 
+ * File:   QueryLoadGenerator.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:35 PM
+ */
+
+#ifndef QUERYLOADGENERATOR_HPP
+#define	QUERYLOADGENERATOR_HPP
+
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <fstream>      // std::ifstream
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "QueryClient.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace server {
+
+        /**
+         * This is the load generator for the N-gram frequency query server.
+         * It reads the N-gram queries from the test file and sends them in
+         * batches to the server over several concurrent connections. Every
+         * connection sends its next request once the previous one is answered.
+         * The throughput and the request latency percentiles are reported.
+         * @param N - the maximum level of the considered N-gram, i.e. the N value
+         */
+        template<TTrieSize N>
+        class QueryLoadGenerator {
+        public:
+            /**
+             * The basic constructor
+             * @param socketPath the server's Unix domain socket file path
+             * @param numConnections the number of concurrent connections, must be positive
+             * @param numRequests the total number of requests to send, must be positive
+             * @param batchSize the number of N-grams in one request, must be positive
+             * @throws Exception if one of the numbers is zero
+             */
+            QueryLoadGenerator(const string & socketPath, const size_t numConnections,
+                               const size_t numRequests, const size_t batchSize) throw (Exception);
+
+            /**
+             * Reads the N-grams from the test file and runs the load test
+             * @param testFile the file with one N-gram per line
+             * @throws Exception if the test file is empty or the server fails
+             */
+            void run(ifstream & testFile) throw (Exception);
+
+            virtual ~QueryLoadGenerator();
+
+        private:
+            //The server's socket file path
+            const string _socketPath;
+            //The number of concurrent connections
+            const size_t _numConnections;
+            //The total number of requests
+            const size_t _numRequests;
+            //The number of N-grams per request
+            const size_t _batchSize;
+
+            /**
+             * Sends the requests over one connection and measures their latencies
+             * @param ngrams the N-grams to query
+             * @param connIdx the connection index
+             * @param latencies the vector to put the request latencies into, in seconds
+             */
+            void sendRequests(const vector< vector<string> > & ngrams, const size_t connIdx,
+                              vector<double> & latencies) throw (Exception);
+
+            //The copy constructor
+            QueryLoadGenerator(const QueryLoadGenerator& orig);
+        };
+    }
+}
+
+#endif	/* QUERYLOADGENERATOR_HPP */
+
@@ -0,0 +1,150 @@
+/* 
+ * File:   QueryProtocol.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 01:05 PM
+ */
+
+#ifndef QUERYPROTOCOL_HPP
+#define	QUERYPROTOCOL_HPP
+
+#include <stdint.h>     // uint16_t, uint32_t
+#include <cstring>      // std::memcpy
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace server {
+
+        //The maximum length of the query frame body, in bytes
+        #define MAX_QUERY_FRAME_LENGTH (16u * 1024u * 1024u)
+
+        /**
+         * This is the header of a query server protocol frame. Both the
+         * request and the response frames start with it. The frames are
+         * sent over a local socket so the native byte order is used.
+         * A request body consists of count N-grams, each N-gram is N words
+         * and each word is a uint16_t length followed by the word's bytes.
+         * A response body consists of count*N TFrequencySize values, the
+         * frequencies of every requested N-gram in the order of
+         * ATrie::queryNGramFreqs.
+         */
+        typedef struct {
+            //The length of the frame body, without the header, in bytes
+            uint32_t length;
+            //The request identifier, is copied from the request into the response
+            uint32_t requestId;
+            //The number of N-grams in the frame
+            uint32_t count;
+        } SFrameHeader;
+
+        //The size of the frame header in bytes
+        static const size_t FRAME_HEADER_SIZE = sizeof (SFrameHeader);
+
+        /**
+         * Reads the frame header from the beginning of the given buffer
+         * @param data the buffer with at least FRAME_HEADER_SIZE bytes
+         * @param header the header to fill in
+         * @throws Exception if the frame body is too long
+         */
+        inline void readFrameHeader(const char * data, SFrameHeader & header) throw (Exception) {
+            memcpy(&header, data, FRAME_HEADER_SIZE);
+            if (header.length > MAX_QUERY_FRAME_LENGTH) {
+                throw Exception("The query frame is too long!");
+            }
+        }
+
+        /**
+         * Computes the response frame body length for the given number of N-grams
+         * @param count the number of N-grams in the request
+         * @param N the number of words in the N-gram
+         * @return the response frame body length in bytes
+         * @throws Exception if the response frame body would be too long
+         */
+        inline uint32_t getResponseLength(const size_t count, const TTrieSize N) throw (Exception) {
+            if (count > (MAX_QUERY_FRAME_LENGTH / (N * sizeof (TFrequencySize)))) {
+                throw Exception("The query response is too long!");
+            }
+            return count * N * sizeof (TFrequencySize);
+        }
+
+        /**
+         * Appends the frame header to the given buffer
+         * @param buffer the buffer to append to
+         * @param header the header to write
+         */
+        inline void appendFrameHeader(vector<char> & buffer, const SFrameHeader & header) {
+            const char * data = reinterpret_cast<const char *> (&header);
+            buffer.insert(buffer.end(), data, data + FRAME_HEADER_SIZE);
+        }
+
+        /**
+         * Appends one N-gram to the request frame body
+         * @param buffer the buffer to append to
+         * @param ngram the N-gram words
+         * @throws Exception if one of the words is too long
+         */
+        inline void appendRequestNGram(vector<char> & buffer, const vector<string> & ngram) throw (Exception) {
+            for (size_t idx = 0; idx < ngram.size(); idx++) {
+                if (ngram[idx].size() > UINT16_MAX) {
+                    throw Exception("The query word is too long!");
+                }
+                const uint16_t len = ngram[idx].size();
+                const char * data = reinterpret_cast<const char *> (&len);
+                buffer.insert(buffer.end(), data, data + sizeof (len));
+                buffer.insert(buffer.end(), ngram[idx].begin(), ngram[idx].end());
+            }
+        }
+
+        /**
+         * Reads one N-gram from the request frame body
+         * @param data the current position in the frame body, is moved past the N-gram
+         * @param end the end of the frame body
+         * @param N the number of words in the N-gram
+         * @param ngram the N-gram words to fill in, N strings
+         * @throws Exception if the frame body is malformed
+         */
+        inline void readRequestNGram(const char * & data, const char * const end,
+                                     const TTrieSize N, string * ngram) throw (Exception) {
+            for (TTrieSize idx = 0; idx < N; idx++) {
+                uint16_t len;
+                if ((end - data) < (ptrdiff_t) sizeof (len)) {
+                    throw Exception("The query frame is truncated!");
+                }
+                memcpy(&len, data, sizeof (len));
+                data += sizeof (len);
+                if ((end - data) < (ptrdiff_t) len) {
+                    throw Exception("The query frame is truncated!");
+                }
+                ngram[idx].assign(data, len);
+                data += len;
+            }
+        }
+    }
+}
+
+#endif	/* QUERYPROTOCOL_HPP */
+
@@ -0,0 +1,217 @@
+/* 
+ * File:   QueryServer.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 01:20 PM
+ */
+
+#ifndef QUERYSERVER_HPP
+#define	QUERYSERVER_HPP
+
+#include <string>               // std::string
+#include <vector>               // std::vector
+#include <deque>                // std::deque
+#include <map>                  // std::map
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <memory>               // std::shared_ptr
+#include <atomic>               // std::atomic
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "ATrie.hpp"
+#include "QueryProtocol.hpp"
+
+using namespace std;
+
+namespace tries {
+    namespace server {
+
+        /**
+         * This is the long-running N-gram frequency query server. It serves
+         * the batched frequency requests, see QueryProtocol.hpp, over a local
+         * Unix domain socket. The connections are handled by one epoll event
+         * loop thread which reads the request frames and puts them into the
+         * queue of a worker pool. The workers query the trie and send the
+         * responses. The trie is only read so it must be filled in before.
+         * The server runs until it is stopped or gets SIGINT or SIGTERM.
+         * Note: The server is only available on Linux.
+         * @param N - the maximum level of the considered N-gram, i.e. the N value
+         * @param doCache - the trie's query caching flag
+         */
+        template<TTrieSize N, bool doCache>
+        class QueryServer {
+        public:
+            /**
+             * The basic constructor
+             * @param trie the filled in trie to serve the queries from
+             * @param socketPath the Unix domain socket file path, an existing file is removed
+             * @param numWorkers the number of worker threads, must be positive
+             * @throws Exception if the number of workers is zero
+             */
+            QueryServer(ATrie<N, doCache> & trie, const string & socketPath, const size_t numWorkers) throw (Exception);
+
+            /**
+             * Starts the server and serves the queries until stop() is called
+             * or the SIGINT or SIGTERM signal is received.
+             * @throws Exception if the socket can not be created
+             */
+            void run() throw (Exception);
+
+            /**
+             * Asks the running server to stop, is safe to call from any thread
+             */
+            void stop();
+
+            virtual ~QueryServer();
+
+        private:
+
+            /**
+             * This structure stores the client connection data
+             */
+            typedef struct {
+                //The connection socket
+                int fd;
+                //The received and not yet processed data
+                vector<char> input;
+                //The response data not yet sent, guarded by the mutex
+                vector<char> output;
+                //The mutex guarding the output and the closed flag
+                mutex guard;
+                //True if the socket is closed
+                bool isClosed;
+                //True if the event loop has to wait for the socket to become writable
+                bool isWaiting;
+            } SConnection;
+
+            typedef shared_ptr<SConnection> TConnectionPtr;
+
+            /**
+             * This structure stores one request to be processed by a worker
+             */
+            typedef struct {
+                //The connection to respond to
+                TConnectionPtr connection;
+                //The request frame header
+                SFrameHeader header;
+                //The request frame body
+                vector<char> body;
+            } SRequest;
+
+            //The trie to query
+            ATrie<N, doCache> & _trie;
+            //The socket file path
+            const string _socketPath;
+            //The number of worker threads
+            const size_t _numWorkers;
+
+            //The listening socket, the epoll and the wake up event descriptors
+            int _listenFd;
+            int _epollFd;
+            int _wakeFd;
+
+            //The stop flag
+            atomic<bool> _isStopping;
+
+            //The open connections by their socket descriptors
+            map<int, TConnectionPtr> _connections;
+
+            //The queue of the requests to process and its synchronization
+            deque<SRequest> _requests;
+            mutex _requestsGuard;
+            condition_variable _requestsCond;
+
+            /**
+             * The event loop, accepts the connections and reads the requests
+             * @throws Exception if the events can not be waited for, std::bad_alloc
+             *         if the connection buffers can not be grown
+             */
+            void serveEvents();
+
+            /**
+             * The worker thread function, processes the queued requests
+             */
+            void processRequests();
+
+            /**
+             * Answers one request and sends the response
+             * @param request the request to answer
+             * @param words the buffer for the N-gram words
+             * @param hashes the buffer for the N-gram word hashes
+             * @param freqs the buffer for the N-gram frequencies
+             * @throws Exception if the request is malformed, std::bad_alloc if the
+             *         buffers for a large request can not be allocated
+             */
+            void answerRequest(SRequest & request, vector<string> & words, vector<TWordHashSize> & hashes,
+                               vector< SFrequencyResult<N> > & freqs);
+
+            /**
+             * Accepts all the pending client connections
+             */
+            void acceptConnections();
+
+            /**
+             * Reads the available data from the connection and queues the complete requests
+             * @param connection the connection to read from
+             * @return false if the connection is to be closed, otherwise true
+             */
+            bool readRequests(const TConnectionPtr & connection);
+
+            /**
+             * Sends as much of the output data as possible, the connection must be locked
+             * @param connection the connection to send the data to
+             * @return false if the connection is broken, otherwise true
+             */
+            bool sendOutput(SConnection & connection);
+
+            /**
+             * Sets the epoll events the connection is waited for
+             * @param connection the connection
+             * @param isWriting true if the connection is also waited to become writable
+             */
+            void watchConnection(SConnection & connection, const bool isWriting);
+
+            /**
+             * Closes the connection and forgets about it
+             * @param connection the connection to close
+             */
+            void closeConnection(const TConnectionPtr & connection);
+
+            /**
+             * Wakes up the event loop
+             */
+            void wakeUp();
+
+            /**
+             * Releases the sockets and the other descriptors
+             */
+            void release();
+
+            //The copy constructor
+            QueryServer(const QueryServer& orig);
+        };
+    }
+}
+
+#endif	/* QUERYSERVER_HPP */
+
@@ -0,0 +1,272 @@
+/* 
+ * File:   SegmentedTrie.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:55 PM
+ */
+
+#ifndef SEGMENTEDTRIE_HPP
+#define	SEGMENTEDTRIE_HPP
+
+#include <vector>               // std::vector
+#include <string>               // std::string
+#include <memory>               // std::shared_ptr
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <atomic>               // std::atomic
+
+#include "ATrie.hpp"
+#include "HashMapTrie.hpp"
+#include "TrieSegment.hpp"
+#include "Globals.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * This is a segmented ITrie interface implementation class, an LSM tree
+     * of the N-gram counts. The N-grams are counted in an in-memory HashMapTrie.
+     * Once it holds the given number of N-grams it is flushed into an immutable
+     * on-disk segment, @see TrieSegment, and a fresh in-memory trie is started.
+     * This way the memory stays bounded however large the corpus is. The
+     * frequencies of the queried N-grams are summed up over the in-memory
+     * trie and all the segments.
+     * A background thread merges the two smallest segments once there are
+     * SEGMENT_MERGE_FACTOR of them, so the number of segments to query stays small.
+     * The in-memory trie is flushed at the line boundaries, i.e. in addWords.
+     * This keeps the N-grams of every segment suffix closed.
+     * Note: Adding the N-grams and querying them are not to be done concurrently,
+     *       the merges run concurrently with both of them.
+     */
+    template<TTrieSize N, bool doCache>
+    class SegmentedTrie final : public ATrie<N, doCache> {
+    public:
+        //The in-memory trie type
+        typedef HashMapTrie<N, doCache> TMemTrie;
+        //The segment type
+        typedef TrieSegment<N> TSegment;
+        //The trie is its own only partition
+        typedef SegmentedTrie TPartition;
+
+        /**
+         * The basic class constructor
+         * @param dirName the directory to store the segment files in
+         * @param maxMemNGrams the maximum number of N-grams in the in-memory trie, must be > 0
+         * @throws Exception in case the maximum number of N-grams is zero
+         */
+        SegmentedTrie(const string & dirName, const size_t maxMemNGrams) throw (Exception);
+
+        /**
+         * Flushes the in-memory trie first if it is full
+         * For more details @see ITrie
+         */
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) {
+            if (getNumMemNGrams() >= _maxMemNGrams) {
+                flush();
+            }
+            _memTrie->addWords(tokens, hashes);
+        }
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int idx, const int n) {
+            _memTrie->addNGram(tokens, hashes, idx, n);
+        }
+
+        /**
+         * Adds the frequency in the in-memory trie, it is not flushed here
+         * For more details @see ITrie
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception) {
+            _memTrie->addNGramFreq(ngram, hashes, freq);
+        }
+
+        /**
+         * Returns the trie itself, as its concrete type
+         * For more details @see ITrie
+         */
+        virtual SegmentedTrie & getPartition(const size_t idx) {
+            return *this;
+        }
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void resetQueryCache() {
+            _memTrie->resetQueryCache();
+        }
+
+        /**
+         * Is not supported as the segments are not indexed by the last word
+         * For more details @see ITrie
+         */
+        virtual void queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception);
+
+        /**
+         * Is not supported as the segments are not indexed by the last word
+         * For more details @see ITrie
+         */
+        virtual SFrequencyResult<N> & queryWordFreqs(const string & word) throw (Exception);
+
+        /**
+         * Sums up the frequencies from the in-memory trie and all the segments
+         * For more details @see ITrie
+         */
+        virtual void queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs);
+
+        /**
+         * Compacts the in-memory trie, the segments are compact already
+         * For more details @see ITrie
+         */
+        virtual void compact() throw (Exception) {
+            _memTrie->compact();
+        }
+
+        /**
+         * Gives the memory usage of the in-memory trie, the memory mapped
+         * segment files are counted as the other memory
+         * For more details @see ITrie
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * Writes the in-memory trie into a new segment and starts a new in-memory trie
+         * @throws Exception in case the segment can not be written
+         */
+        void flush() throw (Exception);
+
+        /**
+         * Adds the existing segment file, e.g. a saved trie, to the trie. The file
+         * is used as it is and is not removed, even once it is merged.
+         * @param fileName the segment file name
+         * @throws Exception in case the file is not a valid segment
+         */
+        void attachSegment(const string & fileName) throw (Exception);
+
+        /**
+         * Saves the trie into one segment file: the in-memory trie is flushed
+         * and all the segments are merged into the given file
+         * @param fileName the segment file name
+         * @throws Exception in case the file can not be written
+         */
+        void save(const string & fileName) throw (Exception);
+
+        /**
+         * Allows to get the current number of segments
+         * @return the number of segments
+         */
+        inline size_t getNumSegments() const {
+            return atomic_load(&_segments)->size();
+        }
+
+        virtual ~SegmentedTrie();
+
+    private:
+        //The list of segments type
+        typedef vector< shared_ptr<TSegment> > TSegments;
+
+        //The directory of the segment files
+        const string _dirName;
+
+        //The maximum number of the in-memory trie N-grams
+        const size_t _maxMemNGrams;
+
+        //The in-memory trie
+        TMemTrie * _memTrie;
+
+        //The current segments, is replaced as a whole so that the queries
+        //can take a snapshot of it while the merge thread is working
+        shared_ptr<const TSegments> _segments;
+
+        //The index of the next segment file
+        atomic<size_t> _nextSegmentIdx;
+
+        //The mutex guarding the segments' replacement and the merge condition
+        mutex _segmentsMutex;
+
+        //The condition the merge thread waits on for new segments
+        condition_variable _mergeCondition;
+
+        //The flag indicating that the merge thread is to stop
+        bool _isStopping;
+
+        //The background merge thread
+        thread _merger;
+
+        /**
+         * The copy constructor, is made private as we do not intend to copy this class objects
+         * @param orig the object to copy from
+         */
+        SegmentedTrie(const SegmentedTrie& orig);
+
+        /**
+         * Allows to get the number of N-grams in the in-memory trie
+         * @return the number of N-grams of all levels
+         */
+        inline size_t getNumMemNGrams() const {
+            size_t count = 0;
+            for (TTrieSize L = 1; L <= N; L++) {
+                count += _memTrie->getNumNGrams(L);
+            }
+            return count;
+        }
+
+        /**
+         * Gives the name of the new segment file
+         * @return the segment file name
+         */
+        string getNextSegmentName();
+
+        /**
+         * Opens the temporary segment file, it is removed once no longer used
+         * @param fileName the segment file name
+         * @return the segment
+         * @throws Exception in case the file is not a valid segment
+         */
+        static inline shared_ptr<TSegment> openTempSegment(const string & fileName) throw (Exception) {
+            shared_ptr<TSegment> segment(new TSegment(fileName));
+            segment->setRemoveFile(true);
+            return segment;
+        }
+
+        /**
+         * Adds the segment to the trie
+         * @param segment the segment to add
+         * @param merged the merged segments to be replaced with the new one, may be empty
+         */
+        void addSegment(const shared_ptr<TSegment> & segment, const TSegments & merged);
+
+        /**
+         * The body of the background merge thread
+         */
+        void runMerger();
+    };
+
+    typedef SegmentedTrie<N_GRAM_PARAM, true> TFiveCacheSegmentedTrie;
+    typedef SegmentedTrie<N_GRAM_PARAM, false> TFiveNoCacheSegmentedTrie;
+}
+
+#endif	/* SEGMENTEDTRIE_HPP */
+
@@ -0,0 +1,226 @@
+/* 
+ * File:   ShardedTrie.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 11:40 AM
+ */
+
+#ifndef SHARDEDTRIE_HPP
+#define	SHARDEDTRIE_HPP
+
+#include <vector>  //std::vector
+#include <string>  //std::string
+
+#include "ATrie.hpp"
+#include "HashMapTrie.hpp"
+#include "Globals.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * This is a sharded ITrie interface implementation class. It partitions the
+     * words and the N-grams into K independent HashMapTrie shards by the hash
+     * of the N-gram's last word. This is the word the N-gram queries start from
+     * so every query is answered by exactly one shard. The shards do not share
+     * any data, so they can be filled in concurrently without any locking,
+     * see TrieBuilder, and can later be placed on different NUMA nodes.
+     * Note: Every shard gives its own ids to the words and contexts, the context
+     *       words of the shard's N-grams get ids there but are not counted.
+     */
+    template<TTrieSize N, bool doCache>
+    class ShardedTrie final : public ATrie<N, doCache> {
+    public:
+        //The shard trie type
+        typedef HashMapTrie<N, doCache> TShard;
+        //The shards are the partitions
+        typedef TShard TPartition;
+
+        /**
+         * The basic class constructor
+         * @param numShards the number of shards, must be > 0
+         * @throws Exception in case the number of shards is zero
+         */
+        explicit ShardedTrie(const size_t numShards = DEFAULT_NUMBER_OF_SHARDS) throw (Exception);
+
+        /**
+         * Routes the words to their shards
+         * For more details @see ITrie
+         */
+        virtual void addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes);
+
+        /**
+         * Routes the N-gram to the shard of its last word
+         * For more details @see ITrie
+         */
+        virtual void addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int idx, const int n);
+
+        /**
+         * Does re-set the internal query caches of all shards
+         * For more details @see ITrie
+         */
+        virtual void resetQueryCache();
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception);
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual SFrequencyResult<N> & queryWordFreqs(const string & word) throw (Exception);
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs);
+
+        /**
+         * Sums up the memory usage of the shards, the replicated words and prefix
+         * entries are reported as the replicas and not as the N-grams
+         * For more details @see ITrie
+         */
+        virtual void getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * Every shard has its own hot regions, their sizes and counters are added up
+         * For more details @see ITrie
+         */
+        virtual void setHotRegionCounting(const bool isCounting) throw (Exception);
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual void getHotRegionStatistics(SHotRegionStatistics<N> & stats) const throw (Exception);
+
+        /**
+         * The frequency is added in the shard of the N-gram's last word
+         * For more details @see ITrie
+         */
+        virtual void addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                  const TFrequencySize freq) throw (Exception) {
+            shards[getPartitionIndex(hashes.back())]->addNGramFreq(ngram, hashes, freq);
+        }
+
+        /**
+         * The N-grams are counted over the shards, the words are counted in their own shards only
+         * and the zero frequency prefix entries of the other shards' N-grams are not counted
+         * For more details @see ITrie
+         */
+        virtual size_t getNumNGrams(const TTrieSize L) const throw (Exception);
+
+        /**
+         * Every N-gram is stored in the shard of its last word only. The other
+         * shards may know the word as the N-gram context, so the 1-grams are
+         * visited in their own shards only.
+         * For more details @see ITrie
+         */
+        virtual void visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception);
+
+        /**
+         * Every chunk is made of the same chunk of every shard, the words and the
+         * prefix entries replicated for the other shards' N-grams are skipped
+         * For more details @see ITrie
+         */
+        virtual void visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                      const TNGramVisitor & visitor) const throw (Exception);
+
+        /**
+         * Builds the continuation indexes of the shards one by one
+         * For more details @see ITrie
+         */
+        virtual void buildContinuations() throw (Exception);
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual bool hasContinuations() const {
+            return shards[0]->hasContinuations();
+        }
+
+        /**
+         * The continuations of a context are spread over the shards of their
+         * last words, so the top k continuations of every shard are merged
+         * For more details @see ITrie
+         */
+        virtual void topContinuations(const vector<string> & context, const vector<TWordHashSize> & hashes,
+                                      const size_t k, vector<TContinuation> & result) const throw (Exception);
+
+        /**
+         * Goes over the matching N-grams of the shards one shard after another, an N-gram
+         * has a non zero frequency in the shard of its last word only, so it is found once
+         * For more details @see ITrie
+         */
+        virtual unique_ptr<ANGramCursor> findNGrams(const vector<string> & pattern, const vector<TWordHashSize> & hashes) const throw (Exception);
+
+        /**
+         * Compacts the shards one by one, so that the peak memory stays low
+         * For more details @see ITrie
+         */
+        virtual void compact() throw (Exception);
+
+        /**
+         * The shards are the partitions
+         * For more details @see ITrie
+         */
+        virtual size_t getNumPartitions() const {
+            return shards.size();
+        }
+
+        /**
+         * Returns the shard, as its concrete type
+         * For more details @see ITrie
+         */
+        virtual TShard & getPartition(const size_t idx) {
+            return *shards[idx];
+        }
+
+        /**
+         * For more details @see ITrie
+         */
+        virtual size_t getPartitionIndex(const TWordHashSize hash) const {
+            return ATrie<N, doCache>::getHashPartitionIndex(hash, shards.size());
+        }
+
+        virtual ~ShardedTrie();
+
+    private:
+        //The shards of the trie
+        vector<TShard *> shards;
+
+        //The cursor going over the shards' cursors, @see findNGrams
+        class NGramShardsCursor;
+
+        /**
+         * The copy constructor, is made private as we do not intend to copy this class objects
+         * @param orig the object to copy from
+         */
+        ShardedTrie(const ShardedTrie& orig);
+    };
+
+    typedef ShardedTrie<N_GRAM_PARAM, true> TFiveCacheShardedTrie;
+    typedef ShardedTrie<N_GRAM_PARAM, false> TFiveNoCacheShardedTrie;
+}
+
+#endif	/* SHARDEDTRIE_HPP */
+
@@ -0,0 +1,97 @@
+/* 
+ * File:   TextTokenizer.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 11:05 AM
+ */
+
+#ifndef TEXTTOKENIZER_HPP
+#define	TEXTTOKENIZER_HPP
+
+#include <string>  //std::string
+#include <vector>  //std::vector
+
+#include "Globals.hpp"
+
+using namespace std;
+
+namespace tries {
+namespace ngrams {
+
+    /**
+     * This class is the ingestion kernel that splits the text lines into tokens
+     * and computes the tokens' word hashes. The delimiter positions are found
+     * 32 bytes at a time with AVX2 or 16 bytes at a time with SSE2, the kernel
+     * is selected at runtime based on the CPU features, with a scalar fallback.
+     * The token hashes are computed for several tokens in parallel lanes.
+     * This class is a trivial singleton with static methods only.
+     */
+    class TextTokenizer {
+    public:
+        //The delimiter search kernel function type, it must append the tokens of the
+        //given data to the vector following the same rules as the tokenize function
+        typedef void (*TSplitFunction)(const char * data, const size_t len, const char delim, vector<string> & tokens);
+
+        /**
+         * Tokenise a given string into a vector of strings and compute their hashes.
+         * The tokens are the same as the ones given by the getline on a string
+         * stream, i.e. two consecutive delimiters give an empty token, and the
+         * trailing empty token is dropped. The new tokens and their hashes are
+         * appended to the end of the given vectors.
+         * @param data the string to tokenise
+         * @param delim the delimiter
+         * @param tokens the output array of tokens
+         * @param hashes the output array of token hashes, @see computeMurmur64Hash
+         */
+        static void tokenize(const string & data, const char delim,
+                             vector<string> & tokens, vector<hashing::TWordHashSize> & hashes);
+
+        /**
+         * Allows to get the name of the delimiter search kernel used on this CPU
+         * @return the kernel name
+         */
+        static const char * getKernelName();
+
+    private:
+        //The number of tokens hashed in parallel
+        static const uint8_t NUM_HASH_LANES = 4;
+
+        //The selected kernel function and its name
+        static const TSplitFunction splitFunction;
+        static const char * const splitFunctionName;
+
+        TextTokenizer() {}
+        TextTokenizer(const TextTokenizer & orig) {}
+        virtual ~TextTokenizer() {}
+
+        /**
+         * Computes the hashes of the tokens with the given indexes, in parallel lanes
+         * @param tokens the tokens
+         * @param begin the index of the first token to hash
+         * @param hashes the out array to append the hashes to
+         */
+        static void hashTokens(const vector<string> & tokens, const size_t begin, vector<hashing::TWordHashSize> & hashes);
+    };
+}
+}
+
+#endif	/* TEXTTOKENIZER_HPP */
+
@@ -27,8 +27,13 @@
 #define	TRIEBUILDER_HPP
 
 #include <fstream>      // std::ifstream
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <limits>       // std::numeric_limits
 
 #include "ATrie.hpp"
+#include "TextTokenizer.hpp"
+#include "Logger.hpp"
 
 using namespace std;
 
@@ -36,8 +41,11 @@ namespace tries {
     /**
      * This is the Trie builder class that reads an input file stream
      * and creates n-grams and then records them into the provided Trie.
+     * @param N the maximum level of the considered N-gram
+     * @param doCache the query caching flag of the trie
+     * @param TTrie the type of the filled in trie, @see NGramBuilder
      */
-    template<TTrieSize N, bool doCache>
+    template<TTrieSize N, bool doCache, typename TTrie = ATrie<N, doCache> >
     class TrieBuilder {
     public:
         /**
@@ -45,22 +53,97 @@ namespace tries {
          * @param trie the trie to fill in with data from the text corpus
          * @param _fstr the file stream to read from
          * @param delim the delimiter for the line elements
+         * @param maxBytes the maximum number of bytes to read, the lines are read
+         *                 as long as they start within them, @see seekRange
          */
-        TrieBuilder(ATrie<N,doCache> & trie, ifstream & _fstr, const char delim);
+        TrieBuilder(TTrie & trie, ifstream & _fstr, const char delim,
+                    const size_t maxBytes = numeric_limits<size_t>::max());
 
         /**
-         * This function will read from the file and build the trie
+         * Splits the file into the given number of byte ranges of about the same
+         * size, moved to the line beginnings, and positions the stream at the
+         * beginning of the range with the given index. Every line belongs to the
+         * range it starts in, so the ranges build the same trie as the whole file.
+         * @param fstr the file stream, positioned at the file beginning
+         * @param rangeIdx the range index, 0 <= rangeIdx < numRanges
+         * @param numRanges the number of ranges
+         * @return the number of bytes in the range, the maximum bytes for the builder
+         * @throws Exception in case the range index is out of bounds or the file can not be read
          */
-        void build();
+        static size_t seekRange(ifstream & fstr, const size_t rangeIdx, const size_t numRanges) throw (Exception);
+
+        /**
+         * This function will read from the file and build the trie.
+         * If the trie is partitioned then its partitions are filled
+         * in concurrently, @see ATrie::getNumPartitions, if the trie
+         * is thread safe then it is filled in by several threads at
+         * once, @see ATrie::getNumBuildThreads
+         */
+        void build() throw (Exception);
 
         virtual ~TrieBuilder();
     private:
         //The reference to the trie to be build
-        ATrie<N,doCache> & _trie;
+        TTrie & _trie;
         //The reference to the input file with text corpus
         ifstream & _fstr;
         //The delimiter for the line elements
         const char _delim;
+        //The maximum number of bytes to read
+        const size_t _maxBytes;
+        //The number of bytes read so far
+        size_t _numBytes;
+
+        /**
+         * Reads the next line of the file, if it is not beyond the maximum number of bytes
+         * @param line the string to put the line into
+         * @return true if the line was read, otherwise false
+         */
+        inline bool readLine(string & line) {
+            if ((_numBytes < _maxBytes) && getline(_fstr, line)) {
+                LOG_DEBUG << line << END_LOG;
+                _numBytes += line.size() + 1;
+                Logger::updateProgressBar(line.size() + 1);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Gives the position of the first line beginning at or after the given position
+         * @param fstr the file stream
+         * @param pos the position in the file
+         * @param fileBytes the number of bytes in the file
+         * @return the line beginning position, the file size if there is no more line
+         */
+        static size_t getLineStart(ifstream & fstr, const size_t pos, const size_t fileBytes);
+
+        /**
+         * Reads the file line by line and puts all the N-grams into the trie
+         */
+        void buildSequential();
+
+        /**
+         * Reads the file in batches of lines. Each batch is first tokenized
+         * by several threads and then each trie partition is filled in by its
+         * own thread. The partitions are disjoint so no locking is needed.
+         */
+        void buildPartitioned() throw (Exception);
+
+        /**
+         * Reads the file in batches of lines. Each batch is first tokenized by
+         * several threads, then the trie makes room for the batch's tokens and
+         * the same threads add the words and N-grams of their lines into it.
+         */
+        void buildConcurrent() throw (Exception);
+
+        /**
+         * Reads the next batch of lines from the file
+         * @param lines the vector to put the lines into, is cleared first
+         * @param maxLines the maximum number of lines to read
+         * @return true if at least one line was read, otherwise false
+         */
+        bool readBatch(vector<string> & lines, const size_t maxLines);
 
         /**
          * The copy constructor
@@ -0,0 +1,141 @@
+/* 
+ * File:   TrieDumper.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 06:05 PM
+ */
+
+#ifndef TRIEDUMPER_HPP
+#define	TRIEDUMPER_HPP
+
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <utility>      // std::pair
+
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+#include "ATrie.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    /**
+     * The N-gram count statistics of one trie level
+     */
+    typedef struct {
+        //The number of the distinct N-grams, i.e. the types
+        size_t types;
+        //The sum of the N-gram frequencies, i.e. the tokens
+        size_t tokens;
+        //The number of the N-grams of the frequency c is at the index c - 1, for
+        //1 <= c <= DUMP_COUNT_OF_COUNTS, the last one is for the higher frequencies
+        size_t countOfCounts[DUMP_COUNT_OF_COUNTS + 1];
+    } SLevelCountStats;
+
+    /**
+     * This is the parallel dumper of the trie counts. Every level is split into
+     * chunks of at most DUMP_CHUNK_NGRAMS N-grams, @see ATrie::visitNGramsChunk,
+     * and the chunks of all the levels are taken by the dumper threads one by one.
+     * A thread recovers the words of its chunk's N-grams, sorts them in memory and
+     * writes them into the "<dir>/ngrams-<L>-<chunk>.txt" file, one "word1 ... wordL
+     * <TAB> frequency" line per N-gram. The chunk files are sorted by the byte
+     * order of the lines, so the chunk files of a level can be merged into one
+     * sorted file with "LC_ALL=C sort -m". The N-grams of the zero frequency are
+     * not dumped, e.g. the ones loaded from an ARPA file.
+     * Along the way the per-level types, tokens and count-of-counts are computed,
+     * they are written into the "<dir>/statistics.txt" file.
+     * Note: The trie must not be changed while it is dumped.
+     * @param N - the maximum level of the considered N-gram, i.e. the N value
+     * @param doCache - the trie's query caching flag
+     */
+    template<TTrieSize N, bool doCache>
+    class TrieDumper {
+    public:
+
+        /**
+         * The basic constructor
+         * @param trie the trie to dump
+         * @param dirName the existing directory to write the files into
+         * @param numThreads the number of the dumper threads
+         * @throws Exception if the number of threads is zero
+         */
+        TrieDumper(const ATrie<N, doCache> & trie, const string & dirName, const size_t numThreads) throw (Exception);
+
+        /**
+         * Dumps the trie counts and computes their statistics
+         * @throws Exception if the trie can not be iterated over or a file can not be written
+         */
+        void dump() throw (Exception);
+
+        /**
+         * Allows to get the statistics of the given level, computed by dump
+         * @param L the N-gram level, 1 <= L <= N
+         * @return the level statistics
+         */
+        inline const SLevelCountStats & getStatistics(const TTrieSize L) const {
+            return _stats[L - 1];
+        }
+
+        virtual ~TrieDumper();
+
+    private:
+        //The trie to dump
+        const ATrie<N, doCache> & _trie;
+        //The directory to write the files into
+        const string _dirName;
+        //The number of the dumper threads
+        const size_t _numThreads;
+        //The statistics of the levels
+        SLevelCountStats _stats[N];
+
+        //The copy constructor
+        TrieDumper(const TrieDumper& orig);
+
+        /**
+         * Gives the name of the given chunk file
+         * @param L the N-gram level
+         * @param chunkIdx the chunk index
+         * @return the chunk file name
+         */
+        string getChunkFileName(const TTrieSize L, const size_t chunkIdx) const;
+
+        /**
+         * Dumps one chunk of the given level and adds up its statistics
+         * @param L the N-gram level
+         * @param chunkIdx the chunk index
+         * @param numChunks the number of chunks of the level
+         * @param stats the level statistics to add to
+         * @throws Exception if the chunk file can not be written
+         */
+        void dumpChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                       SLevelCountStats & stats) const throw (Exception);
+
+        /**
+         * Writes the computed statistics into the statistics file
+         * @throws Exception if the file can not be written
+         */
+        void writeStatistics() const throw (Exception);
+    };
+}
+
+#endif	/* TRIEDUMPER_HPP */
+
@@ -0,0 +1,124 @@
+/* 
+ * File:   TriePolicies.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:35 PM
+ */
+
+#ifndef TRIEPOLICIES_HPP
+#define	TRIEPOLICIES_HPP
+
+#include <string>  // std::string
+
+#include "Globals.hpp"
+#include "HashingUtils.hpp"
+#include "AdaptiveMap.hpp"
+#include "NodeHashMap.hpp"
+#include "FlatHashMap.hpp"
+
+using namespace std;
+using namespace hashing;
+
+namespace tries {
+
+    //The command line names of the hash policies
+    #define MURMUR_HASH_VALUE "murmur"
+    #define DJB2_HASH_VALUE "djb2"
+    #define PRIMES_HASH_VALUE "primes"
+    #define HASH_OPTION_VALUES "{" MURMUR_HASH_VALUE ", " DJB2_HASH_VALUE ", " PRIMES_HASH_VALUE "}"
+
+    //The command line names of the map policies
+    #define ADAPTIVE_MAP_VALUE "adaptive"
+    #define NODE_MAP_VALUE "node"
+    #define FLAT_MAP_VALUE "flat"
+    #define MAP_OPTION_VALUES "{" ADAPTIVE_MAP_VALUE ", " NODE_MAP_VALUE ", " FLAT_MAP_VALUE "}"
+
+    /**
+     * The hash policies define the dictionary keys of the words. A policy gets
+     * the word and its 64 bit Murmur hash, as computed by the TextTokenizer, and
+     * returns the word's key. The policies are static so there is no dispatch cost.
+     */
+
+    /**
+     * The 64 bit Murmur hash policy, the given hash is used as is
+     */
+    struct MurmurHashPolicy {
+
+        static inline TWordHashSize getHash(const string & word, const TWordHashSize hash) {
+            return hash;
+        }
+    };
+
+    /**
+     * The 32 bit djb2 hash policy, the word is hashed again, @see computeDjb2Hash
+     */
+    struct Djb2HashPolicy {
+
+        static inline TWordHashSize getHash(const string & word, const TWordHashSize hash) {
+            return computeDjb2Hash(word);
+        }
+    };
+
+    /**
+     * The 32 bit primes hash policy, the word is hashed again, @see computePrimesHash
+     */
+    struct PrimesHashPolicy {
+
+        static inline TWordHashSize getHash(const string & word, const TWordHashSize hash) {
+            return computePrimesHash(word);
+        }
+    };
+
+    /**
+     * The map policies define the map types of the trie: the dictionary map from
+     * the word keys to the word ids and the level maps from the context ids to the
+     * N-gram entries, one per word and N-gram level. All the maps have the
+     * interface of the AdaptiveMap.
+     */
+
+    /**
+     * The default policy: the node map for the dictionary and the adaptive
+     * maps, inline stored pairs for the few contexts, for the levels
+     */
+    struct AdaptiveMapPolicy {
+        template<typename TKey, typename TValue> using TWordMap = NodeHashMap<TKey, TValue>;
+        template<typename TKey, typename TValue> using TLevelMap = AdaptiveMap<TKey, TValue>;
+    };
+
+    /**
+     * The node map policy: all the maps are node based unordered maps
+     */
+    struct NodeMapPolicy {
+        template<typename TKey, typename TValue> using TWordMap = NodeHashMap<TKey, TValue>;
+        template<typename TKey, typename TValue> using TLevelMap = NodeHashMap<TKey, TValue>;
+    };
+
+    /**
+     * The flat map policy: all the maps are open addressing flat maps
+     */
+    struct FlatMapPolicy {
+        template<typename TKey, typename TValue> using TWordMap = FlatHashMap<TKey, TValue>;
+        template<typename TKey, typename TValue> using TLevelMap = FlatHashMap<TKey, TValue>;
+    };
+}
+
+#endif	/* TRIEPOLICIES_HPP */
+
@@ -0,0 +1,304 @@
+/* 
+ * File:   TrieSegment.hpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:10 PM
+ */
+
+#ifndef TRIESEGMENT_HPP
+#define	TRIESEGMENT_HPP
+
+#include <stdint.h>   // uint32_t, uint64_t
+#include <string>     // std::string
+#include <vector>     // std::vector
+#include <fstream>    // std::ofstream
+#include <utility>    // std::pair
+#include <cstring>    // std::memcmp
+#include <algorithm>  // std::min
+
+#include "ATrie.hpp"
+#include "Globals.hpp"
+#include "Exceptions.hpp"
+
+using namespace std;
+
+namespace tries {
+
+    //The magic string at the beginning of the segment files
+    #define TRIE_SEGMENT_MAGIC "NGRMSEG1"
+
+    /**
+     * This is an immutable on-disk segment of the N-gram counts, @see SegmentedTrie.
+     * The segment file is memory mapped and has the following layout:
+     *   1. The header with the level N, the number of N-grams per level and
+     *      the size of the dictionary text;
+     *   2. The dictionary: the words are sorted and their index is their id
+     *      in the segment, there are the word offsets into the text, the word
+     *      frequencies and the text of the concatenated words;
+     *   3. The levels 2 to N: the fixed size records of the L word ids and
+     *      the frequency, sorted by the word ids.
+     * Since the dictionary is sorted, merging two dictionaries preserves the
+     * order of the word ids. So two segments are merged by one streaming pass
+     * over their levels, @see merge.
+     * The N-grams of a segment are suffix closed, i.e. the suffixes of every
+     * stored N-gram are stored too. This holds because the N-grams are counted
+     * per corpus line, and the union of two suffix closed sets is suffix closed.
+     * The segment files are written into a temporary file which is then renamed,
+     * so a segment file can be re-written while it is still mapped by another
+     * segment.
+     * Note: The segment files use the native byte order.
+     * @param N the maximum level of the considered N-gram
+     */
+    template<TTrieSize N>
+    class TrieSegment {
+    public:
+
+        /**
+         * Opens and memory maps the given segment file
+         * @param fileName the segment file name
+         * @throws Exception in case the file can not be opened or is not a valid segment
+         */
+        TrieSegment(const string & fileName) throw (Exception);
+
+        /**
+         * Writes the N-grams of the given trie into a new segment file,
+         * the N-grams with zero frequency are skipped
+         * @param fileName the segment file name
+         * @param trie the trie supporting the N-gram iteration
+         * @throws Exception in case the file can not be written
+         */
+        template<bool doCache>
+        static void write(const string & fileName, const ATrie<N, doCache> & trie) throw (Exception);
+
+        /**
+         * Merges the two segments into a new segment file, the frequencies
+         * of the N-grams present in both of them are summed up
+         * @param fileName the new segment file name
+         * @param first the first segment to merge
+         * @param second the second segment to merge
+         * @throws Exception in case the file can not be written
+         */
+        static void merge(const string & fileName, const TrieSegment & first, const TrieSegment & second) throw (Exception);
+
+        /**
+         * Adds all the stored N-grams with their frequencies to the given trie,
+         * @see ATrie::addNGramFreq, this is how a saved trie is loaded
+         * @param trie the trie to add the N-grams to
+         * @throws Exception in case the trie does not support adding the frequencies
+         */
+        template<bool doCache>
+        void addTo(ATrie<N, doCache> & trie) const throw (Exception);
+
+        /**
+         * Adds the segment's frequencies of the given N-gram and its suffixes
+         * to the given frequencies, @see ATrie::queryNGramFreqs
+         * @param ngram the N-gram words
+         * @param freqs the frequencies to add to
+         */
+        void addNGramFreqs(const vector<string> & ngram, SFrequencyResult<N> & freqs) const;
+
+        /**
+         * Allows to get the number of the stored N-grams of the given level
+         * @param L the N-gram level, 1 <= L <= N
+         * @return the number of the stored L-grams
+         */
+        inline size_t getNumNGrams(const TTrieSize L) const {
+            return _header->numNGrams[L - 1];
+        }
+
+        /**
+         * Allows to get the segment file size
+         * @return the file size in bytes
+         */
+        inline size_t getFileBytes() const {
+            return _fileBytes;
+        }
+
+        /**
+         * Allows to get the segment file name
+         * @return the file name
+         */
+        inline const string & getFileName() const {
+            return _fileName;
+        }
+
+        /**
+         * Allows to request removing the segment file when the segment is destroyed
+         * @param isRemoveFile true if the file is to be removed
+         */
+        inline void setRemoveFile(const bool isRemoveFile) {
+            _isRemoveFile = isRemoveFile;
+        }
+
+        /**
+         * Un-maps the segment file and removes it if requested
+         */
+        virtual ~TrieSegment();
+
+    private:
+        //The segment record value type, the word ids and the frequencies are stored as it
+        typedef uint32_t TRecordValue;
+
+        //The word reference type: the pointer to the word characters and the word length
+        typedef pair<const char *, size_t> TWordRef;
+
+        //The segment file header
+        typedef struct {
+            //The magic string, @see TRIE_SEGMENT_MAGIC
+            char magic[8];
+            //The maximum level of the stored N-grams
+            uint64_t level;
+            //The number of N-grams per level, the 1-grams are the words
+            uint64_t numNGrams[N];
+            //The number of the dictionary text bytes
+            uint64_t textBytes;
+        } SHeader;
+
+        //The value of the missing word id
+        static const TRecordValue UNKNOWN_WORD;
+
+        //The segment file name
+        const string _fileName;
+
+        //The flag indicating the file is to be removed in the destructor
+        bool _isRemoveFile;
+
+        //The segment file size
+        size_t _fileBytes;
+
+        //The mapped segment file data
+        void * _data;
+
+        //The segment header, points into the mapped data
+        const SHeader * _header;
+
+        //The words' text offsets, there is one extra offset
+        const uint64_t * _wordOffsets;
+
+        //The words' frequencies
+        const TRecordValue * _wordFreqs;
+
+        //The words' text
+        const char * _text;
+
+        //The level records, index L-1 is for the level L, 2 <= L <= N
+        const TRecordValue * _levels[N];
+
+        /**
+         * The copy constructor, is made private as we do not intend to copy this class objects
+         * @param orig the object to copy from
+         */
+        TrieSegment(const TrieSegment& orig);
+
+        /**
+         * Gets the reference to the word with the given id
+         * @param wordId the word id
+         * @return the word reference
+         */
+        inline TWordRef getWord(const TRecordValue wordId) const {
+            return make_pair(_text + _wordOffsets[wordId], _wordOffsets[wordId + 1] - _wordOffsets[wordId]);
+        }
+
+        /**
+         * Looks up the id of the given word by the binary search in the dictionary
+         * @param word the word to look for
+         * @return the word id or UNKNOWN_WORD if the word is not present
+         */
+        TRecordValue findWord(const string & word) const;
+
+        /**
+         * Looks up the record of the given level's N-gram by the binary search
+         * @param L the N-gram level, 2 <= L <= N
+         * @param wordIds the N-gram's word ids
+         * @return the pointer to the record or NULL if the N-gram is not present
+         */
+        const TRecordValue * findRecord(const TTrieSize L, const TRecordValue * wordIds) const;
+
+        /**
+         * Compares two N-grams given by their word ids
+         * @param first the first N-gram's word ids
+         * @param second the second N-gram's word ids
+         * @param L the N-gram level
+         * @return negative, zero or positive if the first N-gram is smaller, equal or larger
+         */
+        static inline int compareIds(const TRecordValue * first, const TRecordValue * second, const TTrieSize L) {
+            for (TTrieSize idx = 0; idx < L; idx++) {
+                if (first[idx] != second[idx]) {
+                    return (first[idx] < second[idx]) ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+        /**
+         * Compares two words in the lexicographical order of their bytes
+         * @param first the first word
+         * @param second the second word
+         * @return negative, zero or positive if the first word is smaller, equal or larger
+         */
+        static inline int compareWords(const TWordRef & first, const TWordRef & second) {
+            const int cmp = memcmp(first.first, second.first, min(first.second, second.second));
+            if (cmp != 0) {
+                return cmp;
+            }
+            return (first.second < second.second) ? -1 : ((first.second > second.second) ? 1 : 0);
+        }
+
+        /**
+         * Writes the header and the dictionary of a new segment
+         * @param out the segment file stream
+         * @param header the header, the number of 1-grams and the text bytes are set here
+         * @param words the sorted words
+         * @param freqs the words' frequencies
+         */
+        static void writeDictionary(ofstream & out, SHeader & header, const vector<TWordRef> & words,
+                                    const vector<TRecordValue> & freqs);
+
+        /**
+         * Gives the temporary file name the segment is written into
+         * @param fileName the segment file name
+         * @return the temporary file name
+         */
+        static inline string getTempFileName(const string & fileName) {
+            return fileName + ".tmp";
+        }
+
+        /**
+         * Opens the new segment's temporary file for writing
+         * @param out the segment file stream
+         * @param fileName the segment file name
+         * @throws Exception in case the file can not be opened
+         */
+        static void openFile(ofstream & out, const string & fileName) throw (Exception);
+
+        /**
+         * Re-writes the header of the new segment, closes the temporary file and renames it
+         * @param out the segment file stream
+         * @param fileName the segment file name
+         * @param header the header with the final N-gram counts
+         * @throws Exception in case the file can not be written
+         */
+        static void closeFile(ofstream & out, const string & fileName, const SHeader & header) throw (Exception);
+    };
+}
+
+#endif	/* TRIESEGMENT_HPP */
+
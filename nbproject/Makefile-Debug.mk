@@ -35,11 +35,26 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/src/ArpaReader.o \
+	${OBJECTDIR}/src/ArpaWriter.o \
+	${OBJECTDIR}/src/ConcurrentTrie.o \
+	${OBJECTDIR}/src/EliasFano.o \
+	${OBJECTDIR}/src/EliasFanoTrie.o \
 	${OBJECTDIR}/src/HashMapTrie.o \
+	${OBJECTDIR}/src/LargePages.o \
 	${OBJECTDIR}/src/Logger.o \
 	${OBJECTDIR}/src/NGramBuilder.o \
+	${OBJECTDIR}/src/ProcessBuilder.o \
+	${OBJECTDIR}/src/QueryClient.o \
+	${OBJECTDIR}/src/QueryLoadGenerator.o \
+	${OBJECTDIR}/src/QueryServer.o \
+	${OBJECTDIR}/src/SegmentedTrie.o \
+	${OBJECTDIR}/src/ShardedTrie.o \
 	${OBJECTDIR}/src/StatisticsMonitor.o \
+	${OBJECTDIR}/src/TextTokenizer.o \
 	${OBJECTDIR}/src/TrieBuilder.o \
+	${OBJECTDIR}/src/TrieDumper.o \
+	${OBJECTDIR}/src/TrieSegment.o \
 	${OBJECTDIR}/src/main.o
 
 
@@ -47,8 +62,8 @@ OBJECTFILES= \
 CFLAGS=
 
 # CC Compiler Flags
-CCFLAGS=-std=c++0x
-CXXFLAGS=-std=c++0x
+CCFLAGS=-std=c++0x -pthread
+CXXFLAGS=-std=c++0x -pthread
 
 # Fortran Compiler Flags
 FFLAGS=
@@ -65,13 +80,43 @@ LDLIBSOPTIONS=
 
 ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/automated-translation-tries: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
-	g++ -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/automated-translation-tries ${OBJECTFILES} ${LDLIBSOPTIONS} -lrt
+	g++ -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/automated-translation-tries ${OBJECTFILES} ${LDLIBSOPTIONS} -lrt -pthread
+
+${OBJECTDIR}/src/ArpaReader.o: src/ArpaReader.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ArpaReader.o src/ArpaReader.cpp
+
+${OBJECTDIR}/src/ArpaWriter.o: src/ArpaWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ArpaWriter.o src/ArpaWriter.cpp
+
+${OBJECTDIR}/src/ConcurrentTrie.o: src/ConcurrentTrie.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ConcurrentTrie.o src/ConcurrentTrie.cpp
+
+${OBJECTDIR}/src/EliasFano.o: src/EliasFano.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/EliasFano.o src/EliasFano.cpp
+
+${OBJECTDIR}/src/EliasFanoTrie.o: src/EliasFanoTrie.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/EliasFanoTrie.o src/EliasFanoTrie.cpp
 
 ${OBJECTDIR}/src/HashMapTrie.o: src/HashMapTrie.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/HashMapTrie.o src/HashMapTrie.cpp
 
+${OBJECTDIR}/src/LargePages.o: src/LargePages.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/LargePages.o src/LargePages.cpp
+
 ${OBJECTDIR}/src/Logger.o: src/Logger.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -82,16 +127,61 @@ ${OBJECTDIR}/src/NGramBuilder.o: src/NGramBuilder.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/NGramBuilder.o src/NGramBuilder.cpp
 
+${OBJECTDIR}/src/ProcessBuilder.o: src/ProcessBuilder.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ProcessBuilder.o src/ProcessBuilder.cpp
+
+${OBJECTDIR}/src/QueryClient.o: src/QueryClient.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/QueryClient.o src/QueryClient.cpp
+
+${OBJECTDIR}/src/QueryLoadGenerator.o: src/QueryLoadGenerator.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/QueryLoadGenerator.o src/QueryLoadGenerator.cpp
+
+${OBJECTDIR}/src/QueryServer.o: src/QueryServer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/QueryServer.o src/QueryServer.cpp
+
+${OBJECTDIR}/src/SegmentedTrie.o: src/SegmentedTrie.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/SegmentedTrie.o src/SegmentedTrie.cpp
+
+${OBJECTDIR}/src/ShardedTrie.o: src/ShardedTrie.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ShardedTrie.o src/ShardedTrie.cpp
+
 ${OBJECTDIR}/src/StatisticsMonitor.o: src/StatisticsMonitor.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StatisticsMonitor.o src/StatisticsMonitor.cpp
 
+${OBJECTDIR}/src/TextTokenizer.o: src/TextTokenizer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/TextTokenizer.o src/TextTokenizer.cpp
+
 ${OBJECTDIR}/src/TrieBuilder.o: src/TrieBuilder.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/TrieBuilder.o src/TrieBuilder.cpp
 
+${OBJECTDIR}/src/TrieDumper.o: src/TrieDumper.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/TrieDumper.o src/TrieDumper.cpp
+
+${OBJECTDIR}/src/TrieSegment.o: src/TrieSegment.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -Werror -Iinc -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/TrieSegment.o src/TrieSegment.cpp
+
 ${OBJECTDIR}/src/main.o: src/main.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
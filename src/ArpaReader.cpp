@@ -0,0 +1,284 @@
+/* 
+ * File:   ArpaReader.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:40 PM
+ */
+
+#include "ArpaReader.hpp"
+
+#include <cstdlib>      // std::strtof, std::atoi
+#include <sstream>      // std::stringstream
+#include <thread>       // std::thread
+#include <functional>   // std::ref
+
+#include "Logger.hpp"
+#include "HashingUtils.hpp"
+
+namespace tries {
+    namespace arpa {
+
+        using hashing::computeMurmur64Hash;
+
+        //The ARPA file markers
+        static const string DATA_MARKER = "\\data\\";
+        static const string END_MARKER = "\\end\\";
+        static const string NGRAM_COUNT_PREFIX = "ngram ";
+        static const string SECTION_SUFFIX = "-grams:";
+
+        /**
+         * Allows to check if the character is an ARPA field separator
+         * @param chr the character
+         * @return true for a space or a tab, otherwise false
+         */
+        static inline bool isSeparator(const char chr) {
+            return (chr == ' ') || (chr == '\t');
+        }
+
+        template<TTrieSize N, bool doCache>
+        ArpaReader<N, doCache>::ArpaReader(ATrie<N, doCache> & trie, ifstream & fstr, const size_t numThreads) throw (Exception)
+        : _trie(trie), _fstr(fstr), _numThreads(numThreads), _level(0), _isEnd(false) {
+            if (numThreads == 0) {
+                throw Exception("The number of ARPA parsing threads must be positive!");
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        ArpaReader<N, doCache>::ArpaReader(const ArpaReader& orig)
+        : _trie(orig._trie), _fstr(orig._fstr), _numThreads(orig._numThreads) {
+        }
+
+        template<TTrieSize N, bool doCache>
+        ArpaReader<N, doCache>::~ArpaReader() {
+        }
+
+        template<TTrieSize N, bool doCache>
+        TTrieSize ArpaReader<N, doCache>::parseSectionLevel(const string & line) throw (Exception) {
+            const size_t suffixPos = line.size() - min(line.size(), SECTION_SUFFIX.size());
+            const int level = atoi(line.c_str() + 1);
+            if ((level <= 0) || line.compare(suffixPos, SECTION_SUFFIX.size(), SECTION_SUFFIX)) {
+                throw Exception("Malformed ARPA section header: " + line);
+            }
+            return level;
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaReader<N, doCache>::readHeader() throw (Exception) {
+            //Skip everything before the data marker
+            string line;
+            while (getline(_fstr, line) && line.compare(DATA_MARKER)) {
+            }
+            if (!_fstr) {
+                throw Exception("The ARPA file has no " + DATA_MARKER + " marker!");
+            }
+
+            //Read the N-gram counts up to the first section
+            while (getline(_fstr, line)) {
+                if (line.empty()) {
+                    continue;
+                }
+                if (line[0] == '\\') {
+                    _level = parseSectionLevel(line);
+                    return;
+                }
+                const size_t eqPos = line.find('=');
+                if (line.compare(0, NGRAM_COUNT_PREFIX.size(), NGRAM_COUNT_PREFIX) || (eqPos == string::npos)) {
+                    throw Exception("Malformed ARPA header line: " + line);
+                }
+                const size_t level = atoi(line.c_str() + NGRAM_COUNT_PREFIX.size());
+                if (level >= _expected.size()) {
+                    _expected.resize(level + 1, 0);
+                }
+                _expected[level] = strtoull(line.c_str() + eqPos + 1, NULL, 10);
+                LOG_DEBUG << "ARPA header: " << _expected[level] << " " << level << "-grams" << END_LOG;
+            }
+            throw Exception("The ARPA file has no N-gram sections!");
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaReader<N, doCache>::readBatch(SArpaBatch & batch) throw (Exception) {
+            batch.lines.clear();
+            batch.levels.clear();
+
+            string line;
+            while (!_isEnd && (batch.lines.size() < ARPA_READ_BATCH_LINES)) {
+                if (!getline(_fstr, line)) {
+                    LOG_WARNING << "The ARPA file has no " << END_MARKER << " marker!" << END_LOG;
+                    _isEnd = true;
+                    break;
+                }
+                Logger::updateProgressBar(line.size() + 1);
+                if (line.empty()) {
+                    continue;
+                }
+                if (line[0] == '\\') {
+                    if (!line.compare(END_MARKER)) {
+                        _isEnd = true;
+                    } else {
+                        _level = parseSectionLevel(line);
+                    }
+                    continue;
+                }
+                batch.lines.push_back(line);
+                batch.levels.push_back(_level);
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaReader<N, doCache>::parseBatch(SArpaBatch & batch, const size_t first) {
+            for (size_t idx = first; idx < batch.lines.size(); idx += _numThreads) {
+                const TTrieSize level = batch.levels[idx];
+                SArpaEntry & entry = batch.entries[idx];
+                entry.words.clear();
+                entry.hashes.clear();
+                if (level > N) {
+                    continue;
+                }
+
+                //The line is: log10 probability, the N-gram words, optional log10 back-off
+                const char * data = batch.lines[idx].c_str();
+                char * end;
+                entry.prob = strtof(data, &end);
+                bool isGood = (end != data);
+                data = end;
+                for (TTrieSize pos = 0; isGood && (pos < level); pos++) {
+                    while (isSeparator(*data)) {
+                        data++;
+                    }
+                    const char * word = data;
+                    while ((*data != '\0') && !isSeparator(*data)) {
+                        data++;
+                    }
+                    isGood = (data != word);
+                    entry.words.push_back(string(word, data - word));
+                    entry.hashes.push_back(computeMurmur64Hash(word, data - word));
+                }
+                while (isSeparator(*data)) {
+                    data++;
+                }
+                entry.backoff = 0.0;
+                if (isGood && (*data != '\0')) {
+                    entry.backoff = strtof(data, &end);
+                    isGood = (end != data);
+                }
+
+                if (!isGood) {
+                    batch.errors[first] = "Malformed ARPA N-gram line: " + batch.lines[idx];
+                    return;
+                }
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaReader<N, doCache>::addBatch(SArpaBatch & batch) throw (Exception) {
+            for (size_t idx = 0; idx < _numThreads; idx++) {
+                if (!batch.errors[idx].empty()) {
+                    throw Exception(batch.errors[idx]);
+                }
+            }
+            for (size_t idx = 0; idx < batch.lines.size(); idx++) {
+                const TTrieSize level = batch.levels[idx];
+                if (level >= _actual.size()) {
+                    _actual.resize(level + 1, 0);
+                }
+                _actual[level]++;
+                if (level <= N) {
+                    SArpaEntry & entry = batch.entries[idx];
+                    _trie.addNGramProb(entry.words, entry.hashes, entry.prob, entry.backoff);
+                }
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaReader<N, doCache>::read() throw (Exception) {
+            LOG_DEBUG << "Starting to read the ARPA file with " << _numThreads << " parsing threads ..." << END_LOG;
+            Logger::startProgressBar(Logger::getRemainingBytes(_fstr));
+
+            try {
+                readHeader();
+
+                //The batches are used in turns: one is parsed, the
+                //previous one is put into the trie, the next one is read
+                const size_t NUM_BATCHES = 3;
+                SArpaBatch batches[NUM_BATCHES];
+
+                size_t curr = 0;
+                bool hasPrev = false;
+                readBatch(batches[curr]);
+                while (!batches[curr].lines.empty()) {
+                    SArpaBatch & batch = batches[curr];
+                    batch.entries.resize(batch.lines.size());
+                    batch.errors.assign(_numThreads, string());
+
+                    vector<thread> parsers;
+                    for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+                        parsers.push_back(thread(&ArpaReader<N, doCache>::parseBatch, this, ref(batch), thIdx));
+                    }
+                    try {
+                        if (hasPrev) {
+                            addBatch(batches[(curr + NUM_BATCHES - 1) % NUM_BATCHES]);
+                        }
+                        readBatch(batches[(curr + 1) % NUM_BATCHES]);
+                    } catch (...) {
+                        for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+                            parsers[thIdx].join();
+                        }
+                        throw;
+                    }
+                    for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+                        parsers[thIdx].join();
+                    }
+
+                    hasPrev = true;
+                    curr = (curr + 1) % NUM_BATCHES;
+                }
+                if (hasPrev) {
+                    addBatch(batches[(curr + NUM_BATCHES - 1) % NUM_BATCHES]);
+                }
+            } catch (...) {
+                //Stop the progress ticker thread before leaving
+                Logger::stopProgressBar();
+                throw;
+            }
+
+            Logger::stopProgressBar();
+
+            //Check the N-gram counts against the header
+            for (size_t level = 1; level < max(_expected.size(), _actual.size()); level++) {
+                const size_t expected = (level < _expected.size()) ? _expected[level] : 0;
+                const size_t actual = (level < _actual.size()) ? _actual[level] : 0;
+                if (expected != actual) {
+                    LOG_WARNING << "The ARPA header gives " << expected << " " << level
+                            << "-grams but there are " << actual << END_LOG;
+                }
+                if ((level > N) && (actual > 0)) {
+                    LOG_WARNING << "Skipped " << actual << " " << level << "-grams, the trie level is " << N << END_LOG;
+                }
+            }
+
+            LOG_DEBUG << "Done reading the ARPA file." << END_LOG;
+        }
+
+        //Make sure that there will be templates instantiated, at least for the given parameter values
+        template class ArpaReader<N_GRAM_PARAM, true>;
+        template class ArpaReader<N_GRAM_PARAM, false>;
+    }
+}
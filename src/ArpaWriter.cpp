@@ -0,0 +1,90 @@
+/* 
+ * File:   ArpaWriter.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 05:25 PM
+ */
+
+#include "ArpaWriter.hpp"
+
+#include <limits>       // std::numeric_limits
+
+#include "Logger.hpp"
+
+namespace tries {
+    namespace arpa {
+
+        template<TTrieSize N, bool doCache>
+        ArpaWriter<N, doCache>::ArpaWriter(ATrie<N, doCache> & trie, ofstream & fstr) : _trie(trie), _fstr(fstr) {
+        }
+
+        template<TTrieSize N, bool doCache>
+        ArpaWriter<N, doCache>::ArpaWriter(const ArpaWriter& orig) : _trie(orig._trie), _fstr(orig._fstr) {
+        }
+
+        template<TTrieSize N, bool doCache>
+        ArpaWriter<N, doCache>::~ArpaWriter() {
+        }
+
+        template<TTrieSize N, bool doCache>
+        void ArpaWriter<N, doCache>::write() throw (Exception) {
+            if (!_trie.hasProbs()) {
+                throw Exception("The probabilities are not computed, there is nothing to write into the ARPA file!");
+            }
+
+            //Write the probabilities without loss of precision
+            _fstr.precision(numeric_limits<TLogProbSize>::max_digits10);
+
+            //Write the header
+            _fstr << "\\data\\" << "\n";
+            for (TTrieSize L = 1; L <= N; L++) {
+                _fstr << "ngram " << L << "=" << _trie.getNumNGrams(L) << "\n";
+            }
+
+            //Write the N-grams of every level, the highest level has no back-off weights
+            for (TTrieSize L = 1; L <= N; L++) {
+                LOG_DEBUG << "Writing the ARPA " << L << "-grams ..." << END_LOG;
+                _fstr << "\n\\" << L << "-grams:\n";
+                ofstream & fstr = _fstr;
+                const bool hasBackoff = (L < N);
+                _trie.visitNGrams(L, [&fstr, hasBackoff](const vector<string> & words, const SNGramData & data) {
+                    fstr << data.prob << '\t' << words[0];
+                    for (size_t idx = 1; idx < words.size(); idx++) {
+                        fstr << ' ' << words[idx];
+                    }
+                    if (hasBackoff) {
+                        fstr << '\t' << data.backoff;
+                    }
+                    fstr << '\n';
+                });
+            }
+            _fstr << "\n\\end\\" << endl;
+
+            if (!_fstr) {
+                throw Exception("Failed to write the ARPA file!");
+            }
+        }
+
+        //Make sure that there will be templates instantiated, at least for the given parameter values
+        template class ArpaWriter<N_GRAM_PARAM, true>;
+        template class ArpaWriter<N_GRAM_PARAM, false>;
+    }
+}
@@ -0,0 +1,174 @@
+/* 
+ * File:   ConcurrentTrie.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 04:25 PM
+ */
+#include "ConcurrentTrie.hpp"
+
+#include <sstream>   //std::stringstream
+
+#include "MemoryUtils.hpp"
+
+namespace tries {
+
+    template<TTrieSize N, bool doCache>
+    const TTrieSize ConcurrentTrie<N, doCache>::MINIMUM_CONTEXT_LEVEL = 2;
+
+    template<TTrieSize N, bool doCache>
+    ConcurrentTrie<N, doCache>::ConcurrentTrie(const size_t numThreads) throw (Exception) : numThreads(numThreads) {
+        if (numThreads == 0) {
+            throw Exception("The number of the concurrent trie threads must be positive!");
+        }
+        //The ids start from one, so reserve the undefined id entries
+        wordsById.resize(1);
+        for (TTrieSize idx = 0; idx < (N - 1); idx++) {
+            contexts[idx].resize(1);
+        }
+        LOG_DEBUG << "Created a concurrent trie for " << numThreads << " threads" << END_LOG;
+    }
+
+    template<TTrieSize N, bool doCache>
+    ConcurrentTrie<N, doCache>::ConcurrentTrie(const ConcurrentTrie& orig) : numThreads(orig.numThreads) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    ConcurrentTrie<N, doCache>::~ConcurrentTrie() {
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::reserve(const size_t numTokens) throw (Exception) {
+        //Every token adds at most one word and starts at most one N-gram of every level
+        words.reserve(numTokens);
+        if (wordsById.size() <= (words.size() + numTokens)) {
+            wordsById.resize(words.size() + numTokens + 1);
+        }
+        for (TTrieSize idx = 0; idx < (N - 1); idx++) {
+            levels[idx].reserve(numTokens);
+            if (contexts[idx].size() <= (levels[idx].size() + numTokens)) {
+                contexts[idx].resize(levels[idx].size() + numTokens + 1);
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::compact() throw (Exception) {
+        words.shrink();
+        wordsById.resize(words.size() + 1);
+        wordsById.shrink_to_fit();
+        for (TTrieSize idx = 0; idx < (N - 1); idx++) {
+            levels[idx].shrink();
+            contexts[idx].resize(levels[idx].size() + 1);
+            contexts[idx].shrink_to_fit();
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
+        throw Exception("The word queries are not supported by the concurrent trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    SFrequencyResult<N> & ConcurrentTrie<N, doCache>::queryWordFreqs(const string & word) throw (Exception) {
+        throw Exception("The word queries are not supported by the concurrent trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                                  const TFrequencySize freq) throw (Exception) {
+        const TTrieSize L = ngram.size();
+        if ((L < 1) || (L > N)) {
+            stringstream msg;
+            msg << "Can not add the frequency of a " << L << "-gram to the " << N << "-gram trie!";
+            throw Exception(msg.str());
+        }
+        reserve(L);
+
+        //Get the N-gram's context the same way as addNGram does
+        TWordSlot & first = getOrCreateWord(ngram[0], hashes[0]);
+        if (L == 1) {
+            first.count.fetch_add(freq, memory_order_relaxed);
+            return;
+        }
+        TContextId context = first.id.load(memory_order_relaxed);
+        for (TTrieSize idx = 1; idx < L; idx++) {
+            const TWordSlot & word = getOrCreateWord(ngram[idx], hashes[idx]);
+            TNGramSlot & entry = getOrCreateEntry(idx + 1, word.id.load(memory_order_relaxed), context);
+            if (idx == L - 1) {
+                entry.count.fetch_add(freq, memory_order_relaxed);
+            } else {
+                context = entry.id.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception) {
+        vector<string> ngram(L);
+        SNGramData ngData = {0, ZERO_LOG_PROB, 0.0};
+        if (L == 1) {
+            words.forEach([&] (const uint64_t key, const TWordId id, const TFrequencySize count) {
+                ngram[0] = wordsById[id];
+                ngData.freq = count;
+                visitor(ngram, ngData);
+            });
+            return;
+        }
+        levels[L - MINIMUM_CONTEXT_LEVEL].forEach([&] (const uint64_t key, const TContextId id, const TFrequencySize count) {
+            //Recover the N-gram words from its id, the last word first
+            TContextId context = id;
+            for (TTrieSize level = L; level >= MINIMUM_CONTEXT_LEVEL; level--) {
+                const SContextEntry & entry = contexts[level - MINIMUM_CONTEXT_LEVEL][context];
+                ngram[level - 1] = wordsById[entry.word];
+                context = entry.context;
+            }
+            ngram[0] = wordsById[context];
+            ngData.freq = count;
+            visitor(ngram, ngData);
+        });
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ConcurrentTrie<N, doCache>::getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+        fill(stats.levels, stats.levels + N, SMemoryUsage());
+        stats.other = sizeof (*this);
+
+        //The 1-grams: the dictionary slots, the word entries and the word strings
+        SMemoryUsage & unigrams = stats.levels[0];
+        unigrams.numNGrams = words.size();
+        unigrams.entries = words.getSlotBytes() + memory::getVectorBytes(wordsById);
+        for (auto it = wordsById.begin(); it != wordsById.end(); ++it) {
+            unigrams.strings += memory::getStringHeapBytes(*it);
+        }
+
+        //The N-grams: the level slots and the context entries
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            SMemoryUsage & usage = stats.levels[L - 1];
+            usage.numNGrams = levels[L - MINIMUM_CONTEXT_LEVEL].size();
+            usage.entries = levels[L - MINIMUM_CONTEXT_LEVEL].getSlotBytes()
+                    + memory::getVectorBytes(contexts[L - MINIMUM_CONTEXT_LEVEL]);
+        }
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class ConcurrentTrie<N_GRAM_PARAM, true>;
+    template class ConcurrentTrie<N_GRAM_PARAM, false>;
+}
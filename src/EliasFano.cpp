@@ -0,0 +1,81 @@
+/* 
+ * File:   EliasFano.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 08:40 PM
+ */
+
+#include "EliasFano.hpp"
+
+namespace tries {
+
+    void EliasFanoSequence::build(const size_t size, const function<uint64_t(const size_t)> & getValue) {
+        _size = size;
+
+        //Choose the number of the low bits as about log2(u / n)
+        const uint64_t universe = (size > 0) ? (getValue(size - 1) + 1) : 0;
+        const uint64_t ratio = (size > 0) ? (universe / size) : 0;
+        _numLowBits = (ratio > 1) ? (getBitWidth(ratio) - 1) : 0;
+        _lowMask = (uint64_t(1) << _numLowBits) - 1;
+        _maxHigh = (size > 0) ? ((universe - 1) >> _numLowBits) : 0;
+
+        //Store the low bits and the high bits in unary
+        const size_t numHighBits = size + _maxHigh + 1;
+        _lowBits.reset(_numLowBits, size);
+        _highBits.assign((numHighBits + 63) / 64, 0);
+        _highBits.shrink_to_fit();
+        for (size_t idx = 0; idx < size; idx++) {
+            const uint64_t value = getValue(idx);
+            _lowBits.set(idx, value & _lowMask);
+            const size_t pos = idx + (value >> _numLowBits);
+            _highBits[pos >> 6] |= uint64_t(1) << (pos & 63);
+        }
+
+        //Sample the positions of every ELIAS_FANO_SELECT_SAMPLE-th one and zero,
+        //count the ones before the rank blocks
+        _onesSamples.clear();
+        _zerosSamples.clear();
+        _blockOnes.clear();
+        size_t numOnes = 0, numZeros = 0;
+        for (size_t wordIdx = 0; wordIdx < _highBits.size(); wordIdx++) {
+            if ((wordIdx % ELIAS_FANO_RANK_BLOCK_WORDS) == 0) {
+                _blockOnes.push_back(numOnes);
+            }
+            const size_t numBits = min<size_t>(64, numHighBits - (wordIdx << 6));
+            const uint64_t bitsMask = (numBits == 64) ? ~uint64_t(0) : ((uint64_t(1) << numBits) - 1);
+            const uint64_t ones = _highBits[wordIdx];
+            const uint64_t zeros = ~ones & bitsMask;
+            const uint32_t wordOnes = __builtin_popcountll(ones);
+            const uint32_t wordZeros = __builtin_popcountll(zeros);
+            while (_onesSamples.size() * ELIAS_FANO_SELECT_SAMPLE < numOnes + wordOnes) {
+                _onesSamples.push_back((wordIdx << 6) + selectInWord(ones, _onesSamples.size() * ELIAS_FANO_SELECT_SAMPLE - numOnes));
+            }
+            while (_zerosSamples.size() * ELIAS_FANO_SELECT_SAMPLE < numZeros + wordZeros) {
+                _zerosSamples.push_back((wordIdx << 6) + selectInWord(zeros, _zerosSamples.size() * ELIAS_FANO_SELECT_SAMPLE - numZeros));
+            }
+            numOnes += wordOnes;
+            numZeros += wordZeros;
+        }
+        _onesSamples.shrink_to_fit();
+        _zerosSamples.shrink_to_fit();
+        _blockOnes.shrink_to_fit();
+    }
+}
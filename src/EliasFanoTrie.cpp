@@ -0,0 +1,240 @@
+/* 
+ * File:   EliasFanoTrie.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 09:05 PM
+ */
+
+#include "EliasFanoTrie.hpp"
+
+#include "Logger.hpp"
+#include "HashingUtils.hpp"
+
+namespace tries {
+
+    template<TTrieSize N, bool doCache>
+    const TTrieSize EliasFanoTrie<N, doCache>::MINIMUM_CONTEXT_LEVEL = 2;
+
+    template<TTrieSize N, bool doCache>
+    const TWordId EliasFanoTrie<N, doCache>::UNKNOWN_WORD = numeric_limits<TWordId>::max();
+
+    template<TTrieSize N, bool doCache>
+    const size_t EliasFanoTrie<N, doCache>::UNKNOWN_NGRAM = numeric_limits<size_t>::max();
+
+    template<TTrieSize N, bool doCache>
+    EliasFanoTrie<N, doCache>::EliasFanoTrie() : _memTrie(new TMemTrie()) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    EliasFanoTrie<N, doCache>::EliasFanoTrie(const EliasFanoTrie & orig) : _memTrie(NULL) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    EliasFanoTrie<N, doCache>::~EliasFanoTrie() {
+        delete _memTrie;
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
+        throw Exception("The word queries are not supported by the Elias-Fano trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    SFrequencyResult<N> & EliasFanoTrie<N, doCache>::queryWordFreqs(const string & word) throw (Exception) {
+        throw Exception("The word queries are not supported by the Elias-Fano trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::compact() throw (Exception) {
+        if (_memTrie == NULL) {
+            return;
+        }
+
+        //Compact the counting trie first, so that its build time maps are released
+        _memTrie->compact();
+
+        vector<TContextId> wordIds;
+        buildDictionary(wordIds);
+        LOG_DEBUG << "The dictionary of " << _wordHashes.size() << " words is built" << END_LOG;
+
+        //The contexts of the 2-grams are the word ids
+        vector<TContextId> contextIds(wordIds), ngramIds;
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            buildLevel(L, wordIds, contextIds, ngramIds);
+            contextIds.swap(ngramIds);
+            LOG_DEBUG << "The level " << L << " of " << _levels[L - MINIMUM_CONTEXT_LEVEL].keys.size()
+                      << " N-grams with " << _levels[L - MINIMUM_CONTEXT_LEVEL].freqs.getNumDistinct()
+                      << " distinct frequencies is built" << END_LOG;
+        }
+
+        delete _memTrie;
+        _memTrie = NULL;
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::buildDictionary(vector<TContextId> & wordIds) {
+        //The word record: the word hash, the word and its frequency
+        typedef struct {
+            TWordHashSize hash;
+            const string * word;
+            TFrequencySize freq;
+            TWordId memId;
+        } SWordRecord;
+
+        //Collect and sort the words by their hashes, the colliding words end up next to each other
+        vector<SWordRecord> records;
+        records.reserve(_memTrie->getNumNGrams(1));
+        _memTrie->forEachWord([&records] (const TWordId wordId, const string & word, const TFrequencySize freq) {
+            SWordRecord record = {computeMurmur64Hash(word), &word, freq, wordId};
+            records.push_back(record);
+        });
+        sort(records.begin(), records.end(), [] (const SWordRecord & first, const SWordRecord & second) {
+            return first.hash < second.hash;
+        });
+
+        //Store the hashes, the words' text and the frequencies in the new order
+        const size_t numWords = records.size();
+        wordIds.assign(numWords + 1, UNKNOWN_WORD);
+        _wordHashes.resize(numWords);
+        vector<uint64_t> offsets(numWords + 1, 0);
+        _wordChars.clear();
+        for (TWordId wordId = 0; wordId < numWords; wordId++) {
+            const SWordRecord & record = records[wordId];
+            wordIds[record.memId] = wordId;
+            _wordHashes[wordId] = record.hash;
+            _wordChars.insert(_wordChars.end(), record.word->begin(), record.word->end());
+            offsets[wordId + 1] = _wordChars.size();
+        }
+        _wordChars.shrink_to_fit();
+        _wordOffsets.build(offsets.size(), [&offsets] (const size_t idx) {
+            return offsets[idx];
+        });
+        _wordFreqs.build(numWords, [&records] (const size_t idx) {
+            return records[idx].freq;
+        });
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::buildLevel(const TTrieSize L, const vector<TContextId> & wordIds,
+                                               const vector<TContextId> & contextIds, vector<TContextId> & ngramIds) {
+        //The N-gram record: the key of the word and context pair, the counting trie's id and the frequency
+        typedef struct {
+            uint64_t key;
+            TContextId memId;
+            TFrequencySize freq;
+        } SNGramRecord;
+
+        //The contexts of the 2-grams are the word ids, the others are the previous level's N-grams
+        SLevel & level = _levels[L - MINIMUM_CONTEXT_LEVEL];
+        level.numContexts = (L == MINIMUM_CONTEXT_LEVEL) ? _wordHashes.size() : _levels[L - MINIMUM_CONTEXT_LEVEL - 1].keys.size();
+
+        //Collect and sort the N-grams by their keys, they are unique
+        const size_t numNGrams = _memTrie->getNumNGrams(L);
+        vector<SNGramRecord> records;
+        records.reserve(numNGrams);
+        const uint64_t numContexts = level.numContexts;
+        _memTrie->forEachEntry(L, [&] (const TWordId wordId, const TContextId context, const TContextId id, const TFrequencySize freq) {
+            SNGramRecord record = {wordIds[wordId] * numContexts + contextIds[context], id, freq};
+            records.push_back(record);
+        });
+        sort(records.begin(), records.end(), [] (const SNGramRecord & first, const SNGramRecord & second) {
+            return first.key < second.key;
+        });
+
+        level.keys.build(records.size(), [&records] (const size_t idx) {
+            return records[idx].key;
+        });
+        level.freqs.build(records.size(), [&records] (const size_t idx) {
+            return records[idx].freq;
+        });
+
+        //The counting trie's ids start from one
+        ngramIds.assign(numNGrams + 1, 0);
+        for (size_t idx = 0; idx < records.size(); idx++) {
+            ngramIds[records[idx].memId] = idx;
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                                     const TNGramVisitor & visitor) const throw (Exception) {
+        if (_memTrie != NULL) {
+            _memTrie->visitNGramsChunk(L, chunkIdx, numChunks, visitor);
+            return;
+        }
+
+        vector<string> words(L);
+        SNGramData ngData = {0, ZERO_LOG_PROB, 0.0};
+        const size_t numNGrams = getNumNGrams(L);
+        const size_t firstId = (numNGrams * chunkIdx) / numChunks;
+        const size_t lastId = (numNGrams * (chunkIdx + 1)) / numChunks;
+        for (size_t id = firstId; id < lastId; id++) {
+            if (L == 1) {
+                words[0] = getWord(id);
+                ngData.freq = _wordFreqs.get(id);
+            } else {
+                //Recover the N-gram words from its key, the last word first
+                uint64_t key = _levels[L - MINIMUM_CONTEXT_LEVEL].keys.access(id);
+                for (TTrieSize level = L; level >= MINIMUM_CONTEXT_LEVEL; level--) {
+                    const uint64_t numContexts = _levels[level - MINIMUM_CONTEXT_LEVEL].numContexts;
+                    words[level - 1] = getWord(key / numContexts);
+                    key = key % numContexts;
+                    if (level > MINIMUM_CONTEXT_LEVEL) {
+                        key = _levels[level - MINIMUM_CONTEXT_LEVEL - 1].keys.access(key);
+                    }
+                }
+                words[0] = getWord(key);
+                ngData.freq = _levels[L - MINIMUM_CONTEXT_LEVEL].freqs.get(id);
+            }
+            visitor(words, ngData);
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void EliasFanoTrie<N, doCache>::getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+        if (_memTrie != NULL) {
+            _memTrie->getMemoryStatistics(stats);
+            stats.other += sizeof (*this);
+            return;
+        }
+
+        fill(stats.levels, stats.levels + N, SMemoryUsage());
+        stats.other = sizeof (*this);
+
+        //The 1-grams: the hashes, the frequencies and the words' text
+        SMemoryUsage & unigrams = stats.levels[0];
+        unigrams.numNGrams = _wordHashes.size();
+        unigrams.entries = memory::getVectorBytes(_wordHashes) + _wordFreqs.getBytes();
+        unigrams.strings = memory::getVectorBytes(_wordChars) + _wordOffsets.getBytes();
+
+        //The N-grams: the keys and the frequencies
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const SLevel & level = _levels[L - MINIMUM_CONTEXT_LEVEL];
+            SMemoryUsage & usage = stats.levels[L - 1];
+            usage.numNGrams = level.keys.size();
+            usage.entries = level.keys.getBytes() + level.freqs.getBytes();
+        }
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class EliasFanoTrie<N_GRAM_PARAM, true>;
+    template class EliasFanoTrie<N_GRAM_PARAM, false>;
+}
@@ -26,21 +26,36 @@
 
 #include <stdexcept> //std::exception
 #include <sstream>   //std::stringstream
-#include <algorithm>      //std::fill
+#include <algorithm>      //std::fill, std::min, std::max, std::sort, std::stable_sort
+#include <limits>         //std::numeric_limits
+#include <cmath>          //std::log10
 
 #include "Logger.hpp"
+#include "MemoryUtils.hpp"
 
 namespace tries {
 
-    template<TTrieSize N, bool doCache>
-    const TTrieSize HashMapTrie<N, doCache>::MINIMUM_CONTEXT_LEVEL = 2;
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    const TTrieSize HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::MINIMUM_CONTEXT_LEVEL = 2;
 
-    template<TTrieSize N, bool doCache>
-    HashMapTrie<N, doCache>::HashMapTrie() {
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::HashMapTrie() : isCompacted(false), unknownProb(ZERO_LOG_PROB), isCountingHot(false) {
+        fill(hotEntries, hotEntries + N, 0);
+        for (TTrieSize idx = 0; idx < N; idx++) {
+            numProbes[idx].store(0);
+            numHotProbes[idx].store(0);
+        }
+
+        //The ids start from one, so reserve the undefined id entries
+        wordsById.push_back(SWordEntry());
+        for (TTrieSize idx = 0; idx < (N - 1); idx++) {
+            SContextEntry undefined = {UNDEFINED_WORD_ID, UNDEFINED_CONTEXT_ID};
+            contexts[idx].push_back(undefined);
+        }
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::printDebugNGram(vector<string> &tokens, const int idx, const int n) {
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::printDebugNGram(const vector<string> &tokens, const int idx, const int n) {
         ostream &log = Logger::Get(Logger::DEBUG);
         log << "Adding " << n << "-gram: [ ";
         for (int i = idx; i < (idx + n); i++) {
@@ -49,188 +64,1134 @@ namespace tries {
         log << "]" << END_LOG;
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::addWords(vector<string> &tokens) {
-        //Add the words to the trie and update frequencies;
-        for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
-            //Insert a new or get an existing entry
-            const string & token = *it;
-            TWordHashSize hash = computeHash(token);
-            TWordEntryPair & entry = words[hash];
-            if (entry.second == 0) {
-                entry.first = token;
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryWordFreqs(const TWordId wordId, SFrequencyResult<N> & wrap) {
+        //Set the word's frequency, 0-gram
+        wrap.result[0] = wordsById[wordId].freq;
+
+        //Set the N-gram frequencies for N > 0, once the word is not found on
+        //some level this means the the next level's N-gram is not present,
+        //so we can stop searching already as there are definitely no occurrences
+        //of this word as the last one in higher level N-grams.
+        for (int idx = 1; idx < N; idx++) {
+            TFrequencySize & sum = wrap.result[idx];
+            if (isCompacted) {
+                const SCompactLevel & level = compactData[idx - 1];
+                if ((wordId + 1) >= level.offsets.size()) {
+                    break;
+                }
+                for (TContextId pos = level.offsets[wordId]; pos < level.offsets[wordId + 1]; pos++) {
+                    sum += level.entries[pos].freq;
+                }
+                continue;
+            }
+            const vector<TNTrieEntryPairsMap> & level = data[idx - 1];
+            if (wordId >= level.size()) {
+                break;
+            }
+            //Now go through all of the N-grams ending with
+            //the given word and sum-up their frequencies
+            level[wordId].forEach([&sum] (const TContextId & context, const SNGramEntry & entry) {
+                sum += entry.freq;
+            });
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
+        if (HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::doesQueryCache()) {
+            throw Exception("This function is not applicable when query result caching is ON!");
+        } else {
+            //Get the word's id and compute the result, if the word is known
+            const TWordId wordId = getWordId(word, computeHash(word));
+            if (wordId != UNDEFINED_WORD_ID) {
+                queryWordFreqs(wordId, result);
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    SFrequencyResult<N> & HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryWordFreqs(const string & word) throw (Exception) {
+        if (HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::doesQueryCache()) {
+            //Convert the word into it's cache
+            TWordHashSize hash = computeHash(word);
+            //Get/Create the cache entry
+            TCacheEntry & cache = queryCache[hash];
+            //Check if the caching was done
+            if (!cache.first) {
+                //If not then compute the result, this will be automatically cached
+                //unless the word is not known, then the result is zero
+                const TWordId wordId = getWordId(word, hash);
+                if (wordId != UNDEFINED_WORD_ID) {
+                    queryWordFreqs(wordId, cache.second);
+                }
+                //Set the flag to true as caching is done
+                cache.first = true;
+            }
+            //return the cached result
+            return cache.second;
+        } else {
+            throw Exception("This function is not applicable when query result caching is OFF!");
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    bool HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::stepLookup(SLookupState & lookup, const string * ngram, const TWordHashSize * hashes,
+                                             SFrequencyResult<N> & freqs) const {
+        if (lookup.numWords > 0) {
+            //Look up the next word, the last one goes first
+            const TTrieSize idx = --lookup.numWords;
+            const TWordId wordId = getWordId(ngram[idx], hashes[idx]);
+            lookup.wordIds[idx] = wordId;
+            if (idx == (N - 1)) {
+                if (wordId == UNDEFINED_WORD_ID) {
+                    return true;
+                }
+                freqs.result[N - 1] = wordsById[wordId].freq;
+            }
+            if (lookup.numWords > 0) {
+                return false;
+            }
+            //All the words are known now, start with the 2-grams
+            lookup.level = MINIMUM_CONTEXT_LEVEL;
+            lookup.context = lookup.wordIds[N - MINIMUM_CONTEXT_LEVEL];
+            lookup.probeIdx = N - 1;
+        } else {
+            const TTrieSize startIdx = N - lookup.level;
+            if (lookup.probeIdx < (N - 1)) {
+                //Extend the L-gram's context by one more word
+                const SNGramEntry * prefix = findEntry(lookup.probeIdx - startIdx + 1,
+                        lookup.wordIds[lookup.probeIdx], lookup.context);
+                if (prefix == NULL) {
+                    return true;
+                }
+                lookup.context = prefix->id;
+                lookup.probeIdx++;
+            } else {
+                //Get the L-gram's frequency, the missing one means that the longer ones are missing too
+                const SNGramEntry * entry = findEntry(lookup.level, lookup.wordIds[N - 1], lookup.context);
+                if (entry == NULL) {
+                    return true;
+                }
+                freqs.result[startIdx] = entry->freq;
+                if (lookup.level == N) {
+                    return true;
+                }
+                //Move on to the next level, its context starts one word earlier
+                lookup.level++;
+                lookup.context = lookup.wordIds[N - lookup.level];
+                lookup.probeIdx = N - lookup.level + 1;
+            }
+        }
+        prefetchProbe(lookup);
+        return false;
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryNGramFreqsBatch(const vector<string> & ngramWords, const vector<TWordHashSize> & hashes,
+                                                       vector< SFrequencyResult<N> > & freqs, const size_t numInFlight) {
+        const size_t count = ngramWords.size() / N;
+        freqs.resize(count);
+
+        //Start the first lookups
+        vector<SLookupState> lookups(min(max(numInFlight, (size_t) 1), count));
+        size_t next = 0;
+        for (; next < lookups.size(); next++) {
+            startLookup(lookups[next], next, freqs[next]);
+        }
+
+        //Step the lookups round robin, a finished lookup is replaced by the next one
+        size_t numActive = lookups.size();
+        while (numActive > 0) {
+            for (size_t idx = 0; idx < numActive;) {
+                SLookupState & lookup = lookups[idx];
+                const size_t base = lookup.ngramIdx * N;
+                if (!stepLookup(lookup, &ngramWords[base], &hashes[base], freqs[lookup.ngramIdx])) {
+                    idx++;
+                } else if (next < count) {
+                    startLookup(lookup, next, freqs[next]);
+                    next++;
+                    idx++;
+                } else {
+                    lookup = lookups[--numActive];
+                }
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryNextWord(SQueryState<N> & state, const string & word, const TWordHashSize hash,
+                                                SFrequencyResult<N> & freqs) throw (Exception) {
+        //First just clean the array
+        fill(freqs.result, freqs.result + N, 0);
+
+        //The contexts of the previous word, the state gets the new ones
+        const SQueryState<N> previous = state;
+        state.reset();
+
+        //Get the 1-gram's word frequency, its id is the 1-gram context
+        const TWordId wordId = getWordId(word, hash);
+        if (wordId == UNDEFINED_WORD_ID) {
+            return;
+        }
+        freqs.result[N - 1] = wordsById[wordId].freq;
+        state.contexts[0] = wordId;
+
+        //Extend the N-grams ending with the previous word by the given word,
+        //the first missing N-gram means that the longer ones are missing too
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const TContextId context = previous.contexts[L - MINIMUM_CONTEXT_LEVEL];
+            if (context == UNDEFINED_CONTEXT_ID) {
+                return;
+            }
+            const SNGramEntry * entry = findEntry(L, wordId, context);
+            if (entry == NULL) {
+                return;
+            }
+            freqs.result[N - L] = entry->freq;
+            if (L < N) {
+                state.contexts[L - 1] = entry->id;
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::scoreSentence(const vector<string> & tokens, const vector<TWordHashSize> & hashes,
+                                                vector< SFrequencyResult<N> > & freqs) {
+        freqs.resize(tokens.size());
+
+        SQueryState<N> state;
+        state.reset();
+        for (size_t idx = 0; idx < tokens.size(); idx++) {
+            queryNextWord(state, tokens[idx], hashes[idx], freqs[idx]);
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    TFrequencySize HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getEntryFreq(const TTrieSize L, const TContextId id) const {
+        if (L == 1) {
+            return wordsById[id].freq;
+        }
+        const SContextEntry & ctxEntry = contexts[L - MINIMUM_CONTEXT_LEVEL][id];
+        return findEntry(L, ctxEntry.word, ctxEntry.context)->freq;
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    TWordId HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getOrCreateCollidingWordId(const string & token, const TWordHashSize key,
+                                                                                      const TWordId keyId) {
+        vector<TWordId> & ids = collidingWords[key];
+        for (auto it = ids.begin(); it != ids.end(); ++it) {
+            if (wordsById[*it].word == token) {
+                return *it;
+            }
+        }
+
+        //This is a new colliding word, give it the next id
+        const TWordId id = wordsById.size();
+        SWordEntry entry = {token, 0};
+        wordsById.push_back(entry);
+        ids.push_back(id);
+        LOG_WARNING << "Hash collision: '" << token << "' and '" << wordsById[keyId].word << "' both have key "
+                    << key << ", '" << token << "' is put into the collision list" << END_LOG;
+        return id;
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    TWordId HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getCollidingWordId(const string & word, const TWordHashSize key) const {
+        auto found = collidingWords.find(key);
+        if (found != collidingWords.end()) {
+            for (auto it = found->second.begin(); it != found->second.end(); ++it) {
+                if (wordsById[*it].word == word) {
+                    return *it;
+                }
+            }
+        }
+        return UNDEFINED_WORD_ID;
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    size_t HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getNumCountedNGrams(const TTrieSize L) const {
+        size_t numNGrams = 0;
+        const size_t numEntries = contexts[L - MINIMUM_CONTEXT_LEVEL].size();
+        for (TContextId id = 1; id < numEntries; id++) {
+            if (getEntryFreq(L, id) > 0) {
+                numNGrams++;
+            }
+        }
+        return numNGrams;
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::computeSuffixIds(vector<TContextId> suffixIds[N]) const {
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const TLargeVector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+            suffixIds[L - 1].assign(levelContexts.size(), UNDEFINED_CONTEXT_ID);
+            for (TContextId id = 1; id < levelContexts.size(); id++) {
+                const SContextEntry & ctxEntry = levelContexts[id];
+                if (L == MINIMUM_CONTEXT_LEVEL) {
+                    //The suffix of a 2-gram is its last word
+                    suffixIds[L - 1][id] = ctxEntry.word;
+                } else {
+                    //The suffix of c(w_1 ... w_n) is c(w_2 ... w_n), defined by
+                    //id(w_n) and the suffix of the context c(w_1 ... w_(n-1))
+                    const TContextId subSuffix = suffixIds[L - 2][ctxEntry.context];
+                    const SNGramEntry * suffix = findEntry(L - 1, ctxEntry.word, subSuffix);
+                    if (suffix != NULL) {
+                        suffixIds[L - 1][id] = suffix->id;
+                    }
+                }
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::computeStupidBackoffProbs() {
+        const TLogProbSize backoff = log10(STUPID_BACKOFF_WEIGHT);
+
+        //The 1-gram scores are the relative word frequencies
+        double total = 0;
+        for (TWordId id = 1; id < wordsById.size(); id++) {
+            total += wordsById[id].freq;
+        }
+        for (TWordId id = 1; id < wordsById.size(); id++) {
+            const TFrequencySize freq = wordsById[id].freq;
+            probs[0][id].prob = (freq > 0) ? log10(freq / total) : ZERO_LOG_PROB;
+            probs[0][id].backoff = backoff;
+        }
+        unknownProb = ZERO_LOG_PROB;
+
+        //The N-gram scores are the frequencies relative to their context frequencies
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const TLargeVector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+            for (TContextId id = 1; id < levelContexts.size(); id++) {
+                const TFrequencySize freq = getEntryFreq(L, id);
+                const TFrequencySize ctxFreq = getEntryFreq(L - 1, levelContexts[id].context);
+                probs[L - 1][id].prob = ((freq > 0) && (ctxFreq > 0)) ? log10(double(freq) / ctxFreq) : ZERO_LOG_PROB;
+                probs[L - 1][id].backoff = backoff;
+            }
+        }
+    }
+
+    //The number of the modified Kneser-Ney discounts: D(0), D(1), D(2) and D(3+)
+    #define NUMBER_OF_KN_DISCOUNTS 4
+
+    /**
+     * Computes the modified Kneser-Ney discounts from the counts of counts,
+     * as given by Chen & Goodman. The discounts that can not be estimated,
+     * e.g. as there are no N-grams with the given count, get defaults.
+     * @param countOfCounts countOfCounts[k] is the number of N-grams with count k, 1 <= k <= 4
+     * @param discounts the discounts to fill in, discounts[k] is for count k, 0 <= k <= 3
+     */
+    static void computeKneserNeyDiscounts(const double countOfCounts[NUMBER_OF_KN_DISCOUNTS + 1], double discounts[NUMBER_OF_KN_DISCOUNTS]) {
+        const double * n = countOfCounts;
+        discounts[0] = 0.0;
+        const double Y = ((n[1] + 2 * n[2]) > 0) ? n[1] / (n[1] + 2 * n[2]) : 0.5;
+        for (int k = 1; k < NUMBER_OF_KN_DISCOUNTS; k++) {
+            const double discount = (n[k] > 0) ? (k - (k + 1) * Y * n[k + 1] / n[k]) : 0.0;
+            //The discount must be positive and not larger than the count
+            discounts[k] = ((discount > 0.0) && (discount <= k)) ? discount : 0.5 * k;
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::computeKneserNeyProbs(const vector<TContextId> suffixIds[N]) {
+        //The adjusted counts: the N-gram frequencies for the level N and the
+        //numbers of distinct words preceding the N-grams for the lower levels
+        vector<TFrequencySize> counts[N];
+        counts[0].assign(wordsById.size(), 0);
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            counts[L - 1].assign(contexts[L - MINIMUM_CONTEXT_LEVEL].size(), 0);
+        }
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            for (TContextId id = 1; id < counts[L - 1].size(); id++) {
+                const TFrequencySize freq = getEntryFreq(L, id);
+                if (L == N) {
+                    counts[L - 1][id] = freq;
+                }
+                if ((freq > 0) && (suffixIds[L - 1][id] != UNDEFINED_CONTEXT_ID)) {
+                    counts[L - 2][suffixIds[L - 1][id]]++;
+                }
+            }
+        }
+
+        //The linear probabilities of the previous level
+        vector<double> lowerProbs;
+        for (TTrieSize L = 1; L <= N; L++) {
+            const vector<TFrequencySize> & levelCounts = counts[L - 1];
+
+            //Compute the level's discounts
+            double countOfCounts[NUMBER_OF_KN_DISCOUNTS + 1] = {};
+            for (TContextId id = 1; id < levelCounts.size(); id++) {
+                if ((levelCounts[id] > 0) && (levelCounts[id] <= NUMBER_OF_KN_DISCOUNTS)) {
+                    countOfCounts[levelCounts[id]]++;
+                }
+            }
+            double discounts[NUMBER_OF_KN_DISCOUNTS];
+            computeKneserNeyDiscounts(countOfCounts, discounts);
+            LOG_DEBUG << "Level " << L << " Kneser-Ney discounts: " << discounts[1] << ", "
+                    << discounts[2] << ", " << discounts[3] << END_LOG;
+
+            //Compute the context totals and the interpolation weights, all
+            //the 1-grams share one empty context with the index zero
+            const size_t numContexts = (L == 1) ? 1 : counts[L - 2].size();
+            vector<double> totals(numContexts, 0.0), weights(numContexts, 0.0);
+            for (TContextId id = 1; id < levelCounts.size(); id++) {
+                const TContextId context = (L == 1) ? 0 : contexts[L - MINIMUM_CONTEXT_LEVEL][id].context;
+                totals[context] += levelCounts[id];
+                weights[context] += discounts[min<TFrequencySize>(levelCounts[id], NUMBER_OF_KN_DISCOUNTS - 1)];
+            }
+            for (size_t context = 0; context < numContexts; context++) {
+                if (totals[context] > 0) {
+                    weights[context] /= totals[context];
+                }
+            }
+
+            //Compute the interpolated probabilities, the 1-grams are
+            //interpolated with the uniform distribution including the unknown word
+            vector<double> levelProbs(levelCounts.size(), 0.0);
+            const double uniform = 1.0 / wordsById.size();
+            for (TContextId id = 1; id < levelCounts.size(); id++) {
+                const TContextId context = (L == 1) ? 0 : contexts[L - MINIMUM_CONTEXT_LEVEL][id].context;
+                const double lower = (L == 1) ? uniform : lowerProbs[suffixIds[L - 1][id]];
+                if (totals[context] > 0) {
+                    const double discount = discounts[min<TFrequencySize>(levelCounts[id], NUMBER_OF_KN_DISCOUNTS - 1)];
+                    levelProbs[id] = (levelCounts[id] - discount) / totals[context] + weights[context] * lower;
+                } else {
+                    levelProbs[id] = lower;
+                }
+                probs[L - 1][id].prob = (levelProbs[id] > 0) ? log10(levelProbs[id]) : ZERO_LOG_PROB;
+            }
+
+            //Store the back-off weights of the contexts, i.e. the previous level N-grams
+            if (L == 1) {
+                unknownProb = (totals[0] > 0) ? log10(weights[0] * uniform) : log10(uniform);
             } else {
-                if (entry.first.compare(token)) {
-                    LOG_ERROR << "Hash collision: '" << token << "' and '" << entry.first << "' both have hash " << hash << END_LOG;
+                for (size_t context = 1; context < numContexts; context++) {
+                    probs[L - 2][context].backoff = (totals[context] > 0) ? log10(weights[context]) : 0.0;
                 }
             }
-            //Update/increase the frequency
-            entry.second++;
-            LOG_DEBUG << "freq( " << hash << " ) = " << entry.second << END_LOG;
+
+            lowerProbs.swap(levelProbs);
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::computeProbs(const ESmoothing smoothing) throw (Exception) {
+        //Allocate the probabilities, the contexts without extensions do not back off
+        const SProbEntry empty = {ZERO_LOG_PROB, 0.0};
+        probs[0].assign(wordsById.size(), empty);
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            probs[L - 1].assign(contexts[L - MINIMUM_CONTEXT_LEVEL].size(), empty);
+        }
+
+        switch (smoothing) {
+            case STUPID_BACKOFF_SMOOTHING:
+                computeStupidBackoffProbs();
+                break;
+            case KNESER_NEY_SMOOTHING:
+            {
+                vector<TContextId> suffixIds[N];
+                computeSuffixIds(suffixIds);
+                computeKneserNeyProbs(suffixIds);
+                break;
+            }
+            default:
+                throw Exception("Unknown smoothing method!");
         }
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::addNGram(vector<string> &tokens, const int base_idx, const int n) {
-        if (Logger::ReportingLevel() >= Logger::DEBUG) {
-            printDebugNGram(tokens, base_idx, n);
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::queryNGramProbs(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                                  SProbabilityResult<N> & result) throw (Exception) {
+        if (!hasProbs()) {
+            throw Exception("The probabilities are not computed!");
         }
 
-        TReferenceHashSize context = computeHash(tokens[base_idx]);
+        //Get the ids of the N-gram words, the unknown words get the undefined id
+        TWordId wordIds[N];
+        for (TTrieSize idx = 0; idx < N; idx++) {
+            wordIds[idx] = getWordId(ngram[idx], hashes[idx]);
+        }
 
-        //Put the N-grams into the trie with N >= 2
-        for (int idx = 1; idx < n; idx++) {
-            string & token = tokens[base_idx + idx];
-            TWordHashSize wordHash = computeHash(token);
+        //Get the last 1-gram's word probability
+        const TWordId endWordId = wordIds[N - 1];
+        TLogProbSize prob = (endWordId != UNDEFINED_WORD_ID) ? probs[0][endWordId].prob : unknownProb;
+        result.result[N - 1] = prob;
 
-            //Data stores the N-tires from length 2 on, therefore "idx-1"
-            //Get/Create the mapping for this word in the Trie level of the N-gram
-            TNTrieEntryPairsMap& ngamEntry = data[idx - 1][wordHash];
-            //Get/Create the new entry in the map, with context
-            TFrequencySize& ngramFreq = ngamEntry[context];
+        //Now compute the probabilities given the longer contexts, the missing
+        //N-grams back off. Note that a pruned model, e.g. from an ARPA file, may
+        //have an N-gram without its suffix, so the longer N-grams are still
+        //looked up. Once a context is missing the longer ones are missing too.
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            //Compute the context of the L-gram words preceding the end word,
+            //the context of the first word is the word id itself
+            const TTrieSize startIdx = N - L;
+            TContextId context = wordIds[startIdx];
+            for (TTrieSize idx = startIdx + 1; (idx < (N - 1)) && (context != UNDEFINED_CONTEXT_ID); idx++) {
+                const SNGramEntry * prefix = findEntry(idx - startIdx + 1, wordIds[idx], context);
+                context = (prefix != NULL) ? prefix->id : UNDEFINED_CONTEXT_ID;
+            }
+            if (context == UNDEFINED_CONTEXT_ID) {
+                fill(result.result, result.result + startIdx + 1, prob);
+                return;
+            }
 
-            //If this is the end of this N-gram
-            if (idx == n - 1) {
-                //Increase the frequency of the N-gram
-                ngramFreq++;
-                LOG_DEBUG << n << "-gram: freq( " << wordHash << ", " << context << " ) = " << ngramFreq << END_LOG;
-                //BasicLogger::printDebug("data[%u][%u][%u] = %u", idx-1, wordHash, context, data[idx-1][wordHash][context]);
+            //Get the L-gram's probability or back off
+            const SNGramEntry * entry = findEntry(L, endWordId, context);
+            if (entry != NULL) {
+                prob = probs[L - 1][entry->id].prob;
             } else {
-                //Otherwise compute the next context
-                TReferenceHashSize n_context = createContext(wordHash, context);
-                LOG_DEBUG << n << "-gram: Cn( " << wordHash << ", " << context << " ) = " << n_context << END_LOG;
-                context = n_context;
+                prob += probs[L - 2][context].backoff;
             }
+            result.result[startIdx] = prob;
         }
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::queryWordFreqs(TWordHashSize hash, SFrequencyResult<N> & wrap) {
-        TFrequencySize wordFreq = 0;
-        //First check if the given word is present at all, i.e. consider the 1-grams
-        try {
-            //Set the word's frequency, 0-gram
-            TWordEntryPair & entry = words.at(hash);
-            wrap.result[0] = entry.second;
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::addNGramProb(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                               const TLogProbSize prob, const TLogProbSize backoff) throw (Exception) {
+        checkNotCompact();
+
+        //The probability arrays grow along with the ids, the new
+        //words and prefixes are impossible and do not back off
+        const SProbEntry empty = {ZERO_LOG_PROB, 0.0};
+        if (probs[0].size() < (wordsById.size() + ngram.size())) {
+            probs[0].resize(wordsById.size() + ngram.size(), empty);
+        }
 
-            //Set the N-gram frequencies for N > 0, once an exception occurs this
-            //means the the next level's N-gram is not present, so we can stop
-            //searching already as there are definitely no occurrences of this word
-            //as the last one in higher level N-grams.
-            for (int idx = 1; idx < N; idx++) {
-                //Now go through all of the N-grams ending with
-                //the given word and sum-up their frequencies
-                TNTrieEntryPairsMap & entry = data[idx - 1].at(hash);
-                for (auto it = entry.cbegin(); it != entry.cend(); ++it) {
-                    wrap.result[idx] += it->second;
+        //Get the N-gram's id, the context of the first word is the word id itself
+        TContextId id = getOrCreateWordId(ngram[0], hashes[0]);
+        if (id == UNDEFINED_WORD_ID) {
+            return;
+        }
+        for (size_t idx = 1; idx < ngram.size(); idx++) {
+            const TWordId wordId = getOrCreateWordId(ngram[idx], hashes[idx]);
+            if (wordId == UNDEFINED_WORD_ID) {
+                return;
+            }
+            id = getOrCreateEntry(idx + 1, wordId, id).id;
+            if (id >= probs[idx].size()) {
+                probs[idx].resize(id + 1, empty);
+            }
+        }
+
+        //Store the probability
+        TLargeVector<SProbEntry> & levelProbs = probs[ngram.size() - 1];
+        levelProbs[id].prob = prob;
+        levelProbs[id].backoff = backoff;
+        if ((ngram.size() == 1) && !ngram[0].compare(UNKNOWN_WORD_STR)) {
+            unknownProb = prob;
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::addNGramFreq(const vector<string> & ngram, const vector<TWordHashSize> & hashes,
+                                                                         const TFrequencySize freq) throw (Exception) {
+        checkNotCompact();
+
+        const TTrieSize L = ngram.size();
+        if ((L < 1) || (L > N)) {
+            stringstream msg;
+            msg << "Can not add the frequency of a " << L << "-gram to the " << N << "-gram trie!";
+            throw Exception(msg.str());
+        }
+
+        //Get the N-gram's context the same way as addNGram does
+        TContextId context = getOrCreateWordId(ngram[0], hashes[0]);
+        if (context == UNDEFINED_CONTEXT_ID) {
+            return;
+        }
+        if (L == 1) {
+            wordsById[context].freq += freq;
+            return;
+        }
+        for (TTrieSize idx = 1; idx < L; idx++) {
+            const TWordId wordId = getOrCreateWordId(ngram[idx], hashes[idx]);
+            if (wordId == UNDEFINED_WORD_ID) {
+                return;
+            }
+            SNGramEntry & entry = getOrCreateEntry(idx + 1, wordId, context);
+            if (idx == L - 1) {
+                entry.freq += freq;
+            } else {
+                context = entry.id;
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::compact() throw (Exception) {
+        if (isCompacted) {
+            return;
+        }
+
+        //Re-assign the word ids in the decreasing order of the word frequencies,
+        //the order of the equally frequent words is kept. The new id of the old
+        //word id is newIds[oldId] and the old id of the new word id is oldIds[newId].
+        const size_t numWords = wordsById.size();
+        vector<TWordId> oldIds(numWords);
+        for (TWordId wordId = 0; wordId < numWords; wordId++) {
+            oldIds[wordId] = wordId;
+        }
+        stable_sort(oldIds.begin() + 1, oldIds.end(), [this] (const TWordId first, const TWordId second) {
+            return wordsById[first].freq > wordsById[second].freq;
+        });
+        vector<TWordId> newIds(numWords);
+        for (TWordId wordId = 0; wordId < numWords; wordId++) {
+            newIds[oldIds[wordId]] = wordId;
+        }
+        relabelWords(oldIds, newIds);
+
+        //The pairs of a word, are sorted by the context id
+        vector< pair<TContextId, SNGramEntry> > pairs;
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            vector<TNTrieEntryPairsMap> & level = data[L - MINIMUM_CONTEXT_LEVEL];
+            SCompactLevel & compactLevel = compactData[L - MINIMUM_CONTEXT_LEVEL];
+            //The contexts of the 2-grams are the word ids, they are re-assigned too
+            const bool isWordContext = (L == MINIMUM_CONTEXT_LEVEL);
+
+            //Compute the offsets of the words' pairs, the words that are
+            //not in the level map array get the empty ranges of pairs
+            compactLevel.offsets.assign(numWords + 1, 0);
+            for (TWordId wordId = 0; wordId < numWords; wordId++) {
+                const TWordId oldId = oldIds[wordId];
+                compactLevel.offsets[wordId + 1] = compactLevel.offsets[wordId]
+                        + ((oldId < level.size()) ? level[oldId].size() : 0);
+            }
+
+            //Copy the sorted pairs, word by word in the new word id order
+            const size_t numPairs = compactLevel.offsets[numWords];
+            compactLevel.keys.resize(numPairs);
+            compactLevel.entries.resize(numPairs);
+            for (TWordId wordId = 0; wordId < numWords; wordId++) {
+                const TWordId oldId = oldIds[wordId];
+                if (oldId >= level.size()) {
+                    continue;
+                }
+                pairs.clear();
+                level[oldId].forEach([&pairs, &newIds, isWordContext] (const TContextId & context, const SNGramEntry & entry) {
+                    pairs.push_back(make_pair(isWordContext ? newIds[context] : context, entry));
+                });
+                sort(pairs.begin(), pairs.end(), [] (const pair<TContextId, SNGramEntry> & first,
+                                                     const pair<TContextId, SNGramEntry> & second) {
+                    return first.first < second.first;
+                });
+                TContextId pos = compactLevel.offsets[wordId];
+                for (auto it = pairs.begin(); it != pairs.end(); ++it, ++pos) {
+                    compactLevel.keys[pos] = it->first;
+                    compactLevel.entries[pos] = it->second;
                 }
             }
-        } catch (out_of_range e) {
-            //DO NOTHING! This just means that the NGram is not found so we can simply stop searching
+
+            //Release the level maps right away to keep the peak memory low
+            vector<TNTrieEntryPairsMap>().swap(level);
+            contexts[L - MINIMUM_CONTEXT_LEVEL].shrink_to_fit();
+            LOG_DEBUG << "Compacted the level " << L << " with " << numPairs << " N-grams" << END_LOG;
+
+            //The hot region is made of the leading pairs, the ones of the most frequent words
+            hotEntries[L - 1] = min<size_t>(numPairs, HOT_REGION_BYTES / (sizeof (TContextId) + sizeof (SNGramEntry)));
+        }
+        hotEntries[0] = min<size_t>(numWords, HOT_REGION_BYTES / sizeof (SWordEntry));
+        wordsById.shrink_to_fit();
+        isCompacted = true;
+
+        //The continuation index has the old word ids, so it is built again
+        if (hasContinuations()) {
+            buildContinuations();
         }
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
-        if (HashMapTrie<N, doCache>::doesQueryCache()) {
-            throw Exception("This function is not applicable when query result caching is ON!");
-        } else {
-            //Convert the word into it's cache
-            TWordHashSize hash = computeHash(word);
-            //Compute the result
-            queryWordFreqs(hash, result);
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::relabelWords(const vector<TWordId> & oldIds, const vector<TWordId> & newIds) {
+        //The dictionary entries and the dictionary map
+        vector<SWordEntry> byNewId(wordsById.size());
+        for (TWordId wordId = 0; wordId < wordsById.size(); wordId++) {
+            byNewId[wordId] = move(wordsById[oldIds[wordId]]);
+        }
+        wordsById.swap(byNewId);
+        vector< pair<TWordHashSize, TWordId> > keys;
+        keys.reserve(words.size());
+        words.forEach([&keys] (const TWordHashSize & key, const TWordId & wordId) {
+            keys.push_back(make_pair(key, wordId));
+        });
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            words[it->first] = newIds[it->second];
+        }
+        for (auto it = collidingWords.begin(); it != collidingWords.end(); ++it) {
+            for (auto idIt = it->second.begin(); idIt != it->second.end(); ++idIt) {
+                *idIt = newIds[*idIt];
+            }
+        }
+
+        //The last words of the N-grams and the word contexts of the 2-grams
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            TLargeVector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+            for (TContextId id = 1; id < levelContexts.size(); id++) {
+                levelContexts[id].word = newIds[levelContexts[id].word];
+                if (L == MINIMUM_CONTEXT_LEVEL) {
+                    levelContexts[id].context = newIds[levelContexts[id].context];
+                }
+            }
+        }
+
+        //The 1-gram probabilities, if any, the words without them get the empty ones
+        if (!probs[0].empty()) {
+            const SProbEntry empty = {ZERO_LOG_PROB, 0.0};
+            probs[0].resize(max(probs[0].size(), wordsById.size()), empty);
+            TLargeVector<SProbEntry> byNewIdProbs(probs[0]);
+            for (TWordId wordId = 0; wordId < wordsById.size(); wordId++) {
+                byNewIdProbs[wordId] = probs[0][oldIds[wordId]];
+            }
+            probs[0].swap(byNewIdProbs);
         }
     }
 
-    template<TTrieSize N, bool doCache>
-    SFrequencyResult<N> & HashMapTrie<N, doCache>::queryWordFreqs(const string & word) throw (Exception) {
-        if (HashMapTrie<N, doCache>::doesQueryCache()) {
-            //Convert the word into it's cache
-            TWordHashSize hash = computeHash(word);
-            //Get/Create the cache entry
-            TCacheEntry & cache = queryCache[hash];
-            //Check if the caching was done
-            if (!cache.first) {
-                //If not then compute the result, this will be automatically cached
-                queryWordFreqs(hash, cache.second);
-                //Set the flag to true as caching is done
-                cache.first = true;
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::setHotRegionCounting(const bool isCounting) throw (Exception) {
+        if (isCounting) {
+            for (TTrieSize idx = 0; idx < N; idx++) {
+                numProbes[idx].store(0);
+                numHotProbes[idx].store(0);
             }
-            //return the cached result
-            return cache.second;
-        } else {
-            throw Exception("This function is not applicable when query result caching is OFF!");
         }
+        isCountingHot = isCounting;
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::queryNGramFreqs(const TWordHashSize endWordHash, const TTrieSize L,
-            const vector<string> & ngram, vector<TWordHashSize> & hashes,
-            SFrequencyResult<N> & freqs) const {
-        LOG_DEBUG << ">> End word hash: " << endWordHash << ", level " << L << END_LOG;
-        //Get this level's mapping corresponding to the start word
-        const TNTrieEntryPairsMap & entry = data[L - MINIMUM_CONTEXT_LEVEL].at(endWordHash);
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getHotRegionStatistics(SHotRegionStatistics<N> & stats) const throw (Exception) {
+        stats.levels[0].hotBytes = hotEntries[0] * sizeof (SWordEntry);
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            stats.levels[L - 1].hotBytes = hotEntries[L - 1] * (sizeof (TContextId) + sizeof (SNGramEntry));
+        }
+        for (TTrieSize idx = 0; idx < N; idx++) {
+            stats.levels[idx].numProbes = numProbes[idx].load();
+            stats.levels[idx].numHotProbes = numHotProbes[idx].load();
+        }
+    }
 
-        LOG_DEBUG << "-- The level " << L << " data entry is found" << END_LOG;
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                                                         const TNGramVisitor & visitor) const throw (Exception) {
+        vector<string> words(L);
+        SNGramData ngData = {0, ZERO_LOG_PROB, 0.0};
+        const size_t numNGrams = (L == 1) ? (wordsById.size() - 1) : getNumNGrams(L);
+        const TContextId firstId = 1 + (numNGrams * chunkIdx) / numChunks;
+        const TContextId lastId = (numNGrams * (chunkIdx + 1)) / numChunks;
+        for (TContextId id = firstId; id <= lastId; id++) {
+            //Recover the N-gram words from its id, the last word first
+            TContextId context = id;
+            for (TTrieSize level = L; level >= MINIMUM_CONTEXT_LEVEL; level--) {
+                TWordId wordId;
+                dessolveContext(level, context, wordId, context);
+                words[level - 1] = wordsById[wordId].word;
+            }
+            words[0] = wordsById[context].word;
 
-        //Compute the hash of the first word in the Ngram
-        TWordHashSize startWordHash = computeHash(ngram[N - L]);
-        //Put it inside the hash
-        hashes.push_back(startWordHash);
+            ngData.freq = getEntryFreq(L, id);
+            if (id < probs[L - 1].size()) {
+                ngData.prob = probs[L - 1][id].prob;
+                ngData.backoff = probs[L - 1][id].backoff;
+            }
+            visitor(words, ngData);
+        }
 
-        LOG_DEBUG << "-- Computed the level's " << L << " next " << N - L << "-gram level word hash " << startWordHash << END_LOG;
+        if ((L == 1) && isUnknownWordVirtual() && (chunkIdx + 1 == numChunks)) {
+            words[0] = UNKNOWN_WORD_STR;
+            SNGramData unknown = {0, unknownProb, 0.0};
+            visitor(words, unknown);
+        }
+    }
 
-        //Compute the context of the startWord on this level for this level's N-gram (L-gram))
-        TReferenceHashSize context = createContext(hashes, L);
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::buildContinuations() throw (Exception) {
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const TLargeVector<SContextEntry> & levelContexts = contexts[L - MINIMUM_CONTEXT_LEVEL];
+            SContinuationLevel & level = continuations[L - MINIMUM_CONTEXT_LEVEL];
 
-        LOG_DEBUG << "-- The level " << L << " context is " << context << END_LOG;
+            //Count the continuations of every context, the contexts of the 2-grams are the word ids
+            const size_t numContexts = (L == MINIMUM_CONTEXT_LEVEL) ? wordsById.size() : contexts[L - MINIMUM_CONTEXT_LEVEL - 1].size();
+            level.offsets.assign(numContexts + 1, 0);
+            for (TContextId id = 1; id < levelContexts.size(); id++) {
+                level.offsets[levelContexts[id].context + 1]++;
+            }
+            for (size_t context = 0; context < numContexts; context++) {
+                level.offsets[context + 1] += level.offsets[context];
+            }
 
-        //BasicLogger::printDebug("Getting data[%u][%u][%u] = %u", L-1, endWordHash, context, data[L-MINIMUM_CONTEXT_LEVEL][endWordHash][context]);
+            //Put the continuations into their contexts' groups and sort the groups
+            level.entries.resize(level.offsets[numContexts]);
+            vector<TContextId> positions(level.offsets.begin(), level.offsets.end() - 1);
+            for (TContextId id = 1; id < levelContexts.size(); id++) {
+                SContinuationEntry & entry = level.entries[positions[levelContexts[id].context]++];
+                entry.word = levelContexts[id].word;
+                entry.freq = getEntryFreq(L, id);
+            }
+            for (size_t context = 0; context < numContexts; context++) {
+                sort(level.entries.begin() + level.offsets[context], level.entries.begin() + level.offsets[context + 1],
+                     [] (const SContinuationEntry & first, const SContinuationEntry & second) {
+                         return (first.freq > second.freq) || ((first.freq == second.freq) && (first.word < second.word));
+                     });
+            }
+            LOG_DEBUG << "Indexed the level " << L << " with " << level.entries.size() << " continuations" << END_LOG;
+        }
+    }
 
-        //Get the L-gram's frequency
-        freqs.result[N - L] = entry.at(context);
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::topContinuations(const vector<string> & context, const vector<TWordHashSize> & hashes,
+                                                                            const size_t k, vector<TContinuation> & result) const throw (Exception) {
+        result.clear();
+        if (!hasContinuations()) {
+            throw Exception("The continuation index is not built!");
+        }
+        if (context.empty() || (context.size() >= N)) {
+            stringstream msg;
+            msg << "The continuation context must have 1 to " << (N - 1) << " words, got " << context.size();
+            throw Exception(msg.str());
+        }
 
-        LOG_DEBUG << "-- The level " << context << " frequency " << freqs.result[N - L] << " is found and stored at index " << N - L << END_LOG;
+        //Get the context id of the context words, the first word's context is its id
+        TContextId contextId = getWordId(context[0], hashes[0]);
+        for (TTrieSize idx = 1; (idx < context.size()) && (contextId != UNDEFINED_CONTEXT_ID); idx++) {
+            const TWordId wordId = getWordId(context[idx], hashes[idx]);
+            const SNGramEntry * entry = (wordId == UNDEFINED_WORD_ID) ? NULL : findEntry(idx + 1, wordId, contextId);
+            contextId = (entry == NULL) ? UNDEFINED_CONTEXT_ID : entry->id;
+        }
+        //The contexts added after the index is built have no continuations yet
+        const SContinuationLevel & level = continuations[context.size() + 1 - MINIMUM_CONTEXT_LEVEL];
+        if ((contextId == UNDEFINED_CONTEXT_ID) || ((contextId + 1) >= level.offsets.size())) {
+            return;
+        }
 
-        //In case the maximum level N is not reached, do recursion
-        if (L < N) {
-            queryNGramFreqs(endWordHash, L + 1, ngram, hashes, freqs);
+        //The continuations are sorted already, just take the first k of them, the prefix only ones are last
+        const size_t begin = level.offsets[contextId];
+        const size_t end = min<size_t>(level.offsets[contextId + 1], begin + k);
+        for (size_t pos = begin; (pos < end) && (level.entries[pos].freq > 0); pos++) {
+            result.push_back(TContinuation(wordsById[level.entries[pos].word].word, level.entries[pos].freq));
         }
-        LOG_DEBUG << "<< End word hash: " << endWordHash << ", level " << L << END_LOG;
     }
 
-    template<TTrieSize N, bool doCache>
-    void HashMapTrie<N, doCache>::queryNGramFreqs(const vector<string> & ngram, SFrequencyResult<N> & freqs) {
-        //First just clean the array
-        fill(freqs.result, freqs.result + N, 0);
-        //This vector will store the N-gram's word hashes
-        //for being re-used in the recursive calls
-        vector<TWordHashSize> hashes;
+    /**
+     * This is the cursor over the N-grams matching a pattern, @see HashMapTrie::findNGrams.
+     * The candidate N-grams are given by the search and are matched against the
+     * pattern by their word ids first, their words are only recovered if they match.
+     */
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    class HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::NGramPatternCursor final : public ANGramCursor {
+    public:
+
+        //The ways of searching for the candidate N-grams
+        enum ESearch {
+            //There are no candidates as the pattern has an unknown word
+            NO_SEARCH = 0,
+            //The level entries of the pattern's last word are scanned
+            REVERSE_SEARCH = NO_SEARCH + 1,
+            //The N-grams are enumerated from the pattern's first word through the continuation index
+            FORWARD_SEARCH = REVERSE_SEARCH + 1,
+            //All the N-grams of the level are scanned
+            LEVEL_SCAN = FORWARD_SEARCH + 1
+        };
+
+        /**
+         * The basic constructor
+         * @param trie the trie to search in
+         * @param wordIds the pattern word ids, the wildcards are UNDEFINED_WORD_ID
+         * @param search the way of searching for the candidate N-grams
+         */
+        NGramPatternCursor(const HashMapTrie & trie, const vector<TWordId> & wordIds, const ESearch search)
+        : _trie(trie), _wordIds(wordIds), _level(wordIds.size()), _search(search),
+        _nextId(0), _endId(0), _begin(NULL), _end(NULL), _depth(0) {
+            if (search == REVERSE_SEARCH) {
+                startReverse();
+            } else if (search == FORWARD_SEARCH) {
+                _depth = 1;
+                _prefixIds[_depth] = _wordIds[0];
+                startDepth();
+            } else if (search == LEVEL_SCAN) {
+                _nextId = 1;
+                _endId = (_level == 1) ? _trie.wordsById.size() : _trie.contexts[_level - MINIMUM_CONTEXT_LEVEL].size();
+            }
+        }
+
+        /**
+         * For more details @see ANGramCursor
+         */
+        virtual bool next(vector<string> & words, TFrequencySize & freq) {
+            TContextId id;
+            while (nextCandidate(id, freq)) {
+                //The forward search only gives the matching N-grams
+                if ((freq > 0) && ((_search == FORWARD_SEARCH) || isMatch(id))) {
+                    getWords(id, words);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        //The trie to search in
+        const HashMapTrie & _trie;
+        //The pattern word ids, the wildcards are UNDEFINED_WORD_ID
+        const vector<TWordId> _wordIds;
+        //The level of the N-grams, i.e. the pattern length
+        const TTrieSize _level;
+        //The way of searching for the candidate N-grams
+        const ESearch _search;
+
+        //The next and the end ids of the scanned N-grams
+        TContextId _nextId;
+        TContextId _endId;
+
+        //The next and the end of the scanned level entries of the reverse search
+        const SNGramEntry * _begin;
+        const SNGramEntry * _end;
+        //The level entries of the reverse search copied out of the level map, if not compacted
+        vector<SNGramEntry> _entries;
+
+        //The number of the pattern words chosen by the forward search, the
+        //candidates for the next word are the continuations of their prefix
+        TTrieSize _depth;
+        //The ids of the chosen prefixes, index d is for the prefix of d words
+        TContextId _prefixIds[N];
+        //The next and the end positions of the candidates for the word with index d
+        size_t _positions[N];
+        size_t _ends[N];
+
+        /**
+         * Starts the reverse search, the entries of a word in a compacted level
+         * are contiguous and are scanned in place, the level map ones are copied
+         */
+        void startReverse() {
+            const TWordId wordId = _wordIds[_level - 1];
+            if (_level == 1) {
+                _nextId = wordId;
+                _endId = wordId + 1;
+            } else if (_trie.isCompacted) {
+                const SCompactLevel & level = _trie.compactData[_level - MINIMUM_CONTEXT_LEVEL];
+                if ((wordId + 1) < level.offsets.size()) {
+                    _begin = level.entries.data() + level.offsets[wordId];
+                    _end = level.entries.data() + level.offsets[wordId + 1];
+                }
+            } else {
+                const vector<TNTrieEntryPairsMap> & level = _trie.data[_level - MINIMUM_CONTEXT_LEVEL];
+                if (wordId < level.size()) {
+                    level[wordId].forEach([this] (const TContextId & context, const SNGramEntry & entry) {
+                        _entries.push_back(entry);
+                    });
+                    _begin = _entries.data();
+                    _end = _begin + _entries.size();
+                }
+            }
+        }
+
+        /**
+         * Starts going over the candidates for the word following the current prefix,
+         * a pattern word is the only candidate and a wildcard has the prefix's continuations
+         */
+        void startDepth() {
+            if (_wordIds[_depth] != UNDEFINED_WORD_ID) {
+                _positions[_depth] = 0;
+                _ends[_depth] = 1;
+                return;
+            }
+            const SContinuationLevel & level = _trie.continuations[_depth + 1 - MINIMUM_CONTEXT_LEVEL];
+            const TContextId prefixId = _prefixIds[_depth];
+            const bool isIndexed = ((prefixId + 1) < level.offsets.size());
+            _positions[_depth] = isIndexed ? level.offsets[prefixId] : 0;
+            _ends[_depth] = isIndexed ? level.offsets[prefixId + 1] : 0;
+        }
 
-        try {
-            //Compute the hash of the last word in the Ngram
-            TWordHashSize endWordHash = computeHash(ngram[N - 1]);
+        /**
+         * Gives the next candidate N-gram
+         * @param id the out parameter for the N-gram id
+         * @param freq the out parameter for the N-gram frequency
+         * @return true if there is the next candidate, otherwise false
+         */
+        inline bool nextCandidate(TContextId & id, TFrequencySize & freq) {
+            if (_search == FORWARD_SEARCH) {
+                return nextForward(id, freq);
+            }
+            if (_begin != _end) {
+                id = _begin->id;
+                freq = _begin->freq;
+                ++_begin;
+                return true;
+            }
+            if (_nextId < _endId) {
+                id = _nextId++;
+                freq = _trie.getEntryFreq(_level, id);
+                return true;
+            }
+            return false;
+        }
 
-            //Get the last 1-gram's word frequency
-            freqs.result[N - 1] = words.at(endWordHash).second;
+        /**
+         * Gives the next N-gram of the forward search, a depth first search
+         * over the prefixes of the pattern length
+         * @param id the out parameter for the N-gram id
+         * @param freq the out parameter for the N-gram frequency
+         * @return true if there is the next N-gram, otherwise false
+         */
+        bool nextForward(TContextId & id, TFrequencySize & freq) {
+            while (_depth > 0) {
+                if (_positions[_depth] == _ends[_depth]) {
+                    _depth--;
+                    continue;
+                }
+                const size_t pos = _positions[_depth]++;
+                const TWordId wordId = (_wordIds[_depth] != UNDEFINED_WORD_ID) ? _wordIds[_depth]
+                        : _trie.continuations[_depth + 1 - MINIMUM_CONTEXT_LEVEL].entries[pos].word;
+                const SNGramEntry * entry = _trie.findEntry(_depth + 1, wordId, _prefixIds[_depth]);
+                if (entry == NULL) {
+                    continue;
+                }
+                if ((_depth + 1) == _level) {
+                    id = entry->id;
+                    freq = entry->freq;
+                    return true;
+                }
+                _depth++;
+                _prefixIds[_depth] = entry->id;
+                startDepth();
+            }
+            return false;
+        }
 
-            //Now perform a recursive procedure for finding
-            //frequencies of all longer N-grams with N >= 2
-            queryNGramFreqs(endWordHash, MINIMUM_CONTEXT_LEVEL, ngram, hashes, freqs);
-        } catch (out_of_range e) {
-            //DO NOTHING! This just means that the NGram is not found so we can simply stop searching
+        /**
+         * Checks if the N-gram matches the pattern, by the word ids
+         * @param id the N-gram id
+         * @return true if the N-gram matches the pattern, otherwise false
+         */
+        inline bool isMatch(const TContextId id) const {
+            TContextId context = id;
+            for (TTrieSize L = _level; L >= MINIMUM_CONTEXT_LEVEL; L--) {
+                TWordId wordId;
+                _trie.dessolveContext(L, context, wordId, context);
+                if ((_wordIds[L - 1] != UNDEFINED_WORD_ID) && (_wordIds[L - 1] != wordId)) {
+                    return false;
+                }
+            }
+            return (_wordIds[0] == UNDEFINED_WORD_ID) || (_wordIds[0] == context);
+        }
+
+        /**
+         * Recovers the N-gram words from the N-gram id, the last word first
+         * @param id the N-gram id
+         * @param words the out parameter for the N-gram words
+         */
+        inline void getWords(const TContextId id, vector<string> & words) const {
+            words.resize(_level);
+            TContextId context = id;
+            for (TTrieSize L = _level; L >= MINIMUM_CONTEXT_LEVEL; L--) {
+                TWordId wordId;
+                _trie.dessolveContext(L, context, wordId, context);
+                words[L - 1] = _trie.wordsById[wordId].word;
+            }
+            words[0] = _trie.wordsById[context].word;
+        }
+    };
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    unique_ptr<ANGramCursor> HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::findNGrams(const vector<string> & pattern,
+                                                                                          const vector<TWordHashSize> & hashes) const throw (Exception) {
+        if (pattern.empty() || (pattern.size() > N)) {
+            stringstream msg;
+            msg << "The N-gram pattern must have 1 to " << N << " words, got " << pattern.size();
+            throw Exception(msg.str());
+        }
+
+        //Get the pattern word ids, an unknown word means there are no matching N-grams
+        typename NGramPatternCursor::ESearch search = NGramPatternCursor::LEVEL_SCAN;
+        vector<TWordId> wordIds(pattern.size(), UNDEFINED_WORD_ID);
+        for (size_t idx = 0; idx < pattern.size(); idx++) {
+            if (pattern[idx].compare(NGRAM_PATTERN_WILDCARD)) {
+                wordIds[idx] = getWordId(pattern[idx], hashes[idx]);
+                if (wordIds[idx] == UNDEFINED_WORD_ID) {
+                    search = NGramPatternCursor::NO_SEARCH;
+                }
+            }
+        }
+
+        //Choose the way of searching, the level entries are grouped by the last word
+        if (search != NGramPatternCursor::NO_SEARCH) {
+            if (wordIds.back() != UNDEFINED_WORD_ID) {
+                search = NGramPatternCursor::REVERSE_SEARCH;
+            } else if ((wordIds.front() != UNDEFINED_WORD_ID) && hasContinuations()) {
+                search = NGramPatternCursor::FORWARD_SEARCH;
+            }
+        }
+        LOG_DEBUG << "Searching for the " << pattern.size() << "-grams by the search " << search << END_LOG;
+        return unique_ptr<ANGramCursor>(new NGramPatternCursor(*this, wordIds, search));
+    }
+
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    void HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+        fill(stats.levels, stats.levels + N, SMemoryUsage());
+        stats.other = sizeof (*this);
+
+        //The 1-grams: the dictionary, the word entries, the word strings and the query cache
+        SMemoryUsage & unigrams = stats.levels[0];
+        unigrams.numNGrams = wordsById.size() - 1;
+        unigrams.entries = memory::getVectorBytes(wordsById) + memory::getVectorBytes(probs[0]);
+        words.addHeapBytes(unigrams.entries, unigrams.buckets, unigrams.nodes);
+        for (auto it = collidingWords.begin(); it != collidingWords.end(); ++it) {
+            unigrams.entries += sizeof (*it) + memory::getVectorBytes(it->second);
+        }
+        for (auto it = wordsById.begin(); it != wordsById.end(); ++it) {
+            unigrams.strings += memory::getStringHeapBytes(it->word);
+        }
+        if (doCache) {
+            typedef unordered_map<TWordHashSize, TCacheEntry> TCacheMap;
+            unigrams.caches = queryCache.size() * (sizeof (typename TCacheMap::value_type)
+                    + memory::getHashMapNodeOverheadBytes<TCacheMap>())
+                    + memory::getHashMapBucketBytes(queryCache);
+        }
+
+        //The N-grams: the per word maps, the context entries and the probabilities
+        for (TTrieSize L = MINIMUM_CONTEXT_LEVEL; L <= N; L++) {
+            const vector<TNTrieEntryPairsMap> & level = data[L - MINIMUM_CONTEXT_LEVEL];
+            const SCompactLevel & compactLevel = compactData[L - MINIMUM_CONTEXT_LEVEL];
+            SMemoryUsage & usage = stats.levels[L - 1];
+            usage.numNGrams = getNumNGrams(L);
+            usage.entries = memory::getVectorBytes(level) + memory::getVectorBytes(contexts[L - MINIMUM_CONTEXT_LEVEL])
+                    + memory::getVectorBytes(probs[L - 1]) + memory::getVectorBytes(compactLevel.offsets)
+                    + memory::getVectorBytes(compactLevel.keys) + memory::getVectorBytes(compactLevel.entries)
+                    + memory::getVectorBytes(continuations[L - MINIMUM_CONTEXT_LEVEL].offsets)
+                    + memory::getVectorBytes(continuations[L - MINIMUM_CONTEXT_LEVEL].entries);
+            for (auto it = level.begin(); it != level.end(); ++it) {
+                it->addHeapBytes(usage.entries, usage.buckets, usage.nodes);
+            }
         }
     }
 
-    template<TTrieSize N, bool doCache>
-    HashMapTrie<N, doCache>::HashMapTrie(const HashMapTrie& orig) {
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::HashMapTrie(const HashMapTrie& orig) {
     }
 
-    template<TTrieSize N, bool doCache>
-    HashMapTrie<N, doCache>::~HashMapTrie() {
+    template<TTrieSize N, bool doCache, typename THashPolicy, typename TMapPolicy>
+    HashMapTrie<N, doCache, THashPolicy, TMapPolicy>::~HashMapTrie() {
     }
 
     //Make sure that there will be templates instantiated, at least for the given parameter values
     template class HashMapTrie<N_GRAM_PARAM, true>;
     template class HashMapTrie<N_GRAM_PARAM, false>;
+
+#if TRIE_POLICY_COMBINATIONS
+    //The other hash and map policy combinations, for measuring the trade-offs
+    template class HashMapTrie<N_GRAM_PARAM, true, MurmurHashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, MurmurHashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, MurmurHashPolicy, FlatMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, MurmurHashPolicy, FlatMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, Djb2HashPolicy, AdaptiveMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, Djb2HashPolicy, AdaptiveMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, Djb2HashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, Djb2HashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, Djb2HashPolicy, FlatMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, Djb2HashPolicy, FlatMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, PrimesHashPolicy, AdaptiveMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, PrimesHashPolicy, AdaptiveMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, PrimesHashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, PrimesHashPolicy, NodeMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, true, PrimesHashPolicy, FlatMapPolicy>;
+    template class HashMapTrie<N_GRAM_PARAM, false, PrimesHashPolicy, FlatMapPolicy>;
+#endif
 }
\ No newline at end of file
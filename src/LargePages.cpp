@@ -0,0 +1,188 @@
+/* 
+ * File:   LargePages.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 07:10 PM
+ */
+
+#include "LargePages.hpp"
+
+#include <stdint.h>     // uintptr_t
+#include <atomic>       // std::atomic
+#include <fstream>      // std::ifstream
+#include <sstream>      // std::stringstream
+#include <string>       // std::string
+#include <vector>       // std::vector
+
+#if defined(__linux__)
+#include <unistd.h>             // syscall
+#include <sys/mman.h>           // mmap, munmap, madvise
+#include <sys/syscall.h>        // SYS_mbind
+#include <linux/mempolicy.h>    // MPOL_INTERLEAVE
+#endif
+
+#include "Logger.hpp"
+
+namespace memory {
+
+    //The policies of the large tables, @see setLargeTablePolicy
+    static atomic<int> pagePolicy(REGULAR_PAGES);
+    static atomic<int> numaPolicy(LOCAL_NUMA);
+
+    //The flag indicating that the missing explicit huge pages were reported
+    static atomic<bool> isPoolReported(false);
+
+    void setLargeTablePolicy(const EPagePolicy pages, const ENumaPolicy numa) throw (Exception) {
+#if !defined(__linux__)
+        if ((pages != REGULAR_PAGES) || (numa != LOCAL_NUMA)) {
+            throw Exception("The huge pages and the NUMA policies are only supported on Linux!");
+        }
+#endif
+        pagePolicy.store(pages);
+        numaPolicy.store(numa);
+    }
+
+#if defined(__linux__)
+
+    /**
+     * Reads the mask of the NUMA nodes with memory, e.g. "0-1,3"
+     * @return the node mask, empty if the nodes are not known
+     */
+    static vector<unsigned long> readMemoryNodes() {
+        vector<unsigned long> mask;
+        ifstream fstr("/sys/devices/system/node/has_memory");
+        string range;
+        while (getline(fstr, range, ',')) {
+            unsigned long first = 0, last = 0;
+            char dash = 0;
+            stringstream str(range);
+            str >> first;
+            last = ((str >> dash >> last) && (dash == '-')) ? last : first;
+            for (unsigned long node = first; node <= last; node++) {
+                const size_t bits = 8 * sizeof (unsigned long);
+                if (mask.size() <= node / bits) {
+                    mask.resize(node / bits + 1, 0);
+                }
+                mask[node / bits] |= (1ul << (node % bits));
+            }
+        }
+        return mask;
+    }
+
+    /**
+     * Interleaves the not yet touched pages over the NUMA nodes with memory
+     * @param ptr the memory start, page aligned
+     * @param bytes the memory size
+     */
+    static void interleave(void * ptr, const size_t bytes) {
+        static const vector<unsigned long> mask = readMemoryNodes();
+        if (!mask.empty()) {
+            //The kernel takes the number of the mask bits plus one
+            const unsigned long maxNode = mask.size() * 8 * sizeof (unsigned long) + 1;
+            if (syscall(SYS_mbind, ptr, bytes, MPOL_INTERLEAVE, mask.data(), maxNode, 0) != 0) {
+                LOG_DEBUG << "Could not interleave " << bytes << " bytes over the NUMA nodes" << END_LOG;
+            }
+        }
+    }
+
+    void * allocateLargeTable(const size_t bytes) {
+        const size_t mapBytes = (bytes + HUGE_PAGE_BYTES - 1) & ~static_cast<size_t> (HUGE_PAGE_BYTES - 1);
+        const int pages = pagePolicy.load();
+        void * ptr = MAP_FAILED;
+        if (pages == EXPLICIT_HUGE_PAGES) {
+            ptr = mmap(NULL, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if ((ptr == MAP_FAILED) && !isPoolReported.exchange(true)) {
+                LOG_WARNING << "The explicit huge pages are exhausted, using the transparent ones, "
+                        << "see /proc/sys/vm/nr_hugepages" << END_LOG;
+            }
+        }
+        if (ptr == MAP_FAILED) {
+            //Map one more huge page and unmap the head and the tail around the aligned table
+            char * raw = static_cast<char *> (mmap(NULL, mapBytes + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE,
+                                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED) {
+                throw bad_alloc();
+            }
+            char * table = reinterpret_cast<char *> ((reinterpret_cast<uintptr_t> (raw) + HUGE_PAGE_BYTES - 1)
+                                                     & ~static_cast<uintptr_t> (HUGE_PAGE_BYTES - 1));
+            if (table > raw) {
+                munmap(raw, table - raw);
+            }
+            if (table < raw + HUGE_PAGE_BYTES) {
+                munmap(table + mapBytes, raw + HUGE_PAGE_BYTES - table);
+            }
+            if (pages != REGULAR_PAGES) {
+                madvise(table, mapBytes, MADV_HUGEPAGE);
+            }
+            ptr = table;
+        }
+        if (numaPolicy.load() == INTERLEAVE_NUMA) {
+            interleave(ptr, mapBytes);
+        }
+        return ptr;
+    }
+
+    void freeLargeTable(void * ptr, const size_t bytes) {
+        munmap(ptr, (bytes + HUGE_PAGE_BYTES - 1) & ~static_cast<size_t> (HUGE_PAGE_BYTES - 1));
+    }
+
+    void adviseFileMapping(void * ptr, const size_t bytes) {
+        if (pagePolicy.load() != REGULAR_PAGES) {
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+        }
+    }
+
+    size_t getHugePagesBytes() {
+        static const char * const FIELDS[] = {"AnonHugePages:", "FilePmdMapped:", "ShmemPmdMapped:",
+                                              "Shared_Hugetlb:", "Private_Hugetlb:"};
+        size_t kBytes = 0;
+        ifstream fstr("/proc/self/smaps_rollup");
+        string field;
+        size_t value;
+        while (fstr >> field) {
+            for (size_t idx = 0; idx < sizeof (FIELDS) / sizeof (FIELDS[0]); idx++) {
+                if (!field.compare(FIELDS[idx]) && (fstr >> value)) {
+                    kBytes += value;
+                }
+            }
+        }
+        return kBytes * 1024;
+    }
+
+#else
+
+    void * allocateLargeTable(const size_t bytes) {
+        return ::operator new(bytes);
+    }
+
+    void freeLargeTable(void * ptr, const size_t bytes) {
+        ::operator delete(ptr);
+    }
+
+    void adviseFileMapping(void * ptr, const size_t bytes) {
+    }
+
+    size_t getHugePagesBytes() {
+        return 0;
+    }
+
+#endif
+}
@@ -27,6 +27,9 @@
  */
 
 #include "Logger.hpp"
+
+#include <algorithm>  // std::min, std::max
+
 #include "StatisticsMonitor.hpp"
 
 Logger::DebugLevel Logger::currLEvel;
@@ -41,43 +44,90 @@ std::ostream& Logger::Get(DebugLevel level) {
     return os;
 }
 
-//Initialize the progress bar chars array
-const vector<string> Logger::progressChars({"///", "---", "\\\\\\", "|||", "\r\r\r" });
+//Initialize the progress counters
+atomic<size_t> Logger::progressLines(0);
+atomic<size_t> Logger::progressBytes(0);
+size_t Logger::progressTotalBytes = 0;
+chrono::steady_clock::time_point Logger::progressStart;
+thread Logger::progressTicker;
+mutex Logger::progressMutex;
+condition_variable Logger::progressCondition;
+bool Logger::isProgressStop = false;
 
-//It is the number of characters minus one as the last one is backspace
-const unsigned short int Logger::numProgChars = progressChars.size()-1;
+void Logger::startProgressBar(const size_t totalBytes) {
+    progressLines = 0;
+    progressBytes = 0;
+    progressTotalBytes = totalBytes;
+    progressStart = chrono::steady_clock::now();
+    if (currLEvel <= INFO) {
+        isProgressStop = false;
+        progressTicker = thread(&Logger::runProgressTicker);
+    }
+}
 
-//Set the initial index to zerro
-unsigned short int Logger::currProgCharIdx = 0;
+void Logger::runProgressTicker() {
+    unique_lock<mutex> lock(progressMutex);
+    while (!progressCondition.wait_for(lock, chrono::milliseconds(PROGRESS_UPDATE_PERIOD_MSEC),
+                                       [] { return isProgressStop; })) {
+        reportProgress(false);
+    }
+}
 
-//Set the initial update time to zero
-double Logger::lastProgressUpdate = 0.0;
+void Logger::reportProgress(const bool isFinal) {
+    const size_t lines = progressLines.load(memory_order_relaxed);
+    const size_t bytes = progressBytes.load(memory_order_relaxed);
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - progressStart;
+    const double seconds = max(elapsed.count(), 1e-9);
+    const double BYTES_ONE_MB = 1024.0 * 1024.0;
 
-void Logger::startProgressBar(){
-    if( currLEvel <= INFO ) {
-        currProgCharIdx = 0;
-        cout << progressChars[currProgCharIdx];
-        lastProgressUpdate = StatisticsMonitor::getCPUTime();
+    stringstream msg;
+    msg.precision(1);
+    msg << fixed << lines << " lines, " << (lines / seconds) << " lines/sec, "
+            << (bytes / BYTES_ONE_MB / seconds) << " Mb/sec";
+    if (progressTotalBytes > 0) {
+        msg << ", " << min(100.0, (100.0 * bytes) / progressTotalBytes) << "%";
+        if (!isFinal && (bytes > 0)) {
+            const size_t left = (progressTotalBytes > bytes) ? progressTotalBytes - bytes : 0;
+            msg << ", ETA " << (left * seconds / bytes) << " sec";
+        }
+    }
+    try {
+        TMemotyUsage memStat = {};
+        StatisticsMonitor::getMemoryStatistics(memStat);
+        msg << ", RSS " << (memStat.vmrss / 1024.0) << " Mb";
+    } catch (Exception & ex) {
+        //The memory statistics are not essential for the progress report
+    }
+
+    //The line is overwritten by the next report, the final one ends it
+    if (isFinal) {
+        msg << ", took " << seconds << " sec.";
+        cout << "\rPROGRESS: " << msg.str() << endl;
+    } else {
+        cout << "\rPROGRESS: " << msg.str();
+        cout.flush();
     }
 }
 
-void Logger::updateProgressBar(){
-    if( currLEvel <= INFO ) {
-        const double currProgressUpdate = StatisticsMonitor::getCPUTime();
-        if( (currProgressUpdate - lastProgressUpdate ) > PROGRESS_UPDATE_PERIOD ) {
-            currProgCharIdx = (currProgCharIdx + 1) % numProgChars;
-            cout << progressChars[progressChars.size()-1] << progressChars[currProgCharIdx];
-            cout.flush();
-            lastProgressUpdate = currProgressUpdate;
+void Logger::stopProgressBar() {
+    if (progressTicker.joinable()) {
+        {
+            lock_guard<mutex> lock(progressMutex);
+            isProgressStop = true;
         }
+        progressCondition.notify_one();
+        progressTicker.join();
+        reportProgress(true);
     }
 }
 
-void Logger::stopProgressBar(){
-    if( currLEvel <= INFO ) {
-        currProgCharIdx = 0;
-        lastProgressUpdate = 0.0;
-        cout << progressChars[numProgChars];
+size_t Logger::getRemainingBytes(istream & stream) {
+    const istream::pos_type current = stream.tellg();
+    if (current == istream::pos_type(-1)) {
+        return 0;
     }
+    stream.seekg(0, ios_base::end);
+    const istream::pos_type end = stream.tellg();
+    stream.seekg(current);
+    return (end > current) ? static_cast<size_t> (end - current) : 0;
 }
-
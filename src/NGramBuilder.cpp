@@ -25,29 +25,66 @@
 #include "NGramBuilder.hpp"
 
 #include "Logger.hpp"
+#include "HashMapTrie.hpp"
+#include "ShardedTrie.hpp"
+#include "SegmentedTrie.hpp"
+#include "ConcurrentTrie.hpp"
+#include "EliasFanoTrie.hpp"
 
 namespace tries {
 namespace ngrams {
-    template<TTrieSize N, bool doCache>
-    NGramBuilder<N,doCache>::NGramBuilder(ATrie<N,doCache> & trie, const char delim) : _trie(trie), _delim(delim) {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    NGramBuilder<N,doCache,TTrie>::NGramBuilder(TTrie & trie, const char delim)
+        : _trie(trie), _numParts(1), _partIdx(0), _isPartial(false), _delim(delim) {
     }
 
-    template<TTrieSize N, bool doCache>
-    NGramBuilder<N,doCache>::NGramBuilder(const NGramBuilder<N,doCache>& orig) : _trie(orig._trie), _delim(orig._delim) {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    NGramBuilder<N,doCache,TTrie>::NGramBuilder(const ATrie<N,doCache> & owner, TTrie & partition, const size_t partIdx, const char delim)
+        : _trie(partition), _numParts(owner.getNumPartitions()), _partIdx(partIdx),
+          _isPartial(_numParts > 1), _delim(delim) {
     }
 
-    template<TTrieSize N, bool doCache>
-    NGramBuilder<N,doCache>::~NGramBuilder() {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    NGramBuilder<N,doCache,TTrie>::NGramBuilder(const NGramBuilder<N,doCache,TTrie>& orig)
+        : _trie(orig._trie), _numParts(orig._numParts), _partIdx(orig._partIdx),
+          _isPartial(orig._isPartial), _delim(orig._delim) {
     }
 
-    template<TTrieSize N, bool doCache>
-    void NGramBuilder<N,doCache>::processString(const string & data ) {
-        //Tokenise the line of text into a vector first
+    template<TTrieSize N, bool doCache, typename TTrie>
+    NGramBuilder<N,doCache,TTrie>::~NGramBuilder() {
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void NGramBuilder<N,doCache,TTrie>::processString(const string & data ) {
+        //Tokenise the line of text into a vector and hash the tokens first
         vector<string> tokens;
-        tokenize(data, _delim, tokens);
+        vector<TWordHashSize> hashes;
+        TextTokenizer::tokenize(data, _delim, tokens, hashes);
 
-        //First add all the words to the trie
-        _trie.addWords(tokens);
+        processTokens(tokens, hashes);
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void NGramBuilder<N,doCache,TTrie>::processTokens(const vector<string> & tokens, const vector<TWordHashSize> & hashes) {
+        //Mark the tokens belonging to the filled partition
+        vector<bool> isOwned(tokens.size(), true);
+        if (_isPartial) {
+            vector<string> ownTokens;
+            vector<TWordHashSize> ownHashes;
+            for (size_t idx = 0; idx < tokens.size(); idx++) {
+                //The partition is computed inline, not by a virtual call per token
+                isOwned[idx] = (ATrie<N,doCache>::getHashPartitionIndex(hashes[idx], _numParts) == _partIdx);
+                if (isOwned[idx]) {
+                    ownTokens.push_back(tokens[idx]);
+                    ownHashes.push_back(hashes[idx]);
+                }
+            }
+            //First add the partition's words to the trie
+            _trie.addWords(ownTokens, ownHashes);
+        } else {
+            //First add all the words to the trie
+            _trie.addWords(tokens, hashes);
+        }
 
         //Create and record all of the N-grams starting from 2 and 
         //limited either by Trie or by the available number of Tokens
@@ -55,8 +92,11 @@ namespace ngrams {
         LOG_DEBUG << "N-gram level = " << ngLevel << END_LOG;
         for(int n=2; n <= ngLevel; n++) {
             for(int idx=0; idx <= (tokens.size() - n); idx++){
-                LOG_DEBUG << "adding N-grams (#tokens=" << tokens.size() << ") idx = " << idx << ", len = " << n << END_LOG;
-                _trie.addNGram(tokens, idx, n );
+                //Only the N-grams ending with the owned words are added
+                if (isOwned[idx + n - 1]) {
+                    LOG_DEBUG << "adding N-grams (#tokens=" << tokens.size() << ") idx = " << idx << ", len = " << n << END_LOG;
+                    _trie.addNGram(tokens, hashes, idx, n );
+                }
             }
         }
     }
@@ -64,5 +104,27 @@ namespace ngrams {
     //Make sure that there will be templates instantiated, at least for the given parameter values
     template class NGramBuilder<N_GRAM_PARAM,true>;
     template class NGramBuilder<N_GRAM_PARAM,false>;
+
+    //The builders filling in the concrete tries directly
+    template class NGramBuilder<N_GRAM_PARAM,true,TFiveCacheHashMapTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,false,TFiveNoCacheHashMapTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,true,TFiveCacheShardedTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,false,TFiveNoCacheShardedTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,true,TFiveCacheSegmentedTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,false,TFiveNoCacheSegmentedTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,true,TFiveCacheConcurrentTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,false,TFiveNoCacheConcurrentTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,true,TFiveCacheEliasFanoTrie>;
+    template class NGramBuilder<N_GRAM_PARAM,false,TFiveNoCacheEliasFanoTrie>;
+#if TRIE_POLICY_COMBINATIONS
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,MurmurHashPolicy,NodeMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,MurmurHashPolicy,FlatMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,AdaptiveMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,NodeMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,FlatMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,AdaptiveMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,NodeMapPolicy> >;
+    template class NGramBuilder<N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,FlatMapPolicy> >;
+#endif
 }
 }
\ No newline at end of file
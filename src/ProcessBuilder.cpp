@@ -0,0 +1,245 @@
+/* 
+ * File:   ProcessBuilder.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 06:05 PM
+ */
+
+#include "ProcessBuilder.hpp"
+
+#include <fstream>      // std::ifstream
+#include <sstream>      // std::stringstream
+#include <memory>       // std::shared_ptr
+#include <map>          // std::map
+#include <cstdio>       // std::remove
+#include <cstring>      // std::strerror
+#include <cerrno>       // errno
+
+#include <fcntl.h>      // open
+#include <unistd.h>     // fork, execv, dup2, getpid, _exit
+#include <sys/wait.h>   // waitpid
+
+#include "Logger.hpp"
+#include "HashMapTrie.hpp"
+#include "TrieBuilder.hpp"
+#include "TrieSegment.hpp"
+
+namespace tries {
+
+    template<TTrieSize N>
+    ProcessBuilder<N>::ProcessBuilder(const string & exeName, const string & trainFileName,
+                                      const string & dirName, const size_t numProcesses) throw (Exception)
+    : _exeName(exeName), _trainFileName(trainFileName), _numProcesses(numProcesses) {
+        if (numProcesses == 0) {
+            throw Exception("The number of builder processes must be positive!");
+        }
+        for (size_t rangeIdx = 0; rangeIdx < numProcesses; rangeIdx++) {
+            stringstream name;
+            name << dirName << "/part-" << getpid() << "-" << rangeIdx << ".bin";
+            _partFileNames.push_back(name.str());
+        }
+    }
+
+    template<TTrieSize N>
+    ProcessBuilder<N>::ProcessBuilder(const ProcessBuilder& orig)
+    : _exeName(orig._exeName), _trainFileName(orig._trainFileName), _numProcesses(orig._numProcesses) {
+    }
+
+    template<TTrieSize N>
+    int ProcessBuilder<N>::startRange(const size_t rangeIdx) throw (Exception) {
+#ifdef __linux__
+        const string exeName = "/proc/self/exe";
+#else
+        const string exeName = _exeName;
+#endif
+        //Prepare everything before the fork, the child only redirects its output and runs the program
+        stringstream range;
+        range << BUILD_RANGE_OPTION_PREFIX << (rangeIdx + 1) << "/" << _numProcesses;
+        const string rangeArg = range.str();
+        const string levelArg = (Logger::ReportingLevel() >= Logger::DEBUG) ? DEBUG_PARAM_VALUE : INFO_PARAM_VALUE;
+        const string logFileName = _partFileNames[rangeIdx] + ".log";
+        const char * args[] = {_exeName.c_str(), rangeArg.c_str(), _trainFileName.c_str(),
+            _partFileNames[rangeIdx].c_str(), levelArg.c_str(), NULL};
+
+        const pid_t pid = fork();
+        if (pid < 0) {
+            stringstream msg;
+            msg << "Failed to start the builder process: " << strerror(errno);
+            throw Exception(msg.str());
+        }
+        if (pid == 0) {
+            const int logFd = open(logFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (logFd >= 0) {
+                dup2(logFd, STDOUT_FILENO);
+                dup2(logFd, STDERR_FILENO);
+                close(logFd);
+            }
+            execv(exeName.c_str(), const_cast<char * const *> (args));
+            _exit(127);
+        }
+        LOG_DEBUG << "Started the builder process " << pid << " for the range " << (rangeIdx + 1) << "/" << _numProcesses << END_LOG;
+        return pid;
+    }
+
+    template<TTrieSize N>
+    void ProcessBuilder<N>::build(const string & countsFileName) throw (Exception) {
+        //The running processes' ranges and the numbers of attempts per range
+        map<pid_t, size_t> running;
+        vector<size_t> attempts(_numProcesses, 1);
+        string error;
+
+        try {
+            for (size_t rangeIdx = 0; rangeIdx < _numProcesses; rangeIdx++) {
+                running[startRange(rangeIdx)] = rangeIdx;
+            }
+        } catch (Exception & ex) {
+            error = ex.getMessage();
+        }
+
+        //Wait for all the processes, even if there is an error, and restart the failed ones
+        while (!running.empty()) {
+            int status = 0;
+            const pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                stringstream msg;
+                msg << "Failed to wait for the builder processes: " << strerror(errno);
+                throw Exception(msg.str());
+            }
+            const map<pid_t, size_t>::iterator found = running.find(pid);
+            if (found == running.end()) {
+                continue;
+            }
+            const size_t rangeIdx = found->second;
+            running.erase(found);
+
+            const string logFileName = _partFileNames[rangeIdx] + ".log";
+            if (WIFEXITED(status) && (WEXITSTATUS(status) == 0)) {
+                LOG_INFO << "The range " << (rangeIdx + 1) << "/" << _numProcesses << " is counted" << END_LOG;
+                remove(logFileName.c_str());
+                continue;
+            }
+
+            stringstream msg;
+            msg << "The builder process of the range " << (rangeIdx + 1) << "/" << _numProcesses << " has failed, ";
+            if (WIFSIGNALED(status)) {
+                msg << "signal " << WTERMSIG(status);
+            } else {
+                msg << "exit code " << WEXITSTATUS(status);
+            }
+            msg << ", see '" << logFileName << "'";
+            if (error.empty() && (attempts[rangeIdx] < BUILD_RANGE_ATTEMPTS)) {
+                LOG_WARNING << msg.str() << ", restarting it" << END_LOG;
+                attempts[rangeIdx]++;
+                try {
+                    running[startRange(rangeIdx)] = rangeIdx;
+                } catch (Exception & ex) {
+                    error = ex.getMessage();
+                }
+            } else if (error.empty()) {
+                error = msg.str();
+            }
+        }
+
+        if (error.empty()) {
+            try {
+                mergeCounts(_partFileNames, countsFileName);
+            } catch (Exception & ex) {
+                error = ex.getMessage();
+            }
+        }
+        for (size_t rangeIdx = 0; rangeIdx < _numProcesses; rangeIdx++) {
+            remove(_partFileNames[rangeIdx].c_str());
+        }
+        if (!error.empty()) {
+            throw Exception(error);
+        }
+    }
+
+    template<TTrieSize N>
+    void ProcessBuilder<N>::buildRange(const string & trainFileName, const size_t rangeIdx,
+                                       const size_t numRanges, const string & countsFileName) throw (Exception) {
+        typedef HashMapTrie<N, false> TTrie;
+
+        ifstream trainFile(trainFileName.c_str());
+        if (!trainFile.is_open()) {
+            throw Exception("The train file can not be opened: " + trainFileName);
+        }
+        const size_t numBytes = TrieBuilder<N, false, TTrie>::seekRange(trainFile, rangeIdx, numRanges);
+        LOG_INFO << "Counting the " << numBytes << " bytes of the range " << (rangeIdx + 1)
+                 << "/" << numRanges << " of '" << trainFileName << "'" << END_LOG;
+
+        TTrie trie;
+        TrieBuilder<N, false, TTrie> builder(trie, trainFile, TOKEN_DELIMITER_CHAR, numBytes);
+        builder.build();
+
+        TrieSegment<N>::write(countsFileName, trie);
+    }
+
+    template<TTrieSize N>
+    void ProcessBuilder<N>::mergeCounts(const vector<string> & fileNames, const string & countsFileName) throw (Exception) {
+        typedef TrieSegment<N> TSegment;
+
+        if (fileNames.empty()) {
+            throw Exception("There are no counts files to merge!");
+        }
+        vector< shared_ptr<TSegment> > segments;
+        for (vector<string>::const_iterator it = fileNames.begin(); it != fileNames.end(); ++it) {
+            segments.push_back(shared_ptr<TSegment>(new TSegment(*it)));
+        }
+        //A single file is merged with an empty one, this validates and copies it
+        if (segments.size() == 1) {
+            const string emptyFileName = countsFileName + ".empty";
+            TSegment::write(emptyFileName, HashMapTrie<N, false>());
+            segments.push_back(shared_ptr<TSegment>(new TSegment(emptyFileName)));
+            segments.back()->setRemoveFile(true);
+        }
+
+        //Merge the neighbouring segments pairwise until the last merge gives the counts file
+        size_t level = 0;
+        while (segments.size() > 1) {
+            vector< shared_ptr<TSegment> > merged;
+            for (size_t idx = 0; idx + 1 < segments.size(); idx += 2) {
+                if (segments.size() == 2) {
+                    TSegment::merge(countsFileName, *segments[0], *segments[1]);
+                } else {
+                    stringstream name;
+                    name << countsFileName << ".merge-" << level << "-" << (idx / 2);
+                    TSegment::merge(name.str(), *segments[idx], *segments[idx + 1]);
+                    merged.push_back(shared_ptr<TSegment>(new TSegment(name.str())));
+                    merged.back()->setRemoveFile(true);
+                }
+                LOG_DEBUG << "Merged the counts files '" << segments[idx]->getFileName() << "' and '"
+                          << segments[idx + 1]->getFileName() << "'" << END_LOG;
+            }
+            if (segments.size() % 2) {
+                merged.push_back(segments.back());
+            }
+            segments.swap(merged);
+            level++;
+        }
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class ProcessBuilder<N_GRAM_PARAM>;
+}
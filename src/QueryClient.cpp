@@ -0,0 +1,128 @@
+/* 
+ * File:   QueryClient.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:10 PM
+ */
+
+#include "QueryClient.hpp"
+
+#include <sstream>          // std::stringstream
+#include <cerrno>           // errno
+#include <unistd.h>         // close
+#include <sys/socket.h>     // socket, connect, send, recv
+#include <sys/un.h>         // sockaddr_un
+
+namespace tries {
+    namespace server {
+
+        template<TTrieSize N>
+        QueryClient<N>::QueryClient(const string & socketPath) throw (Exception) : _fd(-1), _requestId(0) {
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            if (socketPath.size() >= sizeof (address.sun_path)) {
+                throw Exception("The query server socket path is too long: " + socketPath);
+            }
+            socketPath.copy(address.sun_path, socketPath.size());
+
+            _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if ((_fd < 0) || (connect(_fd, (sockaddr *) & address, sizeof (address)) < 0)) {
+                stringstream msg;
+                msg << "Failed to connect to the query server '" << socketPath << "': " << strerror(errno);
+                if (_fd >= 0) {
+                    close(_fd);
+                }
+                throw Exception(msg.str());
+            }
+        }
+
+        template<TTrieSize N>
+        QueryClient<N>::QueryClient(const QueryClient& orig) {
+        }
+
+        template<TTrieSize N>
+        QueryClient<N>::~QueryClient() {
+            close(_fd);
+        }
+
+        template<TTrieSize N>
+        void QueryClient<N>::query(const vector< vector<string> > & ngrams, const size_t first, const size_t count,
+                                   vector< SFrequencyResult<N> > & freqs) throw (Exception) {
+            //Build the request frame, the header is written once the body length is known
+            _buffer.assign(FRAME_HEADER_SIZE, 0);
+            for (size_t idx = 0; idx < count; idx++) {
+                appendRequestNGram(_buffer, ngrams[(first + idx) % ngrams.size()]);
+            }
+            SFrameHeader header;
+            header.length = _buffer.size() - FRAME_HEADER_SIZE;
+            header.requestId = _requestId++;
+            header.count = count;
+            memcpy(_buffer.data(), &header, FRAME_HEADER_SIZE);
+
+            //Send the request
+            size_t pos = 0;
+            while (pos < _buffer.size()) {
+                const ssize_t numSent = send(_fd, &_buffer[pos], _buffer.size() - pos, MSG_NOSIGNAL);
+                if (numSent < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    stringstream msg;
+                    msg << "Failed to send a query request: " << strerror(errno);
+                    throw Exception(msg.str());
+                }
+                pos += numSent;
+            }
+
+            //Receive and check the response
+            SFrameHeader response;
+            _buffer.resize(FRAME_HEADER_SIZE);
+            receive(_buffer.data(), FRAME_HEADER_SIZE);
+            readFrameHeader(_buffer.data(), response);
+            if ((response.requestId != header.requestId) || (response.count != count) ||
+                    (response.length != getResponseLength(count, N))) {
+                throw Exception("Received an unexpected query response!");
+            }
+            freqs.resize(count);
+            receive(reinterpret_cast<char *> (freqs.data()), response.length);
+        }
+
+        template<TTrieSize N>
+        void QueryClient<N>::receive(char * data, const size_t size) throw (Exception) {
+            size_t pos = 0;
+            while (pos < size) {
+                const ssize_t numRead = recv(_fd, data + pos, size - pos, 0);
+                if (numRead <= 0) {
+                    if ((numRead < 0) && (errno == EINTR)) {
+                        continue;
+                    }
+                    stringstream msg;
+                    msg << "Failed to receive a query response: " << ((numRead == 0) ? "the server has disconnected" : strerror(errno));
+                    throw Exception(msg.str());
+                }
+                pos += numRead;
+            }
+        }
+
+        //Make sure that there will be templates instantiated, at least for the given parameter values
+        template class QueryClient<N_GRAM_PARAM>;
+    }
+}
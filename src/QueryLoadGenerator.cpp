@@ -0,0 +1,146 @@
+/* 
+ * File:   QueryLoadGenerator.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:35 PM
+ */
+
+#include "QueryLoadGenerator.hpp"
+
+#include <thread>       // std::thread
+#include <chrono>       // std::chrono::steady_clock
+#include <algorithm>    // std::sort
+#include <exception>    // std::exception_ptr
+
+#include "Logger.hpp"
+#include "NGramBuilder.hpp"
+
+namespace tries {
+    namespace server {
+
+        typedef chrono::steady_clock TClock;
+
+        /**
+         * Allows to get the time elapsed since the given time point
+         * @param start the time point
+         * @return the elapsed time in seconds
+         */
+        static inline double getElapsedTime(const TClock::time_point & start) {
+            return chrono::duration<double>(TClock::now() - start).count();
+        }
+
+        template<TTrieSize N>
+        QueryLoadGenerator<N>::QueryLoadGenerator(const string & socketPath, const size_t numConnections,
+                                                  const size_t numRequests, const size_t batchSize) throw (Exception)
+        : _socketPath(socketPath), _numConnections(numConnections), _numRequests(numRequests), _batchSize(batchSize) {
+            if ((numConnections == 0) || (numRequests == 0) || (batchSize == 0)) {
+                throw Exception("The numbers of connections, requests and N-grams per request must be positive!");
+            }
+        }
+
+        template<TTrieSize N>
+        QueryLoadGenerator<N>::QueryLoadGenerator(const QueryLoadGenerator& orig)
+        : _socketPath(orig._socketPath), _numConnections(orig._numConnections),
+        _numRequests(orig._numRequests), _batchSize(orig._batchSize) {
+        }
+
+        template<TTrieSize N>
+        QueryLoadGenerator<N>::~QueryLoadGenerator() {
+        }
+
+        template<TTrieSize N>
+        void QueryLoadGenerator<N>::sendRequests(const vector< vector<string> > & ngrams, const size_t connIdx,
+                                                 vector<double> & latencies) throw (Exception) {
+            QueryClient<N> client(_socketPath);
+            vector< SFrequencyResult<N> > freqs;
+
+            //Every connection starts from its own N-gram and takes every _numConnections'th request
+            size_t first = (connIdx * _batchSize) % ngrams.size();
+            for (size_t reqIdx = connIdx; reqIdx < _numRequests; reqIdx += _numConnections) {
+                const TClock::time_point start = TClock::now();
+                client.query(ngrams, first, _batchSize, freqs);
+                latencies.push_back(getElapsedTime(start));
+                first = (first + _numConnections * _batchSize) % ngrams.size();
+            }
+        }
+
+        template<TTrieSize N>
+        void QueryLoadGenerator<N>::run(ifstream & testFile) throw (Exception) {
+            //Read the test N-grams
+            vector< vector<string> > ngrams;
+            vector<TWordHashSize> hashes;
+            string line;
+            while (getline(testFile, line)) {
+                ngrams.push_back(vector<string>());
+                ngrams::NGramBuilder<N, false>::buildNGram(line, N, TOKEN_DELIMITER_CHAR, ngrams.back(), hashes);
+            }
+            if (ngrams.empty()) {
+                throw Exception("There are no test N-grams to send to the query server!");
+            }
+
+            LOG_RESULT << "Sending " << _numRequests << " requests of " << _batchSize << " N-grams over "
+                    << _numConnections << " connections to '" << _socketPath << "' ..." << END_LOG;
+
+            //Send the requests over all the connections concurrently
+            vector< vector<double> > latencies(_numConnections);
+            vector<exception_ptr> errors(_numConnections);
+            vector<thread> workers;
+            const TClock::time_point start = TClock::now();
+            for (size_t connIdx = 0; connIdx < _numConnections; connIdx++) {
+                workers.push_back(thread([&, connIdx]() {
+                    try {
+                        sendRequests(ngrams, connIdx, latencies[connIdx]);
+                    } catch (...) {
+                        errors[connIdx] = current_exception();
+                    }
+                }));
+            }
+            for (size_t connIdx = 0; connIdx < _numConnections; connIdx++) {
+                workers[connIdx].join();
+            }
+            const double totalTime = getElapsedTime(start);
+            for (size_t connIdx = 0; connIdx < _numConnections; connIdx++) {
+                if (errors[connIdx]) {
+                    rethrow_exception(errors[connIdx]);
+                }
+            }
+
+            //Report the throughput and the latency percentiles
+            vector<double> all;
+            for (size_t connIdx = 0; connIdx < _numConnections; connIdx++) {
+                all.insert(all.end(), latencies[connIdx].begin(), latencies[connIdx].end());
+            }
+            sort(all.begin(), all.end());
+
+            LOG_RESULT << "Done in " << totalTime << " seconds: " << (all.size() / totalTime) << " requests/sec, "
+                    << ((all.size() * _batchSize) / totalTime) << " N-grams/sec" << END_LOG;
+            const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+            for (size_t idx = 0; idx < sizeof (percentiles) / sizeof (percentiles[0]); idx++) {
+                const size_t pos = min<size_t>(all.size() - 1, (size_t) (all.size() * percentiles[idx] / 100.0));
+                LOG_RESULT << "Latency p" << percentiles[idx] << ": " << (all[pos] * 1e6) << " usec" << END_LOG;
+            }
+            LOG_RESULT << "Latency max: " << (all.back() * 1e6) << " usec" << END_LOG;
+        }
+
+        //Make sure that there will be templates instantiated, at least for the given parameter values
+        template class QueryLoadGenerator<N_GRAM_PARAM>;
+    }
+}
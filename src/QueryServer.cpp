@@ -0,0 +1,520 @@
+/* 
+ * File:   QueryServer.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 01:20 PM
+ */
+
+#include "QueryServer.hpp"
+
+#include <sstream>      // std::stringstream
+#include <cerrno>       // errno
+#include <csignal>      // std::signal
+
+#ifdef __linux__
+#include <unistd.h>         // close, read, write, unlink
+#include <fcntl.h>          // fcntl
+#include <sys/socket.h>     // socket, bind, listen, accept, send, recv
+#include <sys/un.h>         // sockaddr_un
+#include <sys/epoll.h>      // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>    // eventfd
+#endif
+
+#include "Logger.hpp"
+#include "HashingUtils.hpp"
+
+namespace tries {
+    namespace server {
+
+        using hashing::computeMurmur64Hash;
+
+        //The maximum number of events handled by one epoll wait call
+        static const int MAX_EPOLL_EVENTS = 64;
+        //The number of bytes read from a socket at once
+        static const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+        //The wake up descriptor of the running server, used by the signal handler
+        static volatile int signalWakeFd = -1;
+        //The signal received flag
+        static volatile sig_atomic_t isSignalled = 0;
+
+        /**
+         * The SIGINT and SIGTERM handler, wakes up the running server
+         * @param signal the signal number
+         */
+        static void onStopSignal(int signal) {
+            isSignalled = 1;
+#ifdef __linux__
+            if (signalWakeFd >= 0) {
+                const uint64_t one = 1;
+                if (write(signalWakeFd, &one, sizeof (one)) < 0) {
+                    //Nothing can be done about it in a signal handler
+                }
+            }
+#endif
+        }
+
+        /**
+         * Creates the exception message with the system error description
+         * @param action the failed action
+         * @return the exception to throw
+         */
+        static Exception systemError(const char * action) {
+            stringstream msg;
+            msg << "Failed to " << action << ": " << strerror(errno);
+            return Exception(msg.str());
+        }
+
+        template<TTrieSize N, bool doCache>
+        QueryServer<N, doCache>::QueryServer(ATrie<N, doCache> & trie, const string & socketPath, const size_t numWorkers) throw (Exception)
+        : _trie(trie), _socketPath(socketPath), _numWorkers(numWorkers),
+        _listenFd(-1), _epollFd(-1), _wakeFd(-1), _isStopping(false) {
+            if (numWorkers == 0) {
+                throw Exception("The number of query server workers must be positive!");
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        QueryServer<N, doCache>::QueryServer(const QueryServer& orig)
+        : _trie(orig._trie), _socketPath(orig._socketPath), _numWorkers(orig._numWorkers) {
+        }
+
+        template<TTrieSize N, bool doCache>
+        QueryServer<N, doCache>::~QueryServer() {
+            release();
+        }
+
+#ifdef __linux__
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::run() throw (Exception) {
+            //Create the listening socket
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            if (_socketPath.size() >= sizeof (address.sun_path)) {
+                throw Exception("The query server socket path is too long: " + _socketPath);
+            }
+            _socketPath.copy(address.sun_path, _socketPath.size());
+
+            _listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (_listenFd < 0) {
+                throw systemError("create the query server socket");
+            }
+            unlink(_socketPath.c_str());
+            if (bind(_listenFd, (sockaddr *) & address, sizeof (address)) < 0) {
+                throw systemError("bind the query server socket");
+            }
+            if (listen(_listenFd, SOMAXCONN) < 0) {
+                throw systemError("listen on the query server socket");
+            }
+
+            //Create the event loop descriptors
+            _epollFd = epoll_create1(EPOLL_CLOEXEC);
+            _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if ((_epollFd < 0) || (_wakeFd < 0)) {
+                throw systemError("create the query server event loop");
+            }
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = _listenFd;
+            epoll_ctl(_epollFd, EPOLL_CTL_ADD, _listenFd, &event);
+            event.data.fd = _wakeFd;
+            epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+
+            //Stop on the termination signals
+            signalWakeFd = _wakeFd;
+            isSignalled = 0;
+            signal(SIGINT, onStopSignal);
+            signal(SIGTERM, onStopSignal);
+
+            //Start the workers
+            vector<thread> workers;
+            for (size_t idx = 0; idx < _numWorkers; idx++) {
+                workers.push_back(thread(&QueryServer<N, doCache>::processRequests, this));
+            }
+
+            LOG_RESULT << "The query server is listening on '" << _socketPath << "' with "
+                    << _numWorkers << " workers, press Ctrl+C to stop it" << END_LOG;
+
+            //Serve the events until stopped, then stop the workers
+            try {
+                serveEvents();
+            } catch (std::exception & ex) {
+                LOG_ERROR << ex.what() << END_LOG;
+            }
+            {
+                lock_guard<mutex> lock(_requestsGuard);
+                _isStopping = true;
+            }
+            _requestsCond.notify_all();
+            for (size_t idx = 0; idx < workers.size(); idx++) {
+                workers[idx].join();
+            }
+
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            signalWakeFd = -1;
+
+            release();
+
+            LOG_RESULT << "The query server is stopped" << END_LOG;
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::stop() {
+            _isStopping = true;
+            wakeUp();
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::wakeUp() {
+            if (_wakeFd >= 0) {
+                const uint64_t one = 1;
+                if (write(_wakeFd, &one, sizeof (one)) < 0) {
+                    LOG_WARNING << "Failed to wake up the query server: " << strerror(errno) << END_LOG;
+                }
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::serveEvents() {
+            epoll_event events[MAX_EPOLL_EVENTS];
+            while (!_isStopping && !isSignalled) {
+                const int numEvents = epoll_wait(_epollFd, events, MAX_EPOLL_EVENTS, -1);
+                if (numEvents < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw systemError("wait for the query server events");
+                }
+
+                for (int idx = 0; idx < numEvents; idx++) {
+                    const int fd = events[idx].data.fd;
+                    if (fd == _listenFd) {
+                        acceptConnections();
+                    } else {
+                        if (fd == _wakeFd) {
+                            //Consume the wake up and watch the connections with pending output
+                            uint64_t count;
+                            if (read(_wakeFd, &count, sizeof (count)) < 0) {
+                                //The wake up was already consumed
+                            }
+                            for (typename map<int, TConnectionPtr>::iterator it = _connections.begin(); it != _connections.end(); ++it) {
+                                SConnection & connection = *it->second;
+                                lock_guard<mutex> lock(connection.guard);
+                                if (connection.isWaiting) {
+                                    watchConnection(connection, true);
+                                }
+                            }
+                        } else {
+                            typename map<int, TConnectionPtr>::iterator found = _connections.find(fd);
+                            if (found == _connections.end()) {
+                                continue;
+                            }
+                            const TConnectionPtr connection = found->second;
+                            bool isAlive = !(events[idx].events & (EPOLLERR | EPOLLHUP)) || (events[idx].events & EPOLLIN);
+                            if (isAlive && (events[idx].events & EPOLLOUT)) {
+                                lock_guard<mutex> lock(connection->guard);
+                                isAlive = sendOutput(*connection);
+                                if (isAlive && connection->output.empty()) {
+                                    connection->isWaiting = false;
+                                    watchConnection(*connection, false);
+                                }
+                            }
+                            if (isAlive && (events[idx].events & EPOLLIN)) {
+                                isAlive = readRequests(connection);
+                            }
+                            if (!isAlive) {
+                                closeConnection(connection);
+                            }
+                        }
+                    }
+                }
+            }
+
+            //Close all the connections
+            while (!_connections.empty()) {
+                closeConnection(_connections.begin()->second);
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::acceptConnections() {
+            while (true) {
+                const int fd = accept4(_listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+                        LOG_WARNING << "Failed to accept a query client: " << strerror(errno) << END_LOG;
+                    }
+                    return;
+                }
+
+                TConnectionPtr connection = make_shared<SConnection>();
+                connection->fd = fd;
+                connection->isClosed = false;
+                connection->isWaiting = false;
+                _connections[fd] = connection;
+
+                epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.fd = fd;
+                epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event);
+
+                LOG_DEBUG << "Accepted a query client, socket: " << fd << END_LOG;
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        bool QueryServer<N, doCache>::readRequests(const TConnectionPtr & connection) {
+            vector<char> & input = connection->input;
+
+            //Read all the available data
+            while (true) {
+                const size_t size = input.size();
+                input.resize(size + READ_CHUNK_SIZE);
+                const ssize_t numRead = recv(connection->fd, &input[size], READ_CHUNK_SIZE, 0);
+                input.resize(size + max<ssize_t>(numRead, 0));
+                if (numRead == 0) {
+                    LOG_DEBUG << "The query client has disconnected, socket: " << connection->fd << END_LOG;
+                    return false;
+                }
+                if (numRead < 0) {
+                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                        break;
+                    }
+                    if (errno != EINTR) {
+                        LOG_WARNING << "Failed to read from a query client: " << strerror(errno) << END_LOG;
+                        return false;
+                    }
+                }
+            }
+
+            //Queue all the complete requests
+            size_t pos = 0;
+            size_t numQueued = 0;
+            while ((input.size() - pos) >= FRAME_HEADER_SIZE) {
+                SRequest request;
+                try {
+                    readFrameHeader(&input[pos], request.header);
+                } catch (Exception & ex) {
+                    LOG_WARNING << "Dropping a query client: " << ex.getMessage() << END_LOG;
+                    return false;
+                }
+                if ((input.size() - pos - FRAME_HEADER_SIZE) < request.header.length) {
+                    break;
+                }
+                pos += FRAME_HEADER_SIZE;
+                request.connection = connection;
+                request.body.assign(input.begin() + pos, input.begin() + pos + request.header.length);
+                pos += request.header.length;
+                {
+                    lock_guard<mutex> lock(_requestsGuard);
+                    _requests.push_back(move(request));
+                }
+                numQueued++;
+            }
+            input.erase(input.begin(), input.begin() + pos);
+
+            if (numQueued == 1) {
+                _requestsCond.notify_one();
+            } else {
+                if (numQueued > 1) {
+                    _requestsCond.notify_all();
+                }
+            }
+            return true;
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::processRequests() {
+            vector<string> words;
+            vector<TWordHashSize> hashes;
+            vector< SFrequencyResult<N> > freqs;
+            while (true) {
+                SRequest request;
+                {
+                    unique_lock<mutex> lock(_requestsGuard);
+                    while (_requests.empty() && !_isStopping) {
+                        _requestsCond.wait(lock);
+                    }
+                    if (_isStopping) {
+                        return;
+                    }
+                    request = move(_requests.front());
+                    _requests.pop_front();
+                }
+                //Any failure only drops the client, it must not take the server down
+                bool isFailed = false;
+                try {
+                    answerRequest(request, words, hashes, freqs);
+                } catch (std::exception & ex) {
+                    LOG_WARNING << "Failed to answer a query request: " << ex.what() << END_LOG;
+                    isFailed = true;
+                } catch (...) {
+                    LOG_WARNING << "Failed to answer a query request!" << END_LOG;
+                    isFailed = true;
+                }
+                if (isFailed) {
+                    lock_guard<mutex> lock(request.connection->guard);
+                    if (!request.connection->isClosed) {
+                        shutdown(request.connection->fd, SHUT_RDWR);
+                    }
+                }
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::answerRequest(SRequest & request, vector<string> & words,
+                                                    vector<TWordHashSize> & hashes,
+                                                    vector< SFrequencyResult<N> > & freqs) {
+            //Validate the N-gram count before sizing anything with it, every
+            //encoded word takes at least its uint16_t length in the body
+            const size_t count = request.header.count;
+            if (count > (request.body.size() / (N * sizeof (uint16_t)))) {
+                throw Exception("The query frame is truncated!");
+            }
+
+            //Prepare the response frame
+            SFrameHeader header = request.header;
+            header.length = getResponseLength(count, N);
+            vector<char> response;
+            response.reserve(FRAME_HEADER_SIZE + header.length);
+            appendFrameHeader(response, header);
+
+            //Read the queries, the buffers keep their capacity between the requests
+            const char * data = request.body.data();
+            const char * const end = data + request.body.size();
+            words.resize(count * N);
+            hashes.resize(count * N);
+            for (size_t idx = 0; idx < count; idx++) {
+                readRequestNGram(data, end, N, &words[idx * N]);
+            }
+            for (size_t pos = 0; pos < words.size(); pos++) {
+                hashes[pos] = computeMurmur64Hash(words[pos]);
+            }
+
+            //Answer the queries as one batch, the lookups are interleaved
+            _trie.queryNGramFreqsBatch(words, hashes, freqs);
+            for (size_t idx = 0; idx < count; idx++) {
+                const char * result = reinterpret_cast<const char *> (freqs[idx].result);
+                response.insert(response.end(), result, result + sizeof (freqs[idx].result));
+            }
+
+            //Send the response, the event loop sends the rest if the socket is full
+            SConnection & connection = *request.connection;
+            lock_guard<mutex> lock(connection.guard);
+            if (!connection.isClosed) {
+                connection.output.insert(connection.output.end(), response.begin(), response.end());
+                if (!connection.isWaiting) {
+                    if (!sendOutput(connection)) {
+                        shutdown(connection.fd, SHUT_RDWR);
+                    } else {
+                        if (!connection.output.empty()) {
+                            connection.isWaiting = true;
+                            wakeUp();
+                        }
+                    }
+                }
+            }
+        }
+
+        template<TTrieSize N, bool doCache>
+        bool QueryServer<N, doCache>::sendOutput(SConnection & connection) {
+            size_t pos = 0;
+            while (pos < connection.output.size()) {
+                const ssize_t numSent = send(connection.fd, &connection.output[pos],
+                        connection.output.size() - pos, MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (numSent < 0) {
+                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                        break;
+                    }
+                    if (errno != EINTR) {
+                        LOG_DEBUG << "Failed to send to a query client: " << strerror(errno) << END_LOG;
+                        return false;
+                    }
+                } else {
+                    pos += numSent;
+                }
+            }
+            connection.output.erase(connection.output.begin(), connection.output.begin() + pos);
+            return true;
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::watchConnection(SConnection & connection, const bool isWriting) {
+            epoll_event event = {};
+            event.events = isWriting ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+            event.data.fd = connection.fd;
+            epoll_ctl(_epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::closeConnection(const TConnectionPtr & connection) {
+            const int fd = connection->fd;
+            {
+                lock_guard<mutex> lock(connection->guard);
+                epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL);
+                close(fd);
+                connection->isClosed = true;
+            }
+            _connections.erase(fd);
+            LOG_DEBUG << "Closed the query client socket: " << fd << END_LOG;
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::release() {
+            if (_listenFd >= 0) {
+                close(_listenFd);
+                unlink(_socketPath.c_str());
+                _listenFd = -1;
+            }
+            if (_epollFd >= 0) {
+                close(_epollFd);
+                _epollFd = -1;
+            }
+            if (_wakeFd >= 0) {
+                close(_wakeFd);
+                _wakeFd = -1;
+            }
+        }
+
+#else
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::run() throw (Exception) {
+            throw Exception("The query server is only supported on Linux!");
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::stop() {
+        }
+
+        template<TTrieSize N, bool doCache>
+        void QueryServer<N, doCache>::release() {
+        }
+
+#endif
+
+        //Make sure that there will be templates instantiated, at least for the given parameter values
+        template class QueryServer<N_GRAM_PARAM, true>;
+        template class QueryServer<N_GRAM_PARAM, false>;
+    }
+}
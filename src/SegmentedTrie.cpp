@@ -0,0 +1,202 @@
+/* 
+ * File:   SegmentedTrie.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:55 PM
+ */
+
+#include "SegmentedTrie.hpp"
+
+#include <sstream>    // std::stringstream
+#include <algorithm>  // std::partial_sort, std::find
+
+#include <unistd.h>   // getpid
+
+#include "Logger.hpp"
+
+namespace tries {
+
+    template<TTrieSize N, bool doCache>
+    SegmentedTrie<N, doCache>::SegmentedTrie(const string & dirName, const size_t maxMemNGrams) throw (Exception)
+    : _dirName(dirName), _maxMemNGrams(maxMemNGrams), _memTrie(NULL), _segments(new TSegments()),
+    _nextSegmentIdx(0), _isStopping(false) {
+        if (maxMemNGrams == 0) {
+            throw Exception("The maximum number of the in-memory N-grams must be positive!");
+        }
+        _memTrie = new TMemTrie();
+        _merger = thread(&SegmentedTrie<N, doCache>::runMerger, this);
+        LOG_DEBUG << "Created a segmented trie with up to " << maxMemNGrams << " in-memory N-grams" << END_LOG;
+    }
+
+    template<TTrieSize N, bool doCache>
+    SegmentedTrie<N, doCache>::SegmentedTrie(const SegmentedTrie& orig) : _maxMemNGrams(0) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    SegmentedTrie<N, doCache>::~SegmentedTrie() {
+        {
+            lock_guard<mutex> lock(_segmentsMutex);
+            _isStopping = true;
+        }
+        _mergeCondition.notify_one();
+        _merger.join();
+        delete _memTrie;
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
+        throw Exception("The word queries are not supported by the segmented trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    SFrequencyResult<N> & SegmentedTrie<N, doCache>::queryWordFreqs(const string & word) throw (Exception) {
+        throw Exception("The word queries are not supported by the segmented trie!");
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs) {
+        _memTrie->queryNGramFreqs(ngram, hashes, freqs);
+
+        //Take a snapshot of the segments, the merged ones stay valid until it is released
+        const shared_ptr<const TSegments> segments = atomic_load(&_segments);
+        for (auto it = segments->begin(); it != segments->end(); ++it) {
+            (*it)->addNGramFreqs(ngram, freqs);
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+        _memTrie->getMemoryStatistics(stats);
+        stats.other += sizeof (*this);
+        const shared_ptr<const TSegments> segments = atomic_load(&_segments);
+        for (auto it = segments->begin(); it != segments->end(); ++it) {
+            stats.other += (*it)->getFileBytes();
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::flush() throw (Exception) {
+        const size_t numNGrams = getNumMemNGrams();
+        if (numNGrams == 0) {
+            return;
+        }
+        const string fileName = getNextSegmentName();
+        LOG_DEBUG << "Flushing " << numNGrams << " N-grams into the segment '" << fileName << "'" << END_LOG;
+        TSegment::write(fileName, *_memTrie);
+        addSegment(openTempSegment(fileName), TSegments());
+
+        delete _memTrie;
+        _memTrie = new TMemTrie();
+    }
+
+    template<TTrieSize N, bool doCache>
+    string SegmentedTrie<N, doCache>::getNextSegmentName() {
+        stringstream name;
+        name << _dirName << "/segment-" << getpid() << "-" << _nextSegmentIdx++ << ".bin";
+        return name.str();
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::attachSegment(const string & fileName) throw (Exception) {
+        addSegment(shared_ptr<TSegment>(new TSegment(fileName)), TSegments());
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::save(const string & fileName) throw (Exception) {
+        flush();
+        const shared_ptr<const TSegments> segments = atomic_load(&_segments);
+        if (segments->empty()) {
+            //The in-memory trie is empty after the flush
+            TSegment::write(fileName, *_memTrie);
+            return;
+        }
+
+        //Merge all the segments one by one, starting from an empty one,
+        //the last merge writes the given file
+        string mergedName = getNextSegmentName();
+        TSegment::write(mergedName, *_memTrie);
+        shared_ptr<TSegment> merged = openTempSegment(mergedName);
+        for (size_t idx = 0; idx < segments->size(); idx++) {
+            mergedName = (idx == (segments->size() - 1)) ? fileName : getNextSegmentName();
+            TSegment::merge(mergedName, *merged, *(*segments)[idx]);
+            if (mergedName != fileName) {
+                merged = openTempSegment(mergedName);
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::addSegment(const shared_ptr<TSegment> & segment, const TSegments & merged) {
+        {
+            lock_guard<mutex> lock(_segmentsMutex);
+            shared_ptr<TSegments> segments(new TSegments());
+            for (auto it = _segments->begin(); it != _segments->end(); ++it) {
+                if (find(merged.begin(), merged.end(), *it) == merged.end()) {
+                    segments->push_back(*it);
+                }
+            }
+            segments->push_back(segment);
+            atomic_store(&_segments, shared_ptr<const TSegments>(segments));
+        }
+        _mergeCondition.notify_one();
+    }
+
+    template<TTrieSize N, bool doCache>
+    void SegmentedTrie<N, doCache>::runMerger() {
+        unique_lock<mutex> lock(_segmentsMutex);
+        while (true) {
+            _mergeCondition.wait(lock, [this] {
+                return _isStopping || (_segments->size() >= SEGMENT_MERGE_FACTOR);
+            });
+            if (_isStopping) {
+                return;
+            }
+
+            //Merge the two smallest segments, this keeps the merge costs logarithmic
+            TSegments merged(*_segments);
+            partial_sort(merged.begin(), merged.begin() + 2, merged.end(),
+                         [] (const shared_ptr<TSegment> & first, const shared_ptr<TSegment> & second) {
+                             return first->getFileBytes() < second->getFileBytes();
+                         });
+            merged.resize(2);
+            lock.unlock();
+
+            try {
+                const string fileName = getNextSegmentName();
+                LOG_DEBUG << "Merging the segments '" << merged[0]->getFileName() << "' and '"
+                        << merged[1]->getFileName() << "' into '" << fileName << "'" << END_LOG;
+                TSegment::merge(fileName, *merged[0], *merged[1]);
+                addSegment(openTempSegment(fileName), merged);
+            } catch (Exception & ex) {
+                //The segments are still valid, just not merged any more
+                LOG_ERROR << "Stopped merging the segments: " << ex.getMessage() << END_LOG;
+                return;
+            }
+            merged.clear();
+
+            lock.lock();
+        }
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class SegmentedTrie<N_GRAM_PARAM, true>;
+    template class SegmentedTrie<N_GRAM_PARAM, false>;
+}
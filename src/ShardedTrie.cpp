@@ -0,0 +1,263 @@
+/* 
+ * File:   ShardedTrie.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 11:40 AM
+ */
+#include "ShardedTrie.hpp"
+
+#include <algorithm>  // std::partial_sort, std::min
+
+#include "Logger.hpp"
+
+namespace tries {
+
+    template<TTrieSize N, bool doCache>
+    ShardedTrie<N, doCache>::ShardedTrie(const size_t numShards) throw (Exception) {
+        if (numShards == 0) {
+            throw Exception("The number of trie shards must be positive!");
+        }
+        for (size_t idx = 0; idx < numShards; idx++) {
+            shards.push_back(new TShard());
+        }
+        LOG_DEBUG << "Created a trie with " << numShards << " shards" << END_LOG;
+    }
+
+    template<TTrieSize N, bool doCache>
+    ShardedTrie<N, doCache>::ShardedTrie(const ShardedTrie& orig) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    ShardedTrie<N, doCache>::~ShardedTrie() {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            delete shards[idx];
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::addWords(const vector<string> &tokens, const vector<TWordHashSize> &hashes) {
+        //Add the words one by one, each to its own shard
+        vector<string> token(1);
+        vector<TWordHashSize> hash(1);
+        for (size_t idx = 0; idx < tokens.size(); idx++) {
+            token[0] = tokens[idx];
+            hash[0] = hashes[idx];
+            shards[getPartitionIndex(hashes[idx])]->addWords(token, hash);
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::addNGram(const vector<string> &tokens, const vector<TWordHashSize> &hashes, const int idx, const int n) {
+        shards[getPartitionIndex(hashes[idx + n - 1])]->addNGram(tokens, hashes, idx, n);
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::resetQueryCache() {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->resetQueryCache();
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::compact() throw (Exception) {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->compact();
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::buildContinuations() throw (Exception) {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->buildContinuations();
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::topContinuations(const vector<string> & context, const vector<TWordHashSize> & hashes,
+                                                   const size_t k, vector<TContinuation> & result) const throw (Exception) {
+        result.clear();
+        vector<TContinuation> shardResult;
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->topContinuations(context, hashes, k, shardResult);
+            result.insert(result.end(), shardResult.begin(), shardResult.end());
+        }
+        const size_t numResults = min(k, result.size());
+        partial_sort(result.begin(), result.begin() + numResults, result.end(),
+                     [] (const TContinuation & first, const TContinuation & second) {
+                         return first.second > second.second;
+                     });
+        result.resize(numResults);
+    }
+
+    /**
+     * This is the cursor going over the N-grams matching a pattern in the shards,
+     * the shards' cursors are opened one at a time, @see ShardedTrie::findNGrams
+     */
+    template<TTrieSize N, bool doCache>
+    class ShardedTrie<N, doCache>::NGramShardsCursor final : public ANGramCursor {
+    public:
+
+        /**
+         * The basic constructor
+         * @param shards the shards to search in
+         * @param pattern the pattern words
+         * @param hashes the pattern words' hashes
+         */
+        NGramShardsCursor(const vector<TShard *> & shards, const vector<string> & pattern, const vector<TWordHashSize> & hashes)
+        : _shards(shards), _pattern(pattern), _hashes(hashes), _shardIdx(0) {
+        }
+
+        /**
+         * For more details @see ANGramCursor
+         */
+        virtual bool next(vector<string> & words, TFrequencySize & freq) {
+            while (_shardIdx < _shards.size()) {
+                if (!_cursor) {
+                    _cursor = _shards[_shardIdx]->findNGrams(_pattern, _hashes);
+                }
+                if (_cursor->next(words, freq)) {
+                    return true;
+                }
+                _cursor.reset();
+                _shardIdx++;
+            }
+            return false;
+        }
+
+    private:
+        //The shards to search in
+        const vector<TShard *> & _shards;
+        //The pattern words and their hashes
+        const vector<string> _pattern;
+        const vector<TWordHashSize> _hashes;
+        //The index of the current shard
+        size_t _shardIdx;
+        //The cursor of the current shard
+        unique_ptr<ANGramCursor> _cursor;
+    };
+
+    template<TTrieSize N, bool doCache>
+    unique_ptr<ANGramCursor> ShardedTrie<N, doCache>::findNGrams(const vector<string> & pattern,
+                                                                 const vector<TWordHashSize> & hashes) const throw (Exception) {
+        return unique_ptr<ANGramCursor>(new NGramShardsCursor(shards, pattern, hashes));
+    }
+
+    template<TTrieSize N, bool doCache>
+    size_t ShardedTrie<N, doCache>::getNumNGrams(const TTrieSize L) const throw (Exception) {
+        size_t numNGrams = 0;
+        if (L == 1) {
+            visitNGrams(L, [&numNGrams] (const vector<string> & words, const SNGramData & data) {
+                numNGrams++;
+            });
+        } else {
+            for (size_t idx = 0; idx < shards.size(); idx++) {
+                numNGrams += shards[idx]->getNumCountedNGrams(L);
+            }
+        }
+        return numNGrams;
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::visitNGrams(const TTrieSize L, const TNGramVisitor & visitor) const throw (Exception) {
+        visitNGramsChunk(L, 0, 1, visitor);
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::visitNGramsChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                                   const TNGramVisitor & visitor) const throw (Exception) {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            if (L == 1) {
+                shards[idx]->visitNGramsChunk(L, chunkIdx, numChunks, [&] (const vector<string> & words, const SNGramData & data) {
+                    if (getPartitionIndex(computeMurmur64Hash(words[0])) == idx) {
+                        visitor(words, data);
+                    }
+                });
+            } else {
+                shards[idx]->visitNGramsChunk(L, chunkIdx, numChunks, [&] (const vector<string> & words, const SNGramData & data) {
+                    if (data.freq > 0) {
+                        visitor(words, data);
+                    }
+                });
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::getMemoryStatistics(SMemoryStatistics<N> & stats) const throw (Exception) {
+        fill(stats.levels, stats.levels + N, SMemoryUsage());
+        stats.other = sizeof (*this) + shards.capacity() * sizeof (TShard *);
+        SMemoryStatistics<N> shardStats;
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->getMemoryStatistics(shardStats);
+            for (TTrieSize level = 0; level < N; level++) {
+                stats.levels[level].add(shardStats.levels[level]);
+            }
+            stats.other += shardStats.other;
+        }
+
+        //The shards' words and prefix entries of the other shards' N-grams are replicas
+        for (TTrieSize level = 0; level < N; level++) {
+            SMemoryUsage & usage = stats.levels[level];
+            const size_t numNGrams = getNumNGrams(level + 1);
+            usage.numReplicas += usage.numNGrams - numNGrams;
+            usage.numNGrams = numNGrams;
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::setHotRegionCounting(const bool isCounting) throw (Exception) {
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->setHotRegionCounting(isCounting);
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::getHotRegionStatistics(SHotRegionStatistics<N> & stats) const throw (Exception) {
+        fill(stats.levels, stats.levels + N, SHotRegionUsage());
+        SHotRegionStatistics<N> shardStats;
+        for (size_t idx = 0; idx < shards.size(); idx++) {
+            shards[idx]->getHotRegionStatistics(shardStats);
+            for (TTrieSize level = 0; level < N; level++) {
+                stats.levels[level].add(shardStats.levels[level]);
+            }
+        }
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::queryWordFreqs(const string & word, SFrequencyResult<N> & result) throw (Exception) {
+        shards[getPartitionIndex(computeMurmur64Hash(word))]->queryWordFreqs(word, result);
+    }
+
+    template<TTrieSize N, bool doCache>
+    SFrequencyResult<N> & ShardedTrie<N, doCache>::queryWordFreqs(const string & word) throw (Exception) {
+        return shards[getPartitionIndex(computeMurmur64Hash(word))]->queryWordFreqs(word);
+    }
+
+    template<TTrieSize N, bool doCache>
+    void ShardedTrie<N, doCache>::queryNGramFreqs(const vector<string> & ngram, const vector<TWordHashSize> & hashes, SFrequencyResult<N> & freqs) {
+        //The query is answered by the shard of the N-gram's last word
+        shards[getPartitionIndex(hashes[N - 1])]->queryNGramFreqs(ngram, hashes, freqs);
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class ShardedTrie<N_GRAM_PARAM, true>;
+    template class ShardedTrie<N_GRAM_PARAM, false>;
+}
@@ -0,0 +1,185 @@
+/* 
+ * File:   TextTokenizer.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 11:05 AM
+ */
+#include "TextTokenizer.hpp"
+
+#include <cstring>   //std::memchr
+
+#include "HashingUtils.hpp"
+#include "Logger.hpp"
+
+//The SIMD kernels are only available on the x86 platforms
+#if defined(__x86_64__) || defined(__i386__)
+#define TOKENIZER_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define TOKENIZER_X86_KERNELS 0
+#endif
+
+using namespace hashing;
+
+namespace tries {
+namespace ngrams {
+
+    /**
+     * Splits the data from the given offset on, byte by byte, and appends the
+     * last token, if it is not empty. This finishes the work of all the kernels.
+     * @param data the data to split
+     * @param offset the offset to start the search from
+     * @param len the data length
+     * @param delim the delimiter
+     * @param begin the begin of the current token
+     * @param tokens the vector to append the tokens to
+     */
+    static inline void splitTail(const char * data, size_t offset, const size_t len,
+                                 const char delim, const char * begin, vector<string> & tokens) {
+        const char * const end = data + len;
+        const char * pos = data + offset;
+        while ((pos = (const char *) memchr(pos, delim, end - pos)) != NULL) {
+            tokens.emplace_back(begin, pos - begin);
+            begin = ++pos;
+        }
+        //The getline does not give the trailing empty token
+        if (begin != end) {
+            tokens.emplace_back(begin, end - begin);
+        }
+    }
+
+    /**
+     * The scalar delimiter search kernel
+     * For more details @see TextTokenizer::TSplitFunction
+     */
+    static void splitScalar(const char * data, const size_t len, const char delim, vector<string> & tokens) {
+        splitTail(data, 0, len, delim, data, tokens);
+    }
+
+#if TOKENIZER_X86_KERNELS
+
+    /**
+     * The SSE2 delimiter search kernel, compares 16 bytes at a time
+     * For more details @see TextTokenizer::TSplitFunction
+     */
+    __attribute__((target("sse2")))
+    static void splitSSE2(const char * data, const size_t len, const char delim, vector<string> & tokens) {
+        const __m128i pattern = _mm_set1_epi8(delim);
+        const char * begin = data;
+        size_t offset = 0;
+        for (; (offset + sizeof (__m128i)) <= len; offset += sizeof (__m128i)) {
+            const __m128i chunk = _mm_loadu_si128((const __m128i *) (data + offset));
+            uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+            while (mask) {
+                const char * pos = data + offset + __builtin_ctz(mask);
+                tokens.emplace_back(begin, pos - begin);
+                begin = pos + 1;
+                mask &= mask - 1;
+            }
+        }
+        splitTail(data, offset, len, delim, begin, tokens);
+    }
+
+    /**
+     * The AVX2 delimiter search kernel, compares 32 bytes at a time
+     * For more details @see TextTokenizer::TSplitFunction
+     */
+    __attribute__((target("avx2")))
+    static void splitAVX2(const char * data, const size_t len, const char delim, vector<string> & tokens) {
+        const __m256i pattern = _mm256_set1_epi8(delim);
+        const char * begin = data;
+        size_t offset = 0;
+        for (; (offset + sizeof (__m256i)) <= len; offset += sizeof (__m256i)) {
+            const __m256i chunk = _mm256_loadu_si256((const __m256i *) (data + offset));
+            uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern));
+            while (mask) {
+                const char * pos = data + offset + __builtin_ctz(mask);
+                tokens.emplace_back(begin, pos - begin);
+                begin = pos + 1;
+                mask &= mask - 1;
+            }
+        }
+        splitTail(data, offset, len, delim, begin, tokens);
+    }
+#endif
+
+    /**
+     * Selects the best delimiter search kernel supported by the CPU
+     * @param name the out parameter for the kernel name
+     * @return the kernel function
+     */
+    static TextTokenizer::TSplitFunction selectSplitFunction(const char * & name) {
+#if TOKENIZER_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            name = "avx2";
+            return &splitAVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            name = "sse2";
+            return &splitSSE2;
+        }
+#endif
+        name = "scalar";
+        return &splitScalar;
+    }
+
+    //The kernel name is set by the kernel selection
+    static const char * selectedSplitFunctionName = NULL;
+
+    const TextTokenizer::TSplitFunction TextTokenizer::splitFunction = selectSplitFunction(selectedSplitFunctionName);
+    const char * const TextTokenizer::splitFunctionName = selectedSplitFunctionName;
+
+    const char * TextTokenizer::getKernelName() {
+        return splitFunctionName;
+    }
+
+    void TextTokenizer::hashTokens(const vector<string> & tokens, const size_t begin, vector<TWordHashSize> & hashes) {
+        const size_t end = tokens.size();
+        size_t pos = hashes.size();
+        hashes.resize(pos + (end - begin));
+
+        //Hash the tokens in groups of lanes
+        size_t idx = begin;
+        for (; (idx + NUM_HASH_LANES) <= end; idx += NUM_HASH_LANES, pos += NUM_HASH_LANES) {
+            const char * data[NUM_HASH_LANES];
+            size_t len[NUM_HASH_LANES];
+            for (uint8_t lane = 0; lane < NUM_HASH_LANES; lane++) {
+                data[lane] = tokens[idx + lane].data();
+                len[lane] = tokens[idx + lane].length();
+            }
+            computeMurmur64Hashes<NUM_HASH_LANES>(data, len, &hashes[pos]);
+        }
+
+        //Hash the remaining tokens one by one
+        for (; idx < end; idx++, pos++) {
+            hashes[pos] = computeMurmur64Hash(tokens[idx]);
+        }
+    }
+
+    void TextTokenizer::tokenize(const string & data, const char delim,
+                                 vector<string> & tokens, vector<TWordHashSize> & hashes) {
+        const size_t begin = tokens.size();
+        splitFunction(data.data(), data.length(), delim, tokens);
+        hashTokens(tokens, begin, hashes);
+    }
+}
+}
@@ -25,53 +25,293 @@
 
 #include "TrieBuilder.hpp"
 
+#include <thread>       // std::thread
+#include <exception>    // std::exception_ptr
+#include <memory>       // std::unique_ptr
+#include <sstream>      // std::stringstream
+#include <algorithm>    // std::min
+
 #include "Logger.hpp"
 #include "NGramBuilder.hpp"
+#include "HashMapTrie.hpp"
+#include "ShardedTrie.hpp"
+#include "SegmentedTrie.hpp"
+#include "ConcurrentTrie.hpp"
+#include "EliasFanoTrie.hpp"
 #include "Globals.hpp"
 
 namespace tries {
 
     using ngrams::NGramBuilder;
+
+    /**
+     * Re-throws the first error thrown by the worker threads, if any,
+     * the trie is not usable after it
+     * @param errors the errors of the worker threads, one per thread
+     */
+    static void rethrowFirstError(const vector<exception_ptr> & errors) {
+        for (size_t idx = 0; idx < errors.size(); idx++) {
+            if (errors[idx]) {
+                rethrow_exception(errors[idx]);
+            }
+        }
+    }
     
-    template<TTrieSize N, bool doCache>
-    TrieBuilder<N,doCache>::TrieBuilder(ATrie<N,doCache> & trie, ifstream & fstr, const char delim) : _trie(trie), _fstr(fstr),_delim(delim){
+    template<TTrieSize N, bool doCache, typename TTrie>
+    TrieBuilder<N,doCache,TTrie>::TrieBuilder(TTrie & trie, ifstream & fstr, const char delim, const size_t maxBytes)
+        : _trie(trie), _fstr(fstr), _delim(delim), _maxBytes(maxBytes), _numBytes(0) {
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    TrieBuilder<N,doCache,TTrie>::TrieBuilder(const TrieBuilder<N,doCache,TTrie>& orig)
+        : _trie(orig._trie), _fstr(orig._fstr), _delim(orig._delim), _maxBytes(orig._maxBytes), _numBytes(orig._numBytes) {
     }
 
-    template<TTrieSize N, bool doCache>
-    TrieBuilder<N,doCache>::TrieBuilder(const TrieBuilder<N,doCache>& orig) : _trie(orig._trie), _fstr(orig._fstr), _delim(orig._delim) {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    size_t TrieBuilder<N,doCache,TTrie>::getLineStart(ifstream & fstr, const size_t pos, const size_t fileBytes) {
+        if ((pos == 0) || (pos >= fileBytes)) {
+            return min(pos, fileBytes);
+        }
+        //Skip the rest of the line the previous byte belongs to
+        string rest;
+        fstr.clear();
+        fstr.seekg(pos - 1);
+        getline(fstr, rest);
+        const istream::pos_type start = fstr.good() ? fstr.tellg() : istream::pos_type(-1);
+        fstr.clear();
+        return (start == istream::pos_type(-1)) ? fileBytes : static_cast<size_t> (start);
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    size_t TrieBuilder<N,doCache,TTrie>::seekRange(ifstream & fstr, const size_t rangeIdx, const size_t numRanges) throw (Exception) {
+        if (rangeIdx >= numRanges) {
+            stringstream msg;
+            msg << "The range index " << rangeIdx << " is out of bounds, there are " << numRanges << " ranges!";
+            throw Exception(msg.str());
+        }
+        const size_t fileBytes = Logger::getRemainingBytes(fstr);
+        const size_t begin = getLineStart(fstr, (fileBytes / numRanges) * rangeIdx, fileBytes);
+        const size_t end = (rangeIdx == (numRanges - 1)) ? fileBytes
+                : getLineStart(fstr, (fileBytes / numRanges) * (rangeIdx + 1), fileBytes);
+        fstr.seekg(begin);
+        if (!fstr) {
+            throw Exception("Could not position the file stream at the range beginning!");
+        }
+        LOG_DEBUG << "The range " << rangeIdx << " of " << numRanges << " is [" << begin << ", " << end << ")" << END_LOG;
+        return (end > begin) ? (end - begin) : 0;
     }
 
-    template<TTrieSize N, bool doCache>
-    TrieBuilder<N,doCache>::~TrieBuilder() {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    TrieBuilder<N,doCache,TTrie>::~TrieBuilder() {
     }
 
-    template<TTrieSize N, bool doCache>
-    void TrieBuilder<N,doCache>::build() {
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void TrieBuilder<N,doCache,TTrie>::build() throw (Exception) {
         LOG_DEBUG << "Starting to read the file and build the trie ..." << END_LOG;
+        LOG_INFO << "Using the '" << ngrams::TextTokenizer::getKernelName() << "' tokenizer kernel" << END_LOG;
         
+        //Do the progress bard indicator
+        Logger::startProgressBar(min(Logger::getRemainingBytes(_fstr), _maxBytes));
+
+        try {
+            if (_trie.getNumPartitions() > 1) {
+                buildPartitioned();
+            } else if (_trie.getNumBuildThreads() > 0) {
+                buildConcurrent();
+            } else {
+                buildSequential();
+            }
+        } catch (...) {
+            //Stop the progress ticker thread before leaving
+            Logger::stopProgressBar();
+            throw;
+        }
+
+        Logger::stopProgressBar();
+
+        //The counts have changed, e.g. if the trie was not empty, so the cached results are stale
+        _trie.resetQueryCache();
+
+        LOG_DEBUG << "Done reading the file and building the trie." << END_LOG;
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void TrieBuilder<N,doCache,TTrie>::buildSequential() {
         //Initialize the NGram builder and give it the trie as an argument
-        NGramBuilder<N,doCache> ngBuilder(_trie,_delim);
+        NGramBuilder<N,doCache,TTrie> ngBuilder(_trie,_delim);
 
-        //Do the progress bard indicator
-        Logger::startProgressBar();
-        
         //Iterate through the file and build n-grams per line and fill in the trie
         string line;
-        while( getline(_fstr, line) )
+        while( readLine(line) )
         {
-            LOG_DEBUG << line << END_LOG;
             ngBuilder.processString(line);
-            Logger::updateProgressBar();
         }
+    }
 
-        Logger::stopProgressBar();
+    template<TTrieSize N, bool doCache, typename TTrie>
+    bool TrieBuilder<N,doCache,TTrie>::readBatch(vector<string> & lines, const size_t maxLines) {
+        lines.clear();
+        string line;
+        while( (lines.size() < maxLines) && readLine(line) ) {
+            lines.push_back(line);
+        }
+        return !lines.empty();
+    }
 
-        LOG_DEBUG << "Done reading the file and building the trie." << END_LOG;
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void TrieBuilder<N,doCache,TTrie>::buildPartitioned() throw (Exception) {
+        const size_t numParts = _trie.getNumPartitions();
+        LOG_INFO << "Filling in " << numParts << " trie partitions concurrently" << END_LOG;
+
+        //Create one N-gram builder per partition, filling in the partition's concrete type
+        typedef NGramBuilder<N, doCache, typename TTrie::TPartition> TPartitionBuilder;
+        vector< unique_ptr<TPartitionBuilder> > builders;
+        for (size_t partIdx = 0; partIdx < numParts; partIdx++) {
+            builders.push_back(unique_ptr<TPartitionBuilder>(
+                    new TPartitionBuilder(_trie, _trie.getPartition(partIdx), partIdx, _delim)));
+        }
+
+        //The errors thrown by the worker threads, one per thread
+        vector<exception_ptr> errors(numParts);
+
+        vector<string> lines;
+        vector< vector<string> > tokens;
+        vector< vector<TWordHashSize> > hashes;
+        while (readBatch(lines, TRIE_BUILD_BATCH_LINES)) {
+            tokens.resize(lines.size());
+            hashes.resize(lines.size());
+
+            //Phase one: tokenize and hash the lines, thread k takes every k'th line
+            vector<thread> workers;
+            for (size_t thIdx = 0; thIdx < numParts; thIdx++) {
+                workers.push_back(thread([&, thIdx]() {
+                    try {
+                        for (size_t lineIdx = thIdx; lineIdx < lines.size(); lineIdx += numParts) {
+                            tokens[lineIdx].clear();
+                            hashes[lineIdx].clear();
+                            ngrams::TextTokenizer::tokenize(lines[lineIdx], _delim, tokens[lineIdx], hashes[lineIdx]);
+                        }
+                    } catch (...) {
+                        errors[thIdx] = current_exception();
+                    }
+                }));
+            }
+            for (size_t thIdx = 0; thIdx < numParts; thIdx++) {
+                workers[thIdx].join();
+            }
+            workers.clear();
+            rethrowFirstError(errors);
+
+            //Phase two: every partition is filled in by its own thread
+            for (size_t partIdx = 0; partIdx < numParts; partIdx++) {
+                workers.push_back(thread([&, partIdx]() {
+                    try {
+                        for (size_t lineIdx = 0; lineIdx < lines.size(); lineIdx++) {
+                            builders[partIdx]->processTokens(tokens[lineIdx], hashes[lineIdx]);
+                        }
+                    } catch (...) {
+                        errors[partIdx] = current_exception();
+                    }
+                }));
+            }
+            for (size_t partIdx = 0; partIdx < numParts; partIdx++) {
+                workers[partIdx].join();
+            }
+            rethrowFirstError(errors);
+        }
+    }
+
+    template<TTrieSize N, bool doCache, typename TTrie>
+    void TrieBuilder<N,doCache,TTrie>::buildConcurrent() throw (Exception) {
+        const size_t numThreads = _trie.getNumBuildThreads();
+        LOG_INFO << "Filling in the trie with " << numThreads << " concurrent threads" << END_LOG;
+
+        //The errors thrown by the worker threads and their numbers of tokens, one per thread
+        vector<exception_ptr> errors(numThreads);
+        vector<size_t> numTokens(numThreads);
+
+        vector<string> lines;
+        vector< vector<string> > tokens;
+        vector< vector<TWordHashSize> > hashes;
+        while (readBatch(lines, CONCURRENT_BUILD_BATCH_LINES)) {
+            tokens.resize(lines.size());
+            hashes.resize(lines.size());
+
+            //Phase one: tokenize and hash the lines, thread k takes every k'th line
+            vector<thread> workers;
+            for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+                workers.push_back(thread([&, thIdx]() {
+                    numTokens[thIdx] = 0;
+                    try {
+                        for (size_t lineIdx = thIdx; lineIdx < lines.size(); lineIdx += numThreads) {
+                            tokens[lineIdx].clear();
+                            hashes[lineIdx].clear();
+                            ngrams::TextTokenizer::tokenize(lines[lineIdx], _delim, tokens[lineIdx], hashes[lineIdx]);
+                            numTokens[thIdx] += tokens[lineIdx].size();
+                        }
+                    } catch (...) {
+                        errors[thIdx] = current_exception();
+                    }
+                }));
+            }
+            for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+                workers[thIdx].join();
+            }
+            workers.clear();
+            rethrowFirstError(errors);
+
+            //Make room for the batch, no thread is using the trie now
+            size_t batchTokens = 0;
+            for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+                batchTokens += numTokens[thIdx];
+            }
+            _trie.reserve(batchTokens);
+
+            //Phase two: every thread adds its lines' words and N-grams into the trie
+            for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+                workers.push_back(thread([&, thIdx]() {
+                    try {
+                        NGramBuilder<N, doCache, TTrie> ngBuilder(_trie, _delim);
+                        for (size_t lineIdx = thIdx; lineIdx < lines.size(); lineIdx += numThreads) {
+                            ngBuilder.processTokens(tokens[lineIdx], hashes[lineIdx]);
+                        }
+                    } catch (...) {
+                        errors[thIdx] = current_exception();
+                    }
+                }));
+            }
+            for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+                workers[thIdx].join();
+            }
+            rethrowFirstError(errors);
+        }
     }
     
     //Make sure that there will be templates instantiated, at least for the given parameter values
     template class TrieBuilder< N_GRAM_PARAM,true >;
     template class TrieBuilder< N_GRAM_PARAM,false >;
+
+    //The builders filling in the concrete tries directly
+    template class TrieBuilder< N_GRAM_PARAM,true,TFiveCacheHashMapTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,false,TFiveNoCacheHashMapTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,true,TFiveCacheShardedTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,false,TFiveNoCacheShardedTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,true,TFiveCacheSegmentedTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,false,TFiveNoCacheSegmentedTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,true,TFiveCacheConcurrentTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,false,TFiveNoCacheConcurrentTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,true,TFiveCacheEliasFanoTrie >;
+    template class TrieBuilder< N_GRAM_PARAM,false,TFiveNoCacheEliasFanoTrie >;
+#if TRIE_POLICY_COMBINATIONS
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,MurmurHashPolicy,NodeMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,MurmurHashPolicy,FlatMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,AdaptiveMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,NodeMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,Djb2HashPolicy,FlatMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,AdaptiveMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,NodeMapPolicy> >;
+    template class TrieBuilder< N_GRAM_PARAM,true,HashMapTrie<N_GRAM_PARAM,true,PrimesHashPolicy,FlatMapPolicy> >;
+#endif
 }
 
 
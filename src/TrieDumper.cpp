@@ -0,0 +1,193 @@
+/* 
+ * File:   TrieDumper.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 06:05 PM
+ */
+
+#include "TrieDumper.hpp"
+
+#include <fstream>      // std::ofstream
+#include <sstream>      // std::stringstream
+#include <iomanip>      // std::setw, std::setfill
+#include <algorithm>    // std::sort, std::fill
+#include <thread>       // std::thread
+#include <atomic>       // std::atomic
+#include <exception>    // std::exception_ptr
+
+#include "Logger.hpp"
+
+namespace tries {
+
+    template<TTrieSize N, bool doCache>
+    TrieDumper<N, doCache>::TrieDumper(const ATrie<N, doCache> & trie, const string & dirName,
+                                       const size_t numThreads) throw (Exception)
+    : _trie(trie), _dirName(dirName), _numThreads(numThreads) {
+        if (_numThreads == 0) {
+            throw Exception("The number of the dumper threads must be positive!");
+        }
+        fill(_stats, _stats + N, SLevelCountStats());
+    }
+
+    template<TTrieSize N, bool doCache>
+    TrieDumper<N, doCache>::TrieDumper(const TrieDumper& orig)
+    : _trie(orig._trie), _dirName(orig._dirName), _numThreads(orig._numThreads) {
+    }
+
+    template<TTrieSize N, bool doCache>
+    TrieDumper<N, doCache>::~TrieDumper() {
+    }
+
+    template<TTrieSize N, bool doCache>
+    string TrieDumper<N, doCache>::getChunkFileName(const TTrieSize L, const size_t chunkIdx) const {
+        stringstream name;
+        name << _dirName << "/ngrams-" << L << "-" << setw(5) << setfill('0') << (chunkIdx + 1) << ".txt";
+        return name.str();
+    }
+
+    template<TTrieSize N, bool doCache>
+    void TrieDumper<N, doCache>::dump() throw (Exception) {
+        //Split every level into chunks, there are at least as many chunks as threads
+        vector< pair<TTrieSize, size_t> > chunks;
+        size_t numChunks[N];
+        for (TTrieSize L = 1; L <= N; L++) {
+            const size_t numNGrams = _trie.getNumNGrams(L);
+            numChunks[L - 1] = max((numNGrams + DUMP_CHUNK_NGRAMS - 1) / DUMP_CHUNK_NGRAMS, _numThreads);
+            for (size_t chunkIdx = 0; chunkIdx < numChunks[L - 1]; chunkIdx++) {
+                chunks.push_back(make_pair(L, chunkIdx));
+            }
+        }
+        LOG_DEBUG << "Dumping " << chunks.size() << " chunks with " << _numThreads << " threads ..." << END_LOG;
+
+        //The threads take the chunks one by one and add up their own statistics,
+        //the first error makes the other threads stop after their current chunk
+        atomic<size_t> nextChunk(0);
+        vector< vector<SLevelCountStats> > threadStats(_numThreads, vector<SLevelCountStats>(N, SLevelCountStats()));
+        vector<exception_ptr> errors(_numThreads);
+        vector<thread> workers;
+        for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+            workers.push_back(thread([&, thIdx]() {
+                try {
+                    size_t idx;
+                    while ((idx = nextChunk.fetch_add(1)) < chunks.size()) {
+                        const TTrieSize L = chunks[idx].first;
+                        dumpChunk(L, chunks[idx].second, numChunks[L - 1], threadStats[thIdx][L - 1]);
+                    }
+                } catch (...) {
+                    errors[thIdx] = current_exception();
+                    nextChunk.store(chunks.size());
+                }
+            }));
+        }
+        for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+            workers[thIdx].join();
+        }
+        for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+            if (errors[thIdx]) {
+                rethrow_exception(errors[thIdx]);
+            }
+        }
+
+        //Add up the threads' statistics
+        fill(_stats, _stats + N, SLevelCountStats());
+        for (size_t thIdx = 0; thIdx < _numThreads; thIdx++) {
+            for (TTrieSize level = 0; level < N; level++) {
+                const SLevelCountStats & stats = threadStats[thIdx][level];
+                _stats[level].types += stats.types;
+                _stats[level].tokens += stats.tokens;
+                for (size_t idx = 0; idx <= DUMP_COUNT_OF_COUNTS; idx++) {
+                    _stats[level].countOfCounts[idx] += stats.countOfCounts[idx];
+                }
+            }
+        }
+        writeStatistics();
+    }
+
+    template<TTrieSize N, bool doCache>
+    void TrieDumper<N, doCache>::dumpChunk(const TTrieSize L, const size_t chunkIdx, const size_t numChunks,
+                                           SLevelCountStats & stats) const throw (Exception) {
+        //Collect the chunk's N-grams as the lines' keys and frequencies
+        vector< pair<string, TFrequencySize> > records;
+        _trie.visitNGramsChunk(L, chunkIdx, numChunks, [&] (const vector<string> & words, const SNGramData & data) {
+            if (data.freq > 0) {
+                records.push_back(make_pair(words[0], data.freq));
+                string & key = records.back().first;
+                for (size_t idx = 1; idx < words.size(); idx++) {
+                    key += ' ';
+                    key += words[idx];
+                }
+            }
+        });
+        sort(records.begin(), records.end());
+
+        //Write the sorted lines at once and count them
+        string text;
+        for (auto it = records.begin(); it != records.end(); ++it) {
+            text += it->first;
+            text += '\t';
+            text += to_string(it->second);
+            text += '\n';
+            stats.types++;
+            stats.tokens += it->second;
+            stats.countOfCounts[min<size_t>(it->second, DUMP_COUNT_OF_COUNTS + 1) - 1]++;
+        }
+        const string fileName = getChunkFileName(L, chunkIdx);
+        ofstream fstr(fileName.c_str(), ios::binary);
+        if (!fstr.is_open()) {
+            throw Exception("Can not create the dump file: " + fileName);
+        }
+        fstr.write(text.data(), text.size());
+        fstr.close();
+        if (!fstr) {
+            throw Exception("Failed to write the dump file: " + fileName);
+        }
+        LOG_DEBUG1 << "Dumped " << records.size() << " " << L << "-grams into " << fileName << END_LOG;
+    }
+
+    template<TTrieSize N, bool doCache>
+    void TrieDumper<N, doCache>::writeStatistics() const throw (Exception) {
+        const string fileName = _dirName + "/statistics.txt";
+        ofstream fstr(fileName.c_str());
+        if (!fstr.is_open()) {
+            throw Exception("Can not create the statistics file: " + fileName);
+        }
+        fstr << "order\ttypes\ttokens";
+        for (size_t idx = 1; idx <= DUMP_COUNT_OF_COUNTS; idx++) {
+            fstr << "\tn" << idx;
+        }
+        fstr << "\tn>" << DUMP_COUNT_OF_COUNTS << "\n";
+        for (TTrieSize level = 0; level < N; level++) {
+            fstr << (level + 1) << '\t' << _stats[level].types << '\t' << _stats[level].tokens;
+            for (size_t idx = 0; idx <= DUMP_COUNT_OF_COUNTS; idx++) {
+                fstr << '\t' << _stats[level].countOfCounts[idx];
+            }
+            fstr << "\n";
+        }
+        fstr.close();
+        if (!fstr) {
+            throw Exception("Failed to write the statistics file: " + fileName);
+        }
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class TrieDumper<N_GRAM_PARAM, true>;
+    template class TrieDumper<N_GRAM_PARAM, false>;
+}
@@ -0,0 +1,401 @@
+/* 
+ * File:   TrieSegment.cpp
+ * Author: Dr. Ivan S. Zapreev
+ *
+ * Visit my Linked-in profile:
+ *      <https://nl.linkedin.com/in/zapreevis>
+ * Visit my GitHub:
+ *      <https://github.com/ivan-zapreev>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.#
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Created on October 19, 2026, 02:10 PM
+ */
+
+#include "TrieSegment.hpp"
+
+#include <cstring>        // std::memcpy, std::memcmp, std::strncmp
+#include <cstdio>         // std::remove, std::rename
+#include <algorithm>      // std::sort
+#include <limits>         // std::numeric_limits
+#include <unordered_map>  // std::unordered_map
+
+#include <fcntl.h>        // open
+#include <unistd.h>       // close
+#include <sys/stat.h>     // fstat
+#include <sys/mman.h>     // mmap, munmap
+
+#include "Logger.hpp"
+#include "HashingUtils.hpp"
+#include "LargePages.hpp"
+
+using namespace hashing;
+
+namespace tries {
+
+    template<TTrieSize N>
+    const typename TrieSegment<N>::TRecordValue TrieSegment<N>::UNKNOWN_WORD = numeric_limits<TRecordValue>::max();
+
+    template<TTrieSize N>
+    TrieSegment<N>::TrieSegment(const string & fileName) throw (Exception)
+    : _fileName(fileName), _isRemoveFile(false), _fileBytes(0), _data(NULL) {
+        const int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw Exception("Can not open the segment file: " + fileName);
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0) {
+            _fileBytes = fileStat.st_size;
+            if (_fileBytes >= sizeof (SHeader)) {
+                _data = mmap(NULL, _fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+            }
+        }
+        close(fd);
+        if ((_data == NULL) || (_data == MAP_FAILED)) {
+            _data = NULL;
+            throw Exception("Can not map the segment file: " + fileName);
+        }
+        memory::adviseFileMapping(_data, _fileBytes);
+
+        //Find the dictionary and the levels in the mapped data
+        const char * data = static_cast<const char *> (_data);
+        _header = reinterpret_cast<const SHeader *> (data);
+        size_t pos = sizeof (SHeader);
+        const size_t numWords = _header->numNGrams[0];
+        _wordOffsets = reinterpret_cast<const uint64_t *> (data + pos);
+        pos += (numWords + 1) * sizeof (uint64_t);
+        _wordFreqs = reinterpret_cast<const TRecordValue *> (data + pos);
+        pos += numWords * sizeof (TRecordValue);
+        _text = data + pos;
+        pos += _header->textBytes;
+        pos = (pos + sizeof (TRecordValue) - 1) / sizeof (TRecordValue) * sizeof (TRecordValue);
+        _levels[0] = NULL;
+        for (TTrieSize L = 2; L <= N; L++) {
+            _levels[L - 1] = reinterpret_cast<const TRecordValue *> (data + pos);
+            pos += _header->numNGrams[L - 1] * (L + 1) * sizeof (TRecordValue);
+        }
+
+        if (strncmp(_header->magic, TRIE_SEGMENT_MAGIC, sizeof (_header->magic)) || (_header->level != N) || (pos > _fileBytes)) {
+            munmap(_data, _fileBytes);
+            _data = NULL;
+            throw Exception("The file is not a valid segment: " + fileName);
+        }
+        LOG_DEBUG << "Opened the segment '" << fileName << "' of " << _fileBytes << " bytes" << END_LOG;
+    }
+
+    template<TTrieSize N>
+    TrieSegment<N>::TrieSegment(const TrieSegment& orig) {
+    }
+
+    template<TTrieSize N>
+    TrieSegment<N>::~TrieSegment() {
+        if (_data != NULL) {
+            munmap(_data, _fileBytes);
+        }
+        if (_isRemoveFile) {
+            remove(_fileName.c_str());
+        }
+    }
+
+    template<TTrieSize N>
+    template<bool doCache>
+    void TrieSegment<N>::write(const string & fileName, const ATrie<N, doCache> & trie) throw (Exception) {
+        //Collect and sort the dictionary, the words' index is their id
+        vector< pair<string, TRecordValue> > dictionary;
+        trie.visitNGrams(1, [&dictionary] (const vector<string> & words, const SNGramData & data) {
+            dictionary.push_back(make_pair(words[0], data.freq));
+        });
+        sort(dictionary.begin(), dictionary.end());
+        vector<TWordRef> words;
+        vector<TRecordValue> freqs;
+        unordered_map<string, TRecordValue> wordIds;
+        for (size_t idx = 0; idx < dictionary.size(); idx++) {
+            words.push_back(make_pair(dictionary[idx].first.data(), dictionary[idx].first.size()));
+            freqs.push_back(dictionary[idx].second);
+            wordIds[dictionary[idx].first] = idx;
+        }
+
+        ofstream out;
+        openFile(out, fileName);
+        SHeader header = {};
+        writeDictionary(out, header, words, freqs);
+
+        //Write the levels, the records are collected and then written in the sorted order
+        vector<TRecordValue> records;
+        vector<TRecordValue> order;
+        for (TTrieSize L = 2; L <= N; L++) {
+            const size_t recordSize = L + 1;
+            records.clear();
+            trie.visitNGrams(L, [&] (const vector<string> & ngram, const SNGramData & data) {
+                if (data.freq > 0) {
+                    for (TTrieSize idx = 0; idx < L; idx++) {
+                        records.push_back(wordIds.at(ngram[idx]));
+                    }
+                    records.push_back(data.freq);
+                }
+            });
+            const size_t numRecords = records.size() / recordSize;
+            order.resize(numRecords);
+            for (size_t idx = 0; idx < numRecords; idx++) {
+                order[idx] = idx;
+            }
+            const TRecordValue * base = records.data();
+            sort(order.begin(), order.end(), [base, recordSize, L] (const TRecordValue first, const TRecordValue second) {
+                return compareIds(base + first * recordSize, base + second * recordSize, L) < 0;
+            });
+            for (size_t idx = 0; idx < numRecords; idx++) {
+                out.write(reinterpret_cast<const char *> (base + order[idx] * recordSize), recordSize * sizeof (TRecordValue));
+            }
+            header.numNGrams[L - 1] = numRecords;
+        }
+
+        closeFile(out, fileName, header);
+    }
+
+    template<TTrieSize N>
+    void TrieSegment<N>::merge(const string & fileName, const TrieSegment & first, const TrieSegment & second) throw (Exception) {
+        //Merge the sorted dictionaries, the new ids of the words are remembered
+        const size_t numFirst = first.getNumNGrams(1);
+        const size_t numSecond = second.getNumNGrams(1);
+        vector<TWordRef> words;
+        vector<TRecordValue> freqs;
+        vector<TRecordValue> firstIds(numFirst), secondIds(numSecond);
+        size_t firstIdx = 0, secondIdx = 0;
+        while ((firstIdx < numFirst) || (secondIdx < numSecond)) {
+            int cmp = (firstIdx == numFirst) ? 1 : ((secondIdx == numSecond) ? -1 : 0);
+            if (cmp == 0) {
+                cmp = compareWords(first.getWord(firstIdx), second.getWord(secondIdx));
+            }
+            if (cmp <= 0) {
+                words.push_back(first.getWord(firstIdx));
+                freqs.push_back(first._wordFreqs[firstIdx]);
+                firstIds[firstIdx++] = words.size() - 1;
+            } else {
+                words.push_back(second.getWord(secondIdx));
+                freqs.push_back(0);
+            }
+            if (cmp >= 0) {
+                freqs.back() += second._wordFreqs[secondIdx];
+                secondIds[secondIdx++] = words.size() - 1;
+            }
+        }
+
+        ofstream out;
+        openFile(out, fileName);
+        SHeader header = {};
+        writeDictionary(out, header, words, freqs);
+
+        //Merge the levels, the id mapping preserves the order of the records
+        for (TTrieSize L = 2; L <= N; L++) {
+            const size_t recordSize = L + 1;
+            const size_t numFirstRecs = first.getNumNGrams(L);
+            const size_t numSecondRecs = second.getNumNGrams(L);
+            TRecordValue firstRec[N + 1], secondRec[N + 1];
+            size_t numRecords = 0;
+            firstIdx = 0;
+            secondIdx = 0;
+            while ((firstIdx < numFirstRecs) || (secondIdx < numSecondRecs)) {
+                if (firstIdx < numFirstRecs) {
+                    const TRecordValue * record = first._levels[L - 1] + firstIdx * recordSize;
+                    for (TTrieSize idx = 0; idx < L; idx++) {
+                        firstRec[idx] = firstIds[record[idx]];
+                    }
+                    firstRec[L] = record[L];
+                }
+                if (secondIdx < numSecondRecs) {
+                    const TRecordValue * record = second._levels[L - 1] + secondIdx * recordSize;
+                    for (TTrieSize idx = 0; idx < L; idx++) {
+                        secondRec[idx] = secondIds[record[idx]];
+                    }
+                    secondRec[L] = record[L];
+                }
+                const int cmp = (firstIdx == numFirstRecs) ? 1 : ((secondIdx == numSecondRecs) ? -1 : compareIds(firstRec, secondRec, L));
+                if (cmp == 0) {
+                    firstRec[L] += secondRec[L];
+                }
+                out.write(reinterpret_cast<const char *> ((cmp <= 0) ? firstRec : secondRec), recordSize * sizeof (TRecordValue));
+                numRecords++;
+                if (cmp <= 0) {
+                    firstIdx++;
+                }
+                if (cmp >= 0) {
+                    secondIdx++;
+                }
+            }
+            header.numNGrams[L - 1] = numRecords;
+        }
+
+        closeFile(out, fileName, header);
+    }
+
+    template<TTrieSize N>
+    template<bool doCache>
+    void TrieSegment<N>::addTo(ATrie<N, doCache> & trie) const throw (Exception) {
+        //The words and their hashes, indexed by the word id
+        const size_t numWords = getNumNGrams(1);
+        vector<string> words(numWords);
+        vector<TWordHashSize> hashes(numWords);
+        for (size_t idx = 0; idx < numWords; idx++) {
+            const TWordRef word = getWord(idx);
+            words[idx].assign(word.first, word.second);
+            hashes[idx] = computeMurmur64Hash(words[idx]);
+        }
+
+        //The levels are added bottom up, so the shorter N-grams get the smaller ids
+        vector<string> ngram;
+        vector<TWordHashSize> ngramHashes;
+        for (TTrieSize L = 1; L <= N; L++) {
+            ngram.resize(L);
+            ngramHashes.resize(L);
+            for (size_t recIdx = 0; recIdx < getNumNGrams(L); recIdx++) {
+                TRecordValue freq;
+                if (L == 1) {
+                    ngram[0] = words[recIdx];
+                    ngramHashes[0] = hashes[recIdx];
+                    freq = _wordFreqs[recIdx];
+                } else {
+                    const TRecordValue * record = _levels[L - 1] + recIdx * (L + 1);
+                    for (TTrieSize idx = 0; idx < L; idx++) {
+                        ngram[idx] = words[record[idx]];
+                        ngramHashes[idx] = hashes[record[idx]];
+                    }
+                    freq = record[L];
+                }
+                trie.addNGramFreq(ngram, ngramHashes, freq);
+            }
+        }
+    }
+
+    template<TTrieSize N>
+    void TrieSegment<N>::addNGramFreqs(const vector<string> & ngram, SFrequencyResult<N> & freqs) const {
+        TRecordValue wordIds[N];
+        for (TTrieSize idx = 0; idx < N; idx++) {
+            wordIds[idx] = findWord(ngram[idx]);
+        }
+        if (wordIds[N - 1] == UNKNOWN_WORD) {
+            return;
+        }
+        freqs.result[N - 1] += _wordFreqs[wordIds[N - 1]];
+
+        //The N-grams are suffix closed, so the first missing
+        //N-gram means that the longer ones are missing too
+        for (TTrieSize L = 2; L <= N; L++) {
+            const TTrieSize startIdx = N - L;
+            if (wordIds[startIdx] == UNKNOWN_WORD) {
+                return;
+            }
+            const TRecordValue * record = findRecord(L, wordIds + startIdx);
+            if (record == NULL) {
+                return;
+            }
+            freqs.result[startIdx] += record[L];
+        }
+    }
+
+    template<TTrieSize N>
+    typename TrieSegment<N>::TRecordValue TrieSegment<N>::findWord(const string & word) const {
+        size_t low = 0, high = _header->numNGrams[0];
+        while (low < high) {
+            const size_t middle = (low + high) / 2;
+            const int cmp = compareWords(make_pair(word.data(), word.size()), getWord(middle));
+            if (cmp == 0) {
+                return middle;
+            }
+            if (cmp > 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return UNKNOWN_WORD;
+    }
+
+    template<TTrieSize N>
+    const typename TrieSegment<N>::TRecordValue * TrieSegment<N>::findRecord(const TTrieSize L, const TRecordValue * wordIds) const {
+        const size_t recordSize = L + 1;
+        size_t low = 0, high = _header->numNGrams[L - 1];
+        while (low < high) {
+            const size_t middle = (low + high) / 2;
+            const TRecordValue * record = _levels[L - 1] + middle * recordSize;
+            const int cmp = compareIds(wordIds, record, L);
+            if (cmp == 0) {
+                return record;
+            }
+            if (cmp > 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return NULL;
+    }
+
+    template<TTrieSize N>
+    void TrieSegment<N>::writeDictionary(ofstream & out, SHeader & header, const vector<TWordRef> & words,
+                                         const vector<TRecordValue> & freqs) {
+        header.numNGrams[0] = words.size();
+        header.textBytes = 0;
+
+        //The header is re-written once the level sizes are known
+        out.write(reinterpret_cast<const char *> (&header), sizeof (SHeader));
+        uint64_t offset = 0;
+        for (size_t idx = 0; idx <= words.size(); idx++) {
+            out.write(reinterpret_cast<const char *> (&offset), sizeof (offset));
+            if (idx < words.size()) {
+                offset += words[idx].second;
+            }
+        }
+        out.write(reinterpret_cast<const char *> (freqs.data()), freqs.size() * sizeof (TRecordValue));
+        for (size_t idx = 0; idx < words.size(); idx++) {
+            out.write(words[idx].first, words[idx].second);
+        }
+        header.textBytes = offset;
+
+        //Align the level records
+        const char padding[sizeof (TRecordValue)] = {};
+        out.write(padding, (sizeof (TRecordValue) - offset % sizeof (TRecordValue)) % sizeof (TRecordValue));
+    }
+
+    template<TTrieSize N>
+    void TrieSegment<N>::openFile(ofstream & out, const string & fileName) throw (Exception) {
+        const string tempName = getTempFileName(fileName);
+        out.open(tempName.c_str(), ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            throw Exception("Can not create the segment file: " + tempName);
+        }
+    }
+
+    template<TTrieSize N>
+    void TrieSegment<N>::closeFile(ofstream & out, const string & fileName, const SHeader & header) throw (Exception) {
+        SHeader written = header;
+        memcpy(written.magic, TRIE_SEGMENT_MAGIC, sizeof (written.magic));
+        written.level = N;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *> (&written), sizeof (SHeader));
+        out.close();
+        const string tempName = getTempFileName(fileName);
+        if (out.fail() || rename(tempName.c_str(), fileName.c_str())) {
+            remove(tempName.c_str());
+            throw Exception("Can not write the segment file: " + fileName);
+        }
+        LOG_DEBUG << "Written the segment '" << fileName << "' with " << header.numNGrams[0] << " words" << END_LOG;
+    }
+
+    //Make sure that there will be templates instantiated, at least for the given parameter values
+    template class TrieSegment<N_GRAM_PARAM>;
+    template void TrieSegment<N_GRAM_PARAM>::write<true>(const string & fileName, const ATrie<N_GRAM_PARAM, true> & trie) throw (Exception);
+    template void TrieSegment<N_GRAM_PARAM>::write<false>(const string & fileName, const ATrie<N_GRAM_PARAM, false> & trie) throw (Exception);
+    template void TrieSegment<N_GRAM_PARAM>::addTo<true>(ATrie<N_GRAM_PARAM, true> & trie) const throw (Exception);
+    template void TrieSegment<N_GRAM_PARAM>::addTo<false>(ATrie<N_GRAM_PARAM, false> & trie) const throw (Exception);
+}
@@ -27,16 +27,39 @@
 #include <iostream>     // std::cout
 #include <sstream>      // std::stringstream, std::stringbuf
 #include <fstream>      // std::ifstream
-#include <algorithm>    // std::transform
+#include <algorithm>    // std::transform, std::shuffle
+#include <cstring>      // std::strlen, std::memcmp
+#include <cstdlib>      // std::atoi
+#include <thread>       // std::thread
+#include <chrono>       // std::chrono::steady_clock
+#include <random>       // std::mt19937
+#include <exception>    // std::exception_ptr
+#include <cstdio>       // std::remove
+#include <unistd.h>     // getpid
+#if defined(__linux__)
+#include <malloc.h>     // malloc_trim
+#endif
 
 #include "Exceptions.hpp"
 #include "StatisticsMonitor.hpp"
 #include "Logger.hpp"
 #include "ATrie.hpp"
 #include "HashMapTrie.hpp"
+#include "ShardedTrie.hpp"
+#include "SegmentedTrie.hpp"
+#include "EliasFanoTrie.hpp"
+#include "ConcurrentTrie.hpp"
+#include "TrieSegment.hpp"
 #include "TrieBuilder.hpp"
+#include "ProcessBuilder.hpp"
 #include "Globals.hpp"
 #include "NGramBuilder.hpp"
+#include "QueryServer.hpp"
+#include "QueryLoadGenerator.hpp"
+#include "ArpaReader.hpp"
+#include "ArpaWriter.hpp"
+#include "TrieDumper.hpp"
+#include "LargePages.hpp"
 
 using namespace std;
 using namespace tries;
@@ -45,10 +68,74 @@ using namespace tries;
  * This structure is needed to store the application parameters
  */
 typedef struct {
+    //The program executable name
+    string exeName;
     //The train file name
     string trainFileName;
     //The test file name
     string testFileName;
+    //The trie type name
+    string trieType;
+    //The number of the sharded trie shards
+    size_t numShards;
+    //The directory of the segmented trie segments
+    string segmentDir;
+    //The maximum number of the segmented trie's in-memory N-grams
+    size_t segmentNGrams;
+    //The hash map trie's hash policy name
+    string hashPolicy;
+    //The hash map trie's map policy name
+    string mapPolicy;
+    //The smoothing method name, empty if the probabilities are not to be computed
+    string smoothing;
+    //The number of the most frequent continuations to give per test query, zero if none
+    size_t topK;
+    //The patterns of the stored N-grams to find, @see NGRAM_PATTERN_WILDCARD
+    vector<string> findPatterns;
+    //True if the train file is an ARPA file to load the trie from
+    bool isLoadArpa;
+    //The ARPA file name to export the trie to, empty if not to be exported
+    string saveArpaFileName;
+    //The directory to dump the trie counts and their statistics into, empty if not to be dumped
+    string dumpDirName;
+    //The trie counts file to load before the corpus is read, empty if none
+    string loadCountsFileName;
+    //The trie counts file to save, empty if none
+    string saveCountsFileName;
+    //The number of the trie counts builder processes, zero if the counts are built in this process
+    size_t numProcesses;
+    //The index of the train file range to count, in the range builder mode
+    size_t rangeIdx;
+    //The number of the train file ranges, zero if not in the range builder mode
+    size_t numRanges;
+    //The trie counts file to merge the counts files into, empty if not in the merge mode
+    string mergeCountsFileName;
+    //The trie counts files to merge
+    vector<string> countsFileNames;
+    //The query server socket path, empty if the server is not to be run
+    string serverSocket;
+    //The number of the query server worker threads
+    size_t numWorkers;
+    //The query server socket path to send the load to, empty if not in the client mode
+    string clientSocket;
+    //The number of the client connections
+    size_t numConnections;
+    //The total number of the client requests
+    size_t numRequests;
+    //The number of N-grams per client request
+    size_t batchSize;
+    //True if the batched lookups are to be benchmarked
+    bool isBenchLookups;
+    //True if the concurrent and the per-thread-then-merge builds are to be benchmarked
+    bool isBenchBuild;
+    //True if the trie is not to be compacted after it is filled in
+    bool isNoCompact;
+    //True if the hot region hit rates of the test queries are to be reported
+    bool isHotStats;
+    //The page policy of the large trie tables
+    memory::EPagePolicy pagePolicy;
+    //The NUMA placement policy of the large trie tables
+    memory::ENumaPolicy numaPolicy;
 } TAppParams;
 
 /**
@@ -78,7 +165,16 @@ static void printUsage(const string name) {
     const string shortName = name.substr(lastSlashBeforeFileName + 1);
 
     LOG_USAGE << "Running: " << END_LOG;
-    LOG_USAGE << "  " << shortName.c_str() << " <train_file> <test_file> [debug-level]" << END_LOG;
+    LOG_USAGE << "  " << shortName.c_str() << " <train_file> <test_file> [debug-level] [--trie=<type>] [--shards=<K>]" << END_LOG;
+    LOG_USAGE << "                  [--segment-dir=<dir>] [--segment-ngrams=<M>] [--hash=<policy>] [--map=<policy>]" << END_LOG;
+    LOG_USAGE << "                  [--smoothing=<method>] [--top-k=<K>] [--load-arpa] [--save-arpa=<file>]" << END_LOG;
+    LOG_USAGE << "                  [--dump=<dir>] [--load-counts=<file>] [--save-counts=<file>] [--processes=<P>]" << END_LOG;
+    LOG_USAGE << "                  [--find=<pattern>] [--serve=<socket>] [--workers=<W>] [--bench-lookups] [--bench-build]" << END_LOG;
+    LOG_USAGE << "                  [--no-compact] [--hot-stats] [--huge-pages=<policy>] [--numa=<policy>]" << END_LOG;
+    LOG_USAGE << "  " << shortName.c_str() << " --client=<socket> <test_file> [debug-level]" << END_LOG;
+    LOG_USAGE << "                  [--connections=<C>] [--requests=<R>] [--batch=<B>]" << END_LOG;
+    LOG_USAGE << "  " << shortName.c_str() << " --build-range=<k>/<K> <train_file> <counts_file> [debug-level]" << END_LOG;
+    LOG_USAGE << "  " << shortName.c_str() << " --merge-counts=<counts_file> <counts_file>... [debug-level]" << END_LOG;
     LOG_USAGE << "      <train_file> - a text file containing the training text corpus." << END_LOG;
     LOG_USAGE << "                     This corpus should be already tokenized, i.e.," << END_LOG;
     LOG_USAGE << "                     all words are already separated by white spaces," << END_LOG;
@@ -88,6 +184,67 @@ static void printUsage(const string name) {
     LOG_USAGE << "                     The test file consists of a number of 5-grams," << END_LOG;
     LOG_USAGE << "                     where each line in the file consists of one 5-gram." << END_LOG;
     LOG_USAGE << "     [debug-level] - the optional debug flag from " << DEBUG_OPTION_VALUES << END_LOG;
+    LOG_USAGE << "  [--trie=<type>]  - the optional trie type from " << TRIE_OPTION_VALUES << "," << END_LOG;
+    LOG_USAGE << "                     the default is " << HASH_MAP_TRIE_VALUE << ". The " << ELIAS_FANO_TRIE_VALUE << " trie is" << END_LOG;
+    LOG_USAGE << "                     read only and Elias-Fano compressed once compacted." << END_LOG;
+    LOG_USAGE << "  [--shards=<K>]   - the optional number of " << SHARDED_TRIE_VALUE << " trie shards," << END_LOG;
+    LOG_USAGE << "                     the shards are filled in concurrently, the default is " << DEFAULT_NUMBER_OF_SHARDS << "." << END_LOG;
+    LOG_USAGE << "  [--segment-dir=<dir>] - the optional directory of the " << SEGMENTED_TRIE_VALUE << " trie's temporary" << END_LOG;
+    LOG_USAGE << "                     segment files, the default is " << DEFAULT_SEGMENT_DIR << "." << END_LOG;
+    LOG_USAGE << "  [--segment-ngrams=<M>] - the optional maximum number of the " << SEGMENTED_TRIE_VALUE << " trie's" << END_LOG;
+    LOG_USAGE << "                     in-memory N-grams, then they are flushed into a segment file," << END_LOG;
+    LOG_USAGE << "                     the default is " << DEFAULT_SEGMENT_NGRAMS << "." << END_LOG;
+    LOG_USAGE << "  [--hash=<policy>] - the optional " << HASH_MAP_TRIE_VALUE << " trie word hash policy from" << END_LOG;
+    LOG_USAGE << "                     " << HASH_OPTION_VALUES << ", the default is " << MURMUR_HASH_VALUE << "." << END_LOG;
+    LOG_USAGE << "  [--map=<policy>] - the optional " << HASH_MAP_TRIE_VALUE << " trie map policy from" << END_LOG;
+    LOG_USAGE << "                     " << MAP_OPTION_VALUES << ", the default is " << ADAPTIVE_MAP_VALUE << "." << END_LOG;
+    LOG_USAGE << "  [--smoothing=<method>] - compute the smoothed log10 probabilities after" << END_LOG;
+    LOG_USAGE << "                     the trie is built, the method is from " << SMOOTHING_OPTION_VALUES << "," << END_LOG;
+    LOG_USAGE << "                     the probabilities are printed along with the frequencies." << END_LOG;
+    LOG_USAGE << "  [--top-k=<K>]    - build the continuation index after the trie is built and print the" << END_LOG;
+    LOG_USAGE << "                     K most frequent words following the first N-1 words of every test query." << END_LOG;
+    LOG_USAGE << "  [--load-arpa]    - the <train_file> is an ARPA file to load the probabilities from." << END_LOG;
+    LOG_USAGE << "  [--save-arpa=<file>] - export the probabilities into the given ARPA file." << END_LOG;
+    LOG_USAGE << "  [--dump=<dir>]   - dump the N-gram counts into the sorted chunk files of the existing" << END_LOG;
+    LOG_USAGE << "                     directory, with --workers threads, and print the per-level types," << END_LOG;
+    LOG_USAGE << "                     tokens and count-of-counts, they are also saved into the directory." << END_LOG;
+    LOG_USAGE << "  [--load-counts=<file>] - load the trie counts saved with --save-counts, then add" << END_LOG;
+    LOG_USAGE << "                     the counts of the <train_file> text to them, i.e. append to the trie." << END_LOG;
+    LOG_USAGE << "  [--save-counts=<file>] - save the trie counts into the given file once the" << END_LOG;
+    LOG_USAGE << "                     <train_file> text is read." << END_LOG;
+    LOG_USAGE << "  [--processes=<P>] - count the <train_file> text with P builder processes, each one" << END_LOG;
+    LOG_USAGE << "                     counts a range of the file into a counts file in the --segment-dir," << END_LOG;
+    LOG_USAGE << "                     the failed ranges are retried, then the counts are merged and loaded." << END_LOG;
+    LOG_USAGE << "  [--find=<pattern>] - after the test queries, list the stored N-grams matching the pattern," << END_LOG;
+    LOG_USAGE << "                     e.g. \"* borrowers and\" or \"mortgages had *\", where " << NGRAM_PATTERN_WILDCARD << " is any word." << END_LOG;
+    LOG_USAGE << "                     The option can be given several times." << END_LOG;
+    LOG_USAGE << "  [--serve=<socket>] - after the test queries, serve the N-gram queries" << END_LOG;
+    LOG_USAGE << "                     on the given Unix domain socket until Ctrl+C (Linux only)." << END_LOG;
+    LOG_USAGE << "  [--workers=<W>]  - the optional number of query server workers, ARPA parsing threads," << END_LOG;
+    LOG_USAGE << "                     " << CONCURRENT_TRIE_VALUE << " trie builder threads and dump threads, the default is the number of CPU cores." << END_LOG;
+    LOG_USAGE << "  [--bench-lookups] - measure the batched N-gram lookups throughput versus the" << END_LOG;
+    LOG_USAGE << "                     number of in-flight lookups, on the N-grams stored in the trie." << END_LOG;
+    LOG_USAGE << "  [--bench-build]  - measure the " << CONCURRENT_TRIE_VALUE << " trie build throughput versus the number" << END_LOG;
+    LOG_USAGE << "                     of threads, 1 to " << BENCH_BUILD_MAX_THREADS << ", against the per-thread tries merged afterwards." << END_LOG;
+    LOG_USAGE << "  [--no-compact]   - do not compact the trie into the read-only flat arrays after" << END_LOG;
+    LOG_USAGE << "                     it is filled in, keeps the build time hash maps instead." << END_LOG;
+    LOG_USAGE << "  [--hot-stats]    - report which part of the words and the N-grams found by the test" << END_LOG;
+    LOG_USAGE << "                     queries is in the levels' hot regions, i.e. the first " << HOT_REGION_BYTES / BYTES_ONE_MB << " Kb of" << END_LOG;
+    LOG_USAGE << "                     the compacted levels, with the entries of the most frequent words." << END_LOG;
+    LOG_USAGE << "  [--huge-pages=<policy>] - the optional page policy of the large trie tables and the" << END_LOG;
+    LOG_USAGE << "                     counts file mappings from " << HUGE_PAGES_OPTION_VALUES << ", the" << END_LOG;
+    LOG_USAGE << "                     default is " << REGULAR_PAGES_VALUE << ", " << EXPLICIT_PAGES_VALUE << " needs /proc/sys/vm/nr_hugepages (Linux only)." << END_LOG;
+    LOG_USAGE << "  [--numa=<policy>] - the optional NUMA placement of the large trie tables from" << END_LOG;
+    LOG_USAGE << "                     " << NUMA_OPTION_VALUES << ", the default is " << LOCAL_NUMA_VALUE << " (Linux only)." << END_LOG;
+    LOG_USAGE << "  --client=<socket> - run the load generator against the query server" << END_LOG;
+    LOG_USAGE << "                     on the given socket, using the <test_file> 5-grams." << END_LOG;
+    LOG_USAGE << "  [--connections=<C>] - the number of concurrent client connections, the default is " << DEFAULT_CLIENT_CONNECTIONS << "." << END_LOG;
+    LOG_USAGE << "  [--requests=<R>] - the total number of client requests, the default is " << DEFAULT_CLIENT_REQUESTS << "." << END_LOG;
+    LOG_USAGE << "  [--batch=<B>]    - the number of 5-grams per client request, the default is " << DEFAULT_CLIENT_BATCH_SIZE << "." << END_LOG;
+    LOG_USAGE << "  --build-range=<k>/<K> - count the k-th of the K line aligned byte ranges of the" << END_LOG;
+    LOG_USAGE << "                     <train_file> and save the counts into the <counts_file>, 1 <= k <= K." << END_LOG;
+    LOG_USAGE << "  --merge-counts=<counts_file> - merge the given counts files into the <counts_file>," << END_LOG;
+    LOG_USAGE << "                     it can be loaded with --load-counts or merged again." << END_LOG;
 
     LOG_USAGE << "Output: " << END_LOG;
     LOG_USAGE << "    The program reads in the test lines from the <test_file>. " << END_LOG;
@@ -105,6 +262,70 @@ static void printUsage(const string name) {
     LOG_USAGE << "        frequency( and ) = 6453" << END_LOG;
 }
 
+/**
+ * Allows to check if the program argument is the given option
+ * @param data the program argument
+ * @param prefix the option prefix, e.g. "--trie="
+ * @param value the output parameter for the option value
+ * @return true if the argument is the given option, otherwise false
+ */
+static bool isOption(const string & data, const char * prefix, string & value) {
+    const size_t length = strlen(prefix);
+    if (!data.compare(0, length, prefix)) {
+        value = data.substr(length);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Allows to get the positive number option value
+ * @param value the option value
+ * @param data the program argument, for reporting
+ * @return the option value
+ * @throws Exception if the value is not a positive number
+ */
+static size_t getPositiveValue(const string & value, const string & data) throw (Exception) {
+    const int number = atoi(value.c_str());
+    if (number <= 0) {
+        stringstream msg;
+        msg << "Incorrect option value: '" << data << "', expected a positive number";
+        throw Exception(msg.str());
+    }
+    return number;
+}
+
+/**
+ * Allows to get the train file range option value
+ * @param value the option value, "<k>/<K>" with 1 <= k <= K
+ * @param data the program argument, for reporting
+ * @param rangeIdx the output parameter for the range index, k - 1
+ * @param numRanges the output parameter for the number of ranges, K
+ * @throws Exception if the value is not a valid range
+ */
+static void getRangeValue(const string & value, const string & data, size_t & rangeIdx, size_t & numRanges) throw (Exception) {
+    const size_t slashPos = value.find('/');
+    const int number = atoi(value.substr(0, slashPos).c_str());
+    const int count = (slashPos == string::npos) ? 0 : atoi(value.substr(slashPos + 1).c_str());
+    if ((number <= 0) || (count < number)) {
+        stringstream msg;
+        msg << "Incorrect option value: '" << data << "', expected <k>/<K> with 1 <= k <= K";
+        throw Exception(msg.str());
+    }
+    rangeIdx = number - 1;
+    numRanges = count;
+}
+
+/**
+ * Allows to check if the program argument is a debug level
+ * @param data the program argument
+ * @return true if the argument is one of DEBUG_OPTION_VALUES
+ */
+static bool isDebugLevel(string data) {
+    transform(data.begin(), data.end(), data.begin(), ::tolower);
+    return !data.compare(INFO_PARAM_VALUE) || !data.compare(DEBUG_PARAM_VALUE);
+}
+
 /**
  * This function tries to extract the 
  * @param argc the number of program arguments
@@ -112,30 +333,180 @@ static void printUsage(const string name) {
  * @param params the structure that will be filled in with the parsed program arguments
  */
 static void extractArguments(const int argc, char const * const * const argv, TAppParams & params) {
-    if (argc < EXPECTED_NUMBER_OF_ARGUMENTS) {
+    params.trieType = HASH_MAP_TRIE_VALUE;
+    params.numShards = DEFAULT_NUMBER_OF_SHARDS;
+    params.segmentDir = DEFAULT_SEGMENT_DIR;
+    params.segmentNGrams = DEFAULT_SEGMENT_NGRAMS;
+    params.hashPolicy = MURMUR_HASH_VALUE;
+    params.mapPolicy = ADAPTIVE_MAP_VALUE;
+    params.numWorkers = max<size_t>(thread::hardware_concurrency(), 1);
+    params.numConnections = DEFAULT_CLIENT_CONNECTIONS;
+    params.numRequests = DEFAULT_CLIENT_REQUESTS;
+    params.batchSize = DEFAULT_CLIENT_BATCH_SIZE;
+    params.exeName = argv[0];
+
+    //This here is a fast hack, it is not a really the
+    //nicest way to handle the program parameters but
+    //this is ok for a test software.
+    vector<string> positional;
+    string value;
+    for (int argIdx = 1; argIdx < argc; argIdx++) {
+        const string data = argv[argIdx];
+        if (isOption(data, TRIE_OPTION_PREFIX, value)) {
+            transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.compare(HASH_MAP_TRIE_VALUE) && value.compare(SHARDED_TRIE_VALUE)
+                    && value.compare(SEGMENTED_TRIE_VALUE) && value.compare(CONCURRENT_TRIE_VALUE)
+                    && value.compare(ELIAS_FANO_TRIE_VALUE)) {
+                stringstream msg;
+                msg << "Unknown trie type: '" << value << "', expected one of " << TRIE_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+            params.trieType = value;
+        } else if (isOption(data, HASH_OPTION_PREFIX, value)) {
+            transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.compare(MURMUR_HASH_VALUE) && value.compare(DJB2_HASH_VALUE) && value.compare(PRIMES_HASH_VALUE)) {
+                stringstream msg;
+                msg << "Unknown hash policy: '" << value << "', expected one of " << HASH_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+            params.hashPolicy = value;
+        } else if (isOption(data, MAP_OPTION_PREFIX, value)) {
+            transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.compare(ADAPTIVE_MAP_VALUE) && value.compare(NODE_MAP_VALUE) && value.compare(FLAT_MAP_VALUE)) {
+                stringstream msg;
+                msg << "Unknown map policy: '" << value << "', expected one of " << MAP_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+            params.mapPolicy = value;
+        } else if (isOption(data, SMOOTHING_OPTION_PREFIX, value)) {
+            transform(value.begin(), value.end(), value.begin(), ::tolower);
+            if (value.compare(STUPID_BACKOFF_VALUE) && value.compare(KNESER_NEY_VALUE)) {
+                stringstream msg;
+                msg << "Unknown smoothing: '" << value << "', expected one of " << SMOOTHING_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+            params.smoothing = value;
+        } else if (isOption(data, TOP_K_OPTION_PREFIX, value)) {
+            params.topK = getPositiveValue(value, data);
+        } else if (isOption(data, FIND_OPTION_PREFIX, value)) {
+            params.findPatterns.push_back(value);
+        } else if (!data.compare(LOAD_ARPA_OPTION)) {
+            params.isLoadArpa = true;
+        } else if (isOption(data, SAVE_ARPA_OPTION_PREFIX, value)) {
+            params.saveArpaFileName = value;
+        } else if (isOption(data, DUMP_OPTION_PREFIX, value)) {
+            params.dumpDirName = value;
+        } else if (isOption(data, LOAD_COUNTS_OPTION_PREFIX, value)) {
+            params.loadCountsFileName = value;
+        } else if (isOption(data, SAVE_COUNTS_OPTION_PREFIX, value)) {
+            params.saveCountsFileName = value;
+        } else if (isOption(data, PROCESSES_OPTION_PREFIX, value)) {
+            params.numProcesses = getPositiveValue(value, data);
+        } else if (isOption(data, BUILD_RANGE_OPTION_PREFIX, value)) {
+            getRangeValue(value, data, params.rangeIdx, params.numRanges);
+        } else if (isOption(data, MERGE_COUNTS_OPTION_PREFIX, value)) {
+            params.mergeCountsFileName = value;
+        } else if (isOption(data, SHARDS_OPTION_PREFIX, value)) {
+            params.numShards = getPositiveValue(value, data);
+        } else if (isOption(data, SEGMENT_DIR_OPTION_PREFIX, value)) {
+            params.segmentDir = value;
+        } else if (isOption(data, SEGMENT_NGRAMS_OPTION_PREFIX, value)) {
+            params.segmentNGrams = getPositiveValue(value, data);
+        } else if (isOption(data, SERVE_OPTION_PREFIX, value)) {
+            params.serverSocket = value;
+        } else if (isOption(data, WORKERS_OPTION_PREFIX, value)) {
+            params.numWorkers = getPositiveValue(value, data);
+        } else if (isOption(data, CLIENT_OPTION_PREFIX, value)) {
+            params.clientSocket = value;
+        } else if (isOption(data, CONNECTIONS_OPTION_PREFIX, value)) {
+            params.numConnections = getPositiveValue(value, data);
+        } else if (isOption(data, REQUESTS_OPTION_PREFIX, value)) {
+            params.numRequests = getPositiveValue(value, data);
+        } else if (isOption(data, BATCH_OPTION_PREFIX, value)) {
+            params.batchSize = getPositiveValue(value, data);
+        } else if (!data.compare(BENCH_LOOKUPS_OPTION)) {
+            params.isBenchLookups = true;
+        } else if (!data.compare(BENCH_BUILD_OPTION)) {
+            params.isBenchBuild = true;
+        } else if (!data.compare(NO_COMPACT_OPTION)) {
+            params.isNoCompact = true;
+        } else if (!data.compare(HOT_STATS_OPTION)) {
+            params.isHotStats = true;
+        } else if (isOption(data, HUGE_PAGES_OPTION_PREFIX, value)) {
+            if (!value.compare(REGULAR_PAGES_VALUE)) {
+                params.pagePolicy = memory::REGULAR_PAGES;
+            } else if (!value.compare(TRANSPARENT_PAGES_VALUE)) {
+                params.pagePolicy = memory::TRANSPARENT_HUGE_PAGES;
+            } else if (!value.compare(EXPLICIT_PAGES_VALUE)) {
+                params.pagePolicy = memory::EXPLICIT_HUGE_PAGES;
+            } else {
+                stringstream msg;
+                msg << "Unknown huge pages policy: '" << value << "', expected one of " << HUGE_PAGES_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+        } else if (isOption(data, NUMA_OPTION_PREFIX, value)) {
+            if (!value.compare(LOCAL_NUMA_VALUE)) {
+                params.numaPolicy = memory::LOCAL_NUMA;
+            } else if (!value.compare(INTERLEAVE_NUMA_VALUE)) {
+                params.numaPolicy = memory::INTERLEAVE_NUMA;
+            } else {
+                stringstream msg;
+                msg << "Unknown NUMA policy: '" << value << "', expected one of " << NUMA_OPTION_VALUES;
+                throw Exception(msg.str());
+            }
+        } else {
+            positional.push_back(data);
+        }
+    }
+
+    if (params.isLoadArpa && !params.loadCountsFileName.empty()) {
+        throw Exception("The ARPA file has no counts, the counts can not be added to it!");
+    }
+    if (params.isLoadArpa && (params.numProcesses > 0)) {
+        throw Exception("The ARPA file has no text to count, it can not be built with processes!");
+    }
+
+#if !TRIE_POLICY_COMBINATIONS
+    if (params.hashPolicy.compare(MURMUR_HASH_VALUE) || params.mapPolicy.compare(ADAPTIVE_MAP_VALUE)) {
+        throw Exception("The trie policy combinations are not built in, see TRIE_POLICY_COMBINATIONS");
+    }
+#endif
+
+    //In the client mode there is no train file, in the range builder mode the second
+    //file is the counts file and in the merge mode all the files are the counts files
+    size_t numFiles = params.clientSocket.empty() ? EXPECTED_USER_NUMBER_OF_ARGUMENTS : 1;
+    if (!params.mergeCountsFileName.empty()) {
+        numFiles = max<size_t>(positional.size() - ((!positional.empty() && isDebugLevel(positional.back())) ? 1 : 0), 1);
+    }
+    if (positional.size() < numFiles) {
         stringstream msg;
-        msg << "Incorrect number of arguments, expected >= " << EXPECTED_USER_NUMBER_OF_ARGUMENTS << ", got " << (argc - 1);
+        msg << "Incorrect number of arguments, expected >= " << numFiles << ", got " << positional.size();
         throw Exception(msg.str());
+    }
+    if (!params.mergeCountsFileName.empty()) {
+        params.countsFileNames.assign(positional.begin(), positional.begin() + numFiles);
+    } else if (numFiles == 1) {
+        params.testFileName = positional[0];
+    } else if (params.numRanges > 0) {
+        params.trainFileName = positional[0];
+        params.saveCountsFileName = positional[1];
     } else {
-        params.trainFileName = argv[1];
-        params.testFileName = argv[2];
-        
-        //This here is a fast hack, it is not a really the
-        //nicest way to handle the program parameters but
-        //this is ok for a test software.
-        if( argc > EXPECTED_NUMBER_OF_ARGUMENTS ) {
-            string data = argv[3];
-            transform(data.begin(), data.end(), data.begin(), ::tolower);
-            if(!data.compare( INFO_PARAM_VALUE )) {
-                Logger::ReportingLevel() = Logger::INFO;
-                LOG_INFO << "Setting the debugging level to \'" << INFO_PARAM_VALUE << "\'" << END_LOG;
+        params.trainFileName = positional[0];
+        params.testFileName = positional[1];
+    }
+
+    if (positional.size() > numFiles) {
+        string data = positional[numFiles];
+        transform(data.begin(), data.end(), data.begin(), ::tolower);
+        if(!data.compare( INFO_PARAM_VALUE )) {
+            Logger::ReportingLevel() = Logger::INFO;
+            LOG_INFO << "Setting the debugging level to \'" << INFO_PARAM_VALUE << "\'" << END_LOG;
+        } else {
+            if(!data.compare( DEBUG_PARAM_VALUE )){
+                Logger::ReportingLevel() = Logger::DEBUG;
+                LOG_INFO << "Setting the debugging level to \'" << DEBUG_PARAM_VALUE << "\'" << END_LOG;
             } else {
-                if(!data.compare( DEBUG_PARAM_VALUE )){
-                    Logger::ReportingLevel() = Logger::DEBUG;
-                    LOG_INFO << "Setting the debugging level to \'" << DEBUG_PARAM_VALUE << "\'" << END_LOG;
-                } else {
-                    LOG_WARNING << "Ignoring an unknown value of [debug-level] parameter: '" << argv[3] << "'" << END_LOG;
-                }
+                LOG_WARNING << "Ignoring an unknown value of [debug-level] parameter: '" << positional[numFiles] << "'" << END_LOG;
             }
         }
     }
@@ -187,46 +558,226 @@ static void reportMemotyUsage(const char* action, TMemotyUsage msStart, TMemotyU
     LOG_DEBUG << "memory after: vmsize=" << msEnd.vmsize << " Kb, vmpeak="
                                << msEnd.vmpeak << " Kb, vmrss=" << msEnd.vmrss
                                << " Kb, vmhwm=" << msEnd.vmhwm << " Kb" << END_LOG;
-    LOG_RESULT << "vmsize=" << double(msEnd.vmsize - msStart.vmsize)/BYTES_ONE_MB
-                                << " Mb, vmpeak=" << double(msEnd.vmpeak - msStart.vmpeak)/BYTES_ONE_MB
-                                << " Mb, vmrss=" << double(msEnd.vmrss - msStart.vmrss)/BYTES_ONE_MB
-                                << " Mb, vmhwm=" << double(msEnd.vmhwm - msStart.vmhwm)/BYTES_ONE_MB << " Mb" << END_LOG;
+    LOG_RESULT << "vmsize=" << (double(msEnd.vmsize) - double(msStart.vmsize))/BYTES_ONE_MB
+                                << " Mb, vmpeak=" << (double(msEnd.vmpeak) - double(msStart.vmpeak))/BYTES_ONE_MB
+                                << " Mb, vmrss=" << (double(msEnd.vmrss) - double(msStart.vmrss))/BYTES_ONE_MB
+                                << " Mb, vmhwm=" << (double(msEnd.vmhwm) - double(msStart.vmhwm))/BYTES_ONE_MB << " Mb" << END_LOG;
     LOG_INFO << "  vmsize - Virtual memory size; vmpeak - Peak virtual memory size" << END_LOG;
     LOG_INFO << "    Virtual memory size is how much virtual memory the process has in total (RAM+SWAP)" << END_LOG;
     LOG_INFO << "  vmrss  - Resident set size; vmhwm  - Peak resident set size" << END_LOG;
     LOG_INFO << "    Resident set size is how much memory this process currently has in main memory (RAM)" << END_LOG;
 }
 
+/**
+ * This function reports the memory used by the trie's data structures per N-gram level
+ * @param trie the trie to report on
+ */
+template<TTrieSize N, bool doCache>
+static void reportTrieMemoryUsage(const ATrie<N,doCache> & trie) {
+    SMemoryStatistics<N> stats;
+    trie.getMemoryStatistics(stats);
+
+    LOG_RESULT << "The trie memory usage per N-gram level:" << END_LOG;
+    for (TTrieSize idx = 0; idx < N; idx++) {
+        const SMemoryUsage & level = stats.levels[idx];
+        LOG_RESULT << (idx + 1) << "-grams: count=" << level.numNGrams
+                   << ", entries=" << double(level.entries) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, buckets=" << double(level.buckets) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, nodes=" << double(level.nodes) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, strings=" << double(level.strings) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, caches=" << double(level.caches) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, total=" << double(level.getTotal()) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb, bytes/N-gram=" << (level.numNGrams ? double(level.getTotal()) / level.numNGrams : 0.0) << END_LOG;
+        if (level.numReplicas > 0) {
+            //The replicas share the level's bytes with the N-grams, estimate their part
+            const double replicasBytes = double(level.getTotal()) * level.numReplicas / (level.numNGrams + level.numReplicas);
+            LOG_RESULT << (idx + 1) << "-grams: replicas=" << level.numReplicas << ", overhead~="
+                       << replicasBytes / BYTES_ONE_MB / BYTES_ONE_MB << " Mb" << END_LOG;
+        }
+    }
+    LOG_RESULT << "total=" << double(stats.getTotal()) / BYTES_ONE_MB / BYTES_ONE_MB << " Mb" << END_LOG;
+    const size_t hugePagesBytes = memory::getHugePagesBytes();
+    if (hugePagesBytes > 0) {
+        LOG_RESULT << "The huge pages back " << double(hugePagesBytes) / BYTES_ONE_MB / BYTES_ONE_MB
+                   << " Mb of the process memory" << END_LOG;
+    }
+    LOG_INFO << "  entries - the entry arrays and the hash map key/value pairs" << END_LOG;
+    LOG_INFO << "  buckets - the hash map bucket arrays; nodes - the hash map node and heap block overhead" << END_LOG;
+    LOG_INFO << "  strings - the heap allocated words; caches - the query caches" << END_LOG;
+    LOG_INFO << "  replicas - the stored entries that are not N-grams, e.g. the prefixes replicated in the shards" << END_LOG;
+}
+
+/**
+ * This method is used to report the hit rates of the trie's hot regions
+ * @param trie the trie, its found entries are counted, @see ATrie::setHotRegionCounting
+ */
+template<TTrieSize N, bool doCache>
+static void reportHotRegionUsage(const ATrie<N,doCache> & trie) {
+    SHotRegionStatistics<N> stats;
+    trie.getHotRegionStatistics(stats);
+
+    LOG_RESULT << "The hot region hit rates per N-gram level:" << END_LOG;
+    for (TTrieSize idx = 0; idx < N; idx++) {
+        const SHotRegionUsage & level = stats.levels[idx];
+        LOG_RESULT << (idx + 1) << "-grams: hot region=" << double(level.hotBytes) / BYTES_ONE_MB
+                   << " Kb, found=" << level.numProbes << ", hot=" << level.numHotProbes
+                   << ", hit rate=" << (level.numProbes ? 100.0 * level.numHotProbes / level.numProbes : 0.0)
+                   << "%" << END_LOG;
+    }
+}
+
 /**
  * THis method is used to read from the corpus and initialize the Trie
  * @param fstr the file to read data from
- * @param trie the trie to put the data into
+ * @param trie the trie to put the data into, of its concrete type so that the build is devirtualized
  */
-template<TTrieSize N, bool doCache>
-static void fillInTrie(ifstream & fstr, ATrie<N,doCache> & trie) {
+template<TTrieSize N, bool doCache, typename TTrie>
+static void fillInTrie(ifstream & fstr, TTrie & trie) {
     //A trie container and the corps file stream are already instantiated and are given
 
     //A.1. Create the TrieBuilder and give the trie to it
-    TrieBuilder<N,doCache> builder(trie, fstr, TOKEN_DELIMITER_CHAR);
+    TrieBuilder<N,doCache,TTrie> builder(trie, fstr, TOKEN_DELIMITER_CHAR);
 
     //A.2. Build the trie
     builder.build();
 }
 
+/**
+ * This method is used to read the ARPA file and fill in the trie
+ * @param fstr the ARPA file to read data from
+ * @param trie the trie to put the data into
+ * @param numThreads the number of the parsing threads
+ */
+template<TTrieSize N, bool doCache>
+static void loadArpa(ifstream & fstr, ATrie<N,doCache> & trie, const size_t numThreads) {
+    arpa::ArpaReader<N,doCache> reader(trie, fstr, numThreads);
+    reader.read();
+}
+
+/**
+ * This method is used to export the trie into the ARPA file
+ * @param fileName the ARPA file name
+ * @param trie the trie with the probabilities
+ */
+template<TTrieSize N, bool doCache>
+static void saveArpa(const string & fileName, ATrie<N,doCache> & trie) {
+    ofstream fstr(fileName.c_str());
+    if (!fstr.is_open()) {
+        throw Exception("Can not create the ARPA file: " + fileName);
+    }
+    arpa::ArpaWriter<N,doCache> writer(trie, fstr);
+    writer.write();
+}
+
+/**
+ * This method is used to dump the trie counts and to report their statistics
+ * @param dirName the directory to dump into, @see TrieDumper
+ * @param trie the trie to dump
+ * @param numThreads the number of the dumper threads
+ */
+template<TTrieSize N, bool doCache>
+static void dumpCounts(const string & dirName, const ATrie<N,doCache> & trie, const size_t numThreads) {
+    TrieDumper<N,doCache> dumper(trie, dirName, numThreads);
+    dumper.dump();
+    for (TTrieSize L = 1; L <= N; L++) {
+        const SLevelCountStats & stats = dumper.getStatistics(L);
+        stringstream counts;
+        for (size_t idx = 0; idx < DUMP_COUNT_OF_COUNTS; idx++) {
+            counts << " n" << (idx + 1) << "=" << stats.countOfCounts[idx];
+        }
+        counts << " n>" << DUMP_COUNT_OF_COUNTS << "=" << stats.countOfCounts[DUMP_COUNT_OF_COUNTS];
+        LOG_RESULT << L << "-grams: types=" << stats.types << " tokens=" << stats.tokens << counts.str() << END_LOG;
+    }
+}
+
+/**
+ * This method is used to load the saved trie counts into the trie
+ * @param fileName the trie counts file, @see TrieSegment
+ * @param trie the trie to add the counts to
+ */
+template<TTrieSize N, bool doCache>
+static void loadCounts(const string & fileName, ATrie<N,doCache> & trie) {
+    TrieSegment<N> segment(fileName);
+    segment.addTo(trie);
+    trie.resetQueryCache();
+}
+
+/**
+ * This method is used to load the saved trie counts into the segmented
+ * trie, the counts file is just used as one of its segments
+ * @param fileName the trie counts file, @see TrieSegment
+ * @param trie the trie to add the counts to
+ */
+template<TTrieSize N, bool doCache>
+static void loadCounts(const string & fileName, SegmentedTrie<N,doCache> & trie) {
+    trie.attachSegment(fileName);
+}
+
+/**
+ * This method is used to save the trie counts
+ * @param fileName the trie counts file, @see TrieSegment
+ * @param trie the trie supporting the N-gram iteration
+ */
+template<TTrieSize N, bool doCache>
+static void saveCounts(const string & fileName, ATrie<N,doCache> & trie) {
+    TrieSegment<N>::write(fileName, trie);
+}
+
+/**
+ * This method is used to save the segmented trie counts, the segments are merged into the file
+ * @param fileName the trie counts file, @see TrieSegment
+ * @param trie the trie to save
+ */
+template<TTrieSize N, bool doCache>
+static void saveCounts(const string & fileName, SegmentedTrie<N,doCache> & trie) {
+    trie.save(fileName);
+}
+
+/**
+ * This method is used to count the text corpus with the builder processes, @see ProcessBuilder,
+ * the merged counts are loaded into the trie and the counts file is removed then
+ * @param params the application parameters
+ * @param trie the trie to add the counts to
+ */
+template<TTrieSize N, bool doCache, typename TTrie>
+static void countWithProcesses(const TAppParams & params, TTrie & trie) {
+    stringstream countsFileName;
+    countsFileName << params.segmentDir << "/counts-" << getpid() << ".bin";
+
+    LOG_INFO << "Counting the text corpus with " << params.numProcesses << " builder processes ..." << END_LOG;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ProcessBuilder<N> builder(params.exeName, params.trainFileName, params.segmentDir, params.numProcesses);
+    builder.build(countsFileName.str());
+    const chrono::duration<double> buildTime = chrono::steady_clock::now() - start;
+    LOG_INFO << "Counting with the builder processes is done, it took " << buildTime.count() << " seconds" << END_LOG;
+
+    try {
+        loadCounts<N,doCache>(countsFileName.str(), trie);
+    } catch (Exception &) {
+        remove(countsFileName.str().c_str());
+        throw;
+    }
+    //The segmented trie keeps the file mapped, so it stays available until then
+    remove(countsFileName.str().c_str());
+}
+
 /**
  * Allows to read and execute test queries from the given file on the given trie.
- * @param trie the given trie, filled in with some data
+ * @param trie the given trie, filled in with some data, of its concrete type so that the queries are devirtualized
  * @param testFile the file containing the N-Gram (5-Gram queries)
+ * @param topK the number of the most frequent continuations of the first N-1 query words to give, zero if none
  * @return the CPU seconds used to run the queries, without time needed to read the test file
  */
-template<TTrieSize N, bool doCache>
-static double readAndExecuteQueries( ATrie<N,doCache> & trie, ifstream &testFile) {
+template<TTrieSize N, bool doCache, typename TTrie>
+static double readAndExecuteQueries( TTrie & trie, ifstream &testFile, const size_t topK) {
     //Declare time variables for CPU times in seconds
     double totalTime, startTime, endTime;
     //Will store the read line (word1 word2 word3 word4 word5)
     string line;
     //Will store the N-gram [word1 word2 word3 word4 word5] corresponding to the line
     vector<string> ngram;
+    //Will store the N-gram word hashes
+    vector<TWordHashSize> hashes;
     //Will store the N-gram frequencies for N-gram:
     //freqs[0] = frequency( [word1 word2 word3 word4 word5] )
     //freqs[1] = frequency( [word2 word3 word4 word5] )
@@ -234,18 +785,34 @@ static double readAndExecuteQueries( ATrie<N,doCache> & trie, ifstream &testFile
     //freqs[3] = frequency( [word4 word5] )
     //freqs[4] = frequency( [word5] )
     SFrequencyResult<N> freqs;
+    //Will store the N-gram log10 probabilities, if they are computed:
+    //probs[0] = log10 P( word5 | word1 word2 word3 word4 ) etc.
+    SProbabilityResult<N> probs;
+    const bool doProbs = trie.hasProbs();
+    //Will store the context [word1 word2 word3 word4] and its most frequent continuations
+    vector<string> context;
+    vector<TWordHashSize> contextHashes;
+    vector<TContinuation> continuations;
         
     //Read the test file line by line
     while( getline(testFile, line) )
     {
         //First get the complete N-gram
-        ngrams::NGramBuilder<N,doCache>::buildNGram(line, N, TOKEN_DELIMITER_CHAR, ngram);
+        ngrams::NGramBuilder<N,doCache>::buildNGram(line, N, TOKEN_DELIMITER_CHAR, ngram, hashes);
         
         LOG_DEBUG <<  line << ":" << END_LOG;
         
         //Second qury the Trie for the results
         startTime = StatisticsMonitor::getCPUTime();
-        trie.queryNGramFreqs( ngram, freqs );
+        trie.queryNGramFreqs( ngram, hashes, freqs );
+        if (doProbs) {
+            trie.queryNGramProbs( ngram, hashes, probs );
+        }
+        if (topK > 0) {
+            context.assign(ngram.begin(), ngram.end() - 1);
+            contextHashes.assign(hashes.begin(), hashes.end() - 1);
+            trie.topContinuations( context, contextHashes, topK, continuations );
+        }
         endTime = StatisticsMonitor::getCPUTime();
         
         //Print the results:
@@ -257,6 +824,26 @@ static double readAndExecuteQueries( ATrie<N,doCache> & trie, ifstream &testFile
             idx = line.find_first_of(TOKEN_DELIMITER_CHAR);
             line = line.substr(idx+1);
         }
+        if (doProbs) {
+            for(int i=0;i<N;i++){
+                stringstream context;
+                for(int j=i;j<(N-1);j++){
+                    context << " " << ngram[j];
+                }
+                LOG_RESULT << "log10prob( " << ngram[N-1] << " |" << context.str() << " ) = " << probs.result[i] << END_LOG;
+            }
+        }
+        if (topK > 0) {
+            stringstream words;
+            for (auto it = context.begin(); it != context.end(); ++it) {
+                words << " " << *it;
+            }
+            words << " ) =";
+            for (auto it = continuations.begin(); it != continuations.end(); ++it) {
+                words << ((it == continuations.begin()) ? " " : ", ") << it->first << " (" << it->second << ")";
+            }
+            LOG_RESULT << "continuations(" << words.str() << END_LOG;
+        }
         LOG_RESULT << "CPU Time needed: " << (endTime - startTime) << " sec." << END_LOG;
 
         //update total time
@@ -266,14 +853,317 @@ static double readAndExecuteQueries( ATrie<N,doCache> & trie, ifstream &testFile
     return totalTime;
 }
 
+/**
+ * Lists the stored N-grams matching the given pattern, they are found one at a
+ * time by the trie's cursor. The continuation index is built if needed, as it
+ * speeds up the patterns with the known first word.
+ * @param trie the trie to find the N-grams in
+ * @param patternLine the pattern, the words are separated by spaces
+ */
+template<TTrieSize N, bool doCache>
+static void findNGrams(ATrie<N,doCache> & trie, const string & patternLine) {
+    vector<string> pattern;
+    vector<TWordHashSize> hashes;
+    ngrams::TextTokenizer::tokenize(patternLine, TOKEN_DELIMITER_CHAR, pattern, hashes);
+    if (!trie.hasContinuations()) {
+        trie.buildContinuations();
+    }
+
+    LOG_RESULT << "Finding the N-grams matching '" << patternLine << "' ..." << END_LOG;
+    const unique_ptr<ANGramCursor> cursor = trie.findNGrams(pattern, hashes);
+    vector<string> words;
+    TFrequencySize freq;
+    size_t count = 0;
+    while (cursor->next(words, freq)) {
+        stringstream ngram;
+        for (auto it = words.begin(); it != words.end(); ++it) {
+            ngram << " " << *it;
+        }
+        LOG_RESULT << "match(" << ngram.str() << " ) = " << freq << END_LOG;
+        count++;
+    }
+    LOG_RESULT << "Found " << count << " matching N-grams" << END_LOG;
+}
+
+/**
+ * Collects the N-grams for the lookup benchmark, the stored N-grams are
+ * sampled evenly and shuffled so that the lookups touch the whole trie.
+ * If the trie does not support the N-gram iteration the test N-grams are used.
+ * @param trie the trie to collect the N-grams from
+ * @param testFileName the test file name
+ * @param words the N-grams' words, N words per N-gram
+ * @param hashes the N-grams' word hashes
+ */
+template<TTrieSize N, bool doCache>
+static void collectBenchNGrams(const ATrie<N,doCache> & trie, const string & testFileName,
+                               vector<string> & words, vector<TWordHashSize> & hashes) {
+    try {
+        const size_t step = trie.getNumNGrams(N) / BENCH_LOOKUPS_MAX_NGRAMS + 1;
+        size_t count = 0;
+        vector< vector<string> > ngrams;
+        trie.visitNGrams(N, [&] (const vector<string> & ngram, const SNGramData & data) {
+            if ((count++ % step) == 0) {
+                ngrams.push_back(ngram);
+            }
+        });
+        shuffle(ngrams.begin(), ngrams.end(), mt19937(N));
+        for (auto it = ngrams.begin(); it != ngrams.end(); ++it) {
+            words.insert(words.end(), it->begin(), it->end());
+        }
+    } catch (Exception & ex) {
+        LOG_WARNING << ex.getMessage() << " Using the test N-grams instead." << END_LOG;
+        ifstream testFile(testFileName.c_str());
+        string line;
+        vector<string> ngram;
+        vector<TWordHashSize> ngramHashes;
+        while (getline(testFile, line)) {
+            ngrams::NGramBuilder<N,doCache>::buildNGram(line, N, TOKEN_DELIMITER_CHAR, ngram, ngramHashes);
+            words.insert(words.end(), ngram.begin(), ngram.end());
+        }
+    }
+    hashes.resize(words.size());
+    for (size_t idx = 0; idx < words.size(); idx++) {
+        hashes[idx] = computeMurmur64Hash(words[idx]);
+    }
+}
+
+/**
+ * Measures the throughput of the batched N-gram lookups versus the number of
+ * the in-flight lookups. The results are checked against the ones of the
+ * N-gram by N-gram lookups, these are measured too, as the baseline.
+ * @param trie the filled in trie
+ * @param testFileName the test file name
+ */
+template<TTrieSize N, bool doCache>
+static void benchmarkLookups(ATrie<N,doCache> & trie, const string & testFileName) throw (Exception) {
+    vector<string> words;
+    vector<TWordHashSize> hashes;
+    collectBenchNGrams(trie, testFileName, words, hashes);
+    const size_t count = words.size() / N;
+    if (count == 0) {
+        throw Exception("There are no N-grams to benchmark the lookups with!");
+    }
+    const size_t numRounds = BENCH_LOOKUPS_MIN_QUERIES / count + 1;
+    LOG_RESULT << "Benchmarking the lookups of " << count << " N-grams, " << numRounds << " rounds ..." << END_LOG;
+
+    //The baseline, the N-grams are looked up one by one
+    vector< SFrequencyResult<N> > expected(count), actual;
+    vector<string> ngram(N);
+    vector<TWordHashSize> ngramHashes(N);
+    auto startTime = chrono::steady_clock::now();
+    for (size_t round = 0; round < numRounds; round++) {
+        for (size_t idx = 0; idx < count; idx++) {
+            copy(words.begin() + idx * N, words.begin() + (idx + 1) * N, ngram.begin());
+            copy(hashes.begin() + idx * N, hashes.begin() + (idx + 1) * N, ngramHashes.begin());
+            trie.queryNGramFreqs(ngram, ngramHashes, expected[idx]);
+        }
+    }
+    chrono::duration<double> seconds = chrono::steady_clock::now() - startTime;
+    LOG_RESULT << "sequential: " << (count * numRounds) / seconds.count() << " lookups/sec" << END_LOG;
+
+    //The batched lookups with the increasing number of in-flight lookups
+    for (size_t numInFlight = 1; numInFlight <= BENCH_LOOKUPS_MAX_IN_FLIGHT; numInFlight *= 2) {
+        startTime = chrono::steady_clock::now();
+        for (size_t round = 0; round < numRounds; round++) {
+            trie.queryNGramFreqsBatch(words, hashes, actual, numInFlight);
+        }
+        seconds = chrono::steady_clock::now() - startTime;
+        if (memcmp(expected.data(), actual.data(), count * sizeof (SFrequencyResult<N>))) {
+            stringstream msg;
+            msg << "The batched lookups with " << numInFlight << " in-flight lookups give wrong frequencies!";
+            throw Exception(msg.str());
+        }
+        LOG_RESULT << "in-flight=" << numInFlight << ": " << (count * numRounds) / seconds.count() << " lookups/sec" << END_LOG;
+    }
+}
+
+/**
+ * Adds the counts of all the N-grams of the source trie to the target trie
+ * @param target the trie to add the counts to
+ * @param source the trie to take the counts from
+ */
+template<TTrieSize N, bool doCache>
+static void mergeCounts(ATrie<N,doCache> & target, const ATrie<N,doCache> & source) {
+    vector<TWordHashSize> hashes;
+    for (TTrieSize L = 1; L <= N; L++) {
+        source.visitNGrams(L, [&] (const vector<string> & ngram, const SNGramData & data) {
+            if (data.freq > 0) {
+                hashes.resize(ngram.size());
+                for (size_t idx = 0; idx < ngram.size(); idx++) {
+                    hashes[idx] = computeMurmur64Hash(ngram[idx]);
+                }
+                target.addNGramFreq(ngram, hashes, data.freq);
+            }
+        });
+    }
+}
+
+/**
+ * Builds the trie the per-thread-then-merge way: every thread fills in its own
+ * hash map trie with every k'th line of every batch, then the tries are merged
+ * pairwise, by several threads at once, until all the counts are in the first one.
+ * @param trainFileName the text corpus file name
+ * @param tries the empty tries, one per thread, the first one gets all the counts
+ * @return the wall-clock seconds of the merge
+ */
+template<TTrieSize N>
+static double buildAndMerge(const string & trainFileName, vector< HashMapTrie<N,false> * > & tries) throw (Exception) {
+    typedef HashMapTrie<N,false> TTrie;
+    const size_t numThreads = tries.size();
+    vector<exception_ptr> errors(numThreads);
+
+    //Fill in the tries, every thread its own one
+    ifstream trainFile(trainFileName.c_str());
+    vector<string> lines;
+    string line;
+    while (trainFile) {
+        lines.clear();
+        while ((lines.size() < CONCURRENT_BUILD_BATCH_LINES) && getline(trainFile, line)) {
+            lines.push_back(line);
+        }
+        vector<thread> workers;
+        for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+            workers.push_back(thread([&, thIdx]() {
+                try {
+                    ngrams::NGramBuilder<N,false,TTrie> ngBuilder(*tries[thIdx], TOKEN_DELIMITER_CHAR);
+                    for (size_t lineIdx = thIdx; lineIdx < lines.size(); lineIdx += numThreads) {
+                        ngBuilder.processString(lines[lineIdx]);
+                    }
+                } catch (...) {
+                    errors[thIdx] = current_exception();
+                }
+            }));
+        }
+        for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+            workers[thIdx].join();
+        }
+        for (size_t thIdx = 0; thIdx < numThreads; thIdx++) {
+            if (errors[thIdx]) {
+                rethrow_exception(errors[thIdx]);
+            }
+        }
+    }
+
+    //Merge the tries pairwise, the number of tries to merge halves every round
+    const auto startTime = chrono::steady_clock::now();
+    for (size_t step = 1; step < numThreads; step *= 2) {
+        vector<thread> workers;
+        for (size_t idx = 0; (idx + step) < numThreads; idx += 2 * step) {
+            workers.push_back(thread([&, idx, step]() {
+                try {
+                    mergeCounts<N,false>(*tries[idx], *tries[idx + step]);
+                } catch (...) {
+                    errors[idx] = current_exception();
+                }
+            }));
+        }
+        for (size_t thIdx = 0; thIdx < workers.size(); thIdx++) {
+            workers[thIdx].join();
+        }
+        for (size_t idx = 0; idx < numThreads; idx++) {
+            if (errors[idx]) {
+                rethrow_exception(errors[idx]);
+            }
+        }
+    }
+    const chrono::duration<double> seconds = chrono::steady_clock::now() - startTime;
+    return seconds.count();
+}
+
+/**
+ * Checks that the two tries store the same N-grams, by the numbers of the
+ * N-grams and the sums of their frequencies per level
+ * @param first the first trie
+ * @param second the second trie
+ * @throws Exception in case the tries differ
+ */
+template<TTrieSize N, bool doCache>
+static void checkSameCounts(const ATrie<N,doCache> & first, const ATrie<N,doCache> & second) throw (Exception) {
+    for (TTrieSize L = 1; L <= N; L++) {
+        size_t sums[2] = {0, 0};
+        first.visitNGrams(L, [&sums] (const vector<string> & ngram, const SNGramData & data) {
+            sums[0] += data.freq;
+        });
+        second.visitNGrams(L, [&sums] (const vector<string> & ngram, const SNGramData & data) {
+            sums[1] += data.freq;
+        });
+        if ((first.getNumNGrams(L) != second.getNumNGrams(L)) || (sums[0] != sums[1])) {
+            stringstream msg;
+            msg << "The built tries differ on the level " << L << ": " << first.getNumNGrams(L) << " vs. "
+                << second.getNumNGrams(L) << " N-grams with the total frequency " << sums[0] << " vs. " << sums[1];
+            throw Exception(msg.str());
+        }
+    }
+}
+
+/**
+ * Measures the build throughput of the concurrent trie versus the number of
+ * threads, against the per-thread hash map tries merged afterwards. The
+ * time is the wall-clock one and the merged tries are checked to be the same.
+ * @param trainFileName the text corpus file name
+ */
+template<TTrieSize N>
+static void benchmarkBuild(const string & trainFileName) throw (Exception) {
+    ifstream trainFile(trainFileName.c_str());
+    const double megaBytes = Logger::getRemainingBytes(trainFile) / (1024.0 * 1024.0);
+    trainFile.close();
+    LOG_RESULT << "Benchmarking the trie builds of " << megaBytes << " Mb of text ..." << END_LOG;
+
+    for (size_t numThreads = 1; numThreads <= BENCH_BUILD_MAX_THREADS; numThreads *= 2) {
+        //The concurrent trie, filled in by all threads at once
+        ConcurrentTrie<N,false> concurrent(numThreads);
+        trainFile.open(trainFileName.c_str());
+        auto startTime = chrono::steady_clock::now();
+        TrieBuilder<N,false,ConcurrentTrie<N,false> >(concurrent, trainFile, TOKEN_DELIMITER_CHAR).build();
+        const chrono::duration<double> concurrentSeconds = chrono::steady_clock::now() - startTime;
+        trainFile.close();
+
+        //The per-thread tries, merged afterwards
+        vector< HashMapTrie<N,false> * > tries;
+        for (size_t idx = 0; idx < numThreads; idx++) {
+            tries.push_back(new HashMapTrie<N,false>());
+        }
+        startTime = chrono::steady_clock::now();
+        double mergeSeconds = 0.0;
+        chrono::duration<double> mergedSeconds;
+        try {
+            mergeSeconds = buildAndMerge<N>(trainFileName, tries);
+            mergedSeconds = chrono::steady_clock::now() - startTime;
+            checkSameCounts<N,false>(concurrent, *tries[0]);
+        } catch (...) {
+            for (size_t idx = 0; idx < numThreads; idx++) {
+                delete tries[idx];
+            }
+            throw;
+        }
+        for (size_t idx = 0; idx < numThreads; idx++) {
+            delete tries[idx];
+        }
+
+        LOG_RESULT << "threads=" << numThreads << ": concurrent " << concurrentSeconds.count() << " sec, "
+                   << (megaBytes / concurrentSeconds.count()) << " Mb/sec; per-thread+merge "
+                   << mergedSeconds.count() << " sec (merge " << mergeSeconds << " sec), "
+                   << (megaBytes / mergedSeconds.count()) << " Mb/sec" << END_LOG;
+    }
+}
+
 /**
  * This method will perform the main tasks of this application:
- * Read the text corpus and create a trie and then read the test
+ * Read the text corpus and fill in the trie and then read the test
  * file and query the trie for frequencies.
+ * If requested, serve the queries with the query server afterwards.
+ * The corpus reading and the test queries work on the concrete trie type,
+ * the other tasks on the abstract trie interface.
+ * @param params the application parameters
+ * @param trie the empty trie to work with
  * @param trainFile the text corpus file
  * @param testFile the test file with queries
  */
-static void performTasks(ifstream &trainFile, ifstream &testFile) {
+template<TTrieSize N, bool doCache, typename TTrie>
+static void performTasks(const TAppParams & params, TTrie & trie, ifstream &trainFile, ifstream &testFile) {
+    //The abstract trie interface for the tasks that are not performance critical
+    ATrie<N,doCache> & baseTrie = trie;
+
     //Declare time variables for CPU times in seconds
     double startTime, endTime;
 
@@ -282,11 +1172,23 @@ static void performTasks(ifstream &trainFile, ifstream &testFile) {
     TMemotyUsage memStatStart = {}, memStatInterm = {};
     StatisticsMonitor::getMemoryStatistics(memStatStart);
 
-    //Create a trie and pass it to the algorithm method
-    TFiveCacheHashMapTrie trie;
+    if (!params.loadCountsFileName.empty()) {
+        LOG_RESULT << "Loading the Trie counts from '" << params.loadCountsFileName << "' ..." << END_LOG;
+        startTime = StatisticsMonitor::getCPUTime();
+        loadCounts<N,doCache>(params.loadCountsFileName, trie);
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Loading the Trie counts is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+    }
+
     LOG_RESULT << "Start reading the text corpus and filling in the Trie ..." << END_LOG;
     startTime = StatisticsMonitor::getCPUTime();
-    fillInTrie(trainFile, trie);
+    if (params.numProcesses > 0) {
+        countWithProcesses<N,doCache>(params, trie);
+    } else if (params.isLoadArpa) {
+        loadArpa(trainFile, baseTrie, params.numWorkers);
+    } else {
+        fillInTrie<N,doCache>(trainFile, trie);
+    }
     endTime = StatisticsMonitor::getCPUTime();
     LOG_RESULT << "Reading the text corpus is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
 
@@ -296,13 +1198,123 @@ static void performTasks(ifstream &trainFile, ifstream &testFile) {
     LOG_DEBUG << "Reporting on the memory consumption" << END_LOG;
     reportMemotyUsage("Loading of the text corpus Trie", memStatStart, memStatInterm);
 
+    if (!params.isNoCompact) {
+        LOG_RESULT << "Compacting the Trie ..." << END_LOG;
+        TMemotyUsage memStatCompact = {};
+        startTime = StatisticsMonitor::getCPUTime();
+        trie.compact();
+#if defined(__GLIBC__)
+        //Give the released build time maps' memory back to the system
+        malloc_trim(0);
+#endif
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Compacting the Trie is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+        StatisticsMonitor::getMemoryStatistics(memStatCompact);
+        reportMemotyUsage("Compacting of the text corpus Trie", memStatInterm, memStatCompact);
+    }
+
+    if (!params.smoothing.empty()) {
+        LOG_RESULT << "Computing the " << params.smoothing << " probabilities ..." << END_LOG;
+        startTime = StatisticsMonitor::getCPUTime();
+        trie.computeProbs(params.smoothing.compare(KNESER_NEY_VALUE) ? STUPID_BACKOFF_SMOOTHING : KNESER_NEY_SMOOTHING);
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Computing the probabilities is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+    }
+
+    if (params.topK > 0) {
+        LOG_RESULT << "Building the continuation index ..." << END_LOG;
+        startTime = StatisticsMonitor::getCPUTime();
+        trie.buildContinuations();
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Building the continuation index is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+    }
+
+    if (!params.saveCountsFileName.empty()) {
+        LOG_RESULT << "Saving the Trie counts into '" << params.saveCountsFileName << "' ..." << END_LOG;
+        startTime = StatisticsMonitor::getCPUTime();
+        saveCounts<N,doCache>(params.saveCountsFileName, trie);
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Saving the Trie counts is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+    }
+
+    if (!params.saveArpaFileName.empty()) {
+        LOG_RESULT << "Writing the ARPA file '" << params.saveArpaFileName << "' ..." << END_LOG;
+        startTime = StatisticsMonitor::getCPUTime();
+        saveArpa(params.saveArpaFileName, baseTrie);
+        endTime = StatisticsMonitor::getCPUTime();
+        LOG_RESULT << "Writing the ARPA file is done, it took " << (endTime - startTime) << " CPU seconds." << END_LOG;
+    }
+
+    if (!params.dumpDirName.empty()) {
+        LOG_RESULT << "Dumping the Trie counts into '" << params.dumpDirName << "' ..." << END_LOG;
+        const auto startWall = chrono::steady_clock::now();
+        dumpCounts(params.dumpDirName, baseTrie, params.numWorkers);
+        const chrono::duration<double> seconds = chrono::steady_clock::now() - startWall;
+        LOG_RESULT << "Dumping the Trie counts is done, it took " << seconds.count() << " seconds." << END_LOG;
+    }
+
+    reportTrieMemoryUsage(baseTrie);
+
+    if (params.isHotStats) {
+        baseTrie.setHotRegionCounting(true);
+    }
+
     LOG_RESULT << "Reading and executing the test queries ..." << END_LOG;
-    const double queryCPUTimes = readAndExecuteQueries(trie, testFile);
+    const double queryCPUTimes = readAndExecuteQueries<N,doCache>(trie, testFile, params.topK);
     LOG_RESULT << "Total query execution time is " << queryCPUTimes << " CPU seconds." << END_LOG;
+
+    if (params.isHotStats) {
+        baseTrie.setHotRegionCounting(false);
+        reportHotRegionUsage(baseTrie);
+    }
+
+    for (auto it = params.findPatterns.begin(); it != params.findPatterns.end(); ++it) {
+        findNGrams(baseTrie, *it);
+    }
+
+    if (params.isBenchLookups) {
+        benchmarkLookups(baseTrie, params.testFileName);
+    }
+
+    if (params.isBenchBuild) {
+        benchmarkBuild<N>(params.trainFileName);
+    }
+
+    if (!params.serverSocket.empty()) {
+        server::QueryServer<N,doCache> queryServer(baseTrie, params.serverSocket, params.numWorkers);
+        queryServer.run();
+    }
   
     LOG_RESULT << "Done" << END_LOG;
 }
 
+/**
+ * Creates the hash map trie with the given hash policy and the map policy
+ * from the application parameters, then performs the tasks on it.
+ * @param params the application parameters
+ * @param trainFile the text corpus file
+ * @param testFile the test file with queries
+ */
+template<typename THashPolicy>
+static void performHashMapTrieTasks(const TAppParams & params, ifstream &trainFile, ifstream &testFile) {
+    LOG_INFO << "Using the " << HASH_MAP_TRIE_VALUE << " trie with the " << params.hashPolicy
+             << " hash and the " << params.mapPolicy << " maps" << END_LOG;
+#if TRIE_POLICY_COMBINATIONS
+    if (!params.mapPolicy.compare(NODE_MAP_VALUE)) {
+        HashMapTrie<N_GRAM_PARAM, true, THashPolicy, NodeMapPolicy> trie;
+        performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+        return;
+    }
+    if (!params.mapPolicy.compare(FLAT_MAP_VALUE)) {
+        HashMapTrie<N_GRAM_PARAM, true, THashPolicy, FlatMapPolicy> trie;
+        performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+        return;
+    }
+#endif
+    HashMapTrie<N_GRAM_PARAM, true, THashPolicy, AdaptiveMapPolicy> trie;
+    performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+}
+
 /**
  * The main program entry point
  */
@@ -318,6 +1330,36 @@ int main(int argc, char** argv) {
         //Attempt to extract the program arguments
         TAppParams params = {};
         extractArguments(argc, argv, params);
+        memory::setLargeTablePolicy(params.pagePolicy, params.numaPolicy);
+
+        if (!params.clientSocket.empty()) {
+            //Send the test queries to the query server
+            ifstream testFile(params.testFileName.c_str());
+            if (!testFile.is_open()) {
+                throw Exception("The input file does not exist: " + getFileExistsString(params.testFileName, testFile));
+            }
+            server::QueryLoadGenerator<N_GRAM_PARAM> generator(params.clientSocket, params.numConnections,
+                                                                params.numRequests, params.batchSize);
+            generator.run(testFile);
+            return returnCode;
+        }
+
+        if (!params.mergeCountsFileName.empty()) {
+            //Merge the counts files into one
+            LOG_RESULT << "Merging " << params.countsFileNames.size() << " counts files into '"
+                       << params.mergeCountsFileName << "' ..." << END_LOG;
+            ProcessBuilder<N_GRAM_PARAM>::mergeCounts(params.countsFileNames, params.mergeCountsFileName);
+            LOG_RESULT << "Done" << END_LOG;
+            return returnCode;
+        }
+
+        if (params.numRanges > 0) {
+            //Count one range of the train file, this is a builder process
+            ProcessBuilder<N_GRAM_PARAM>::buildRange(params.trainFileName, params.rangeIdx,
+                                                     params.numRanges, params.saveCountsFileName);
+            LOG_RESULT << "Done" << END_LOG;
+            return returnCode;
+        }
 
         LOG_INFO << "Checking on the provided files \'"
                                   << params.trainFileName << "\' and \'"
@@ -330,7 +1372,34 @@ int main(int argc, char** argv) {
         //If the files could be opened then proceed with training and then testing
         if ((trainFile.is_open()) && (testFile.is_open())) {
             //Do the actual work, read the text corpse, create trie and do queries
-            performTasks(trainFile, testFile);
+            if (!params.trieType.compare(SHARDED_TRIE_VALUE)) {
+                LOG_INFO << "Using the " << SHARDED_TRIE_VALUE << " trie with " << params.numShards << " shards" << END_LOG;
+                TFiveCacheShardedTrie trie(params.numShards);
+                performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+            } else if (!params.trieType.compare(CONCURRENT_TRIE_VALUE)) {
+                LOG_INFO << "Using the " << CONCURRENT_TRIE_VALUE << " trie with " << params.numWorkers << " builder threads" << END_LOG;
+                TFiveCacheConcurrentTrie trie(params.numWorkers);
+                performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+            } else if (!params.trieType.compare(SEGMENTED_TRIE_VALUE)) {
+                LOG_INFO << "Using the " << SEGMENTED_TRIE_VALUE << " trie with up to " << params.segmentNGrams
+                         << " in-memory N-grams and the segments in '" << params.segmentDir << "'" << END_LOG;
+                TFiveCacheSegmentedTrie trie(params.segmentDir, params.segmentNGrams);
+                performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+                LOG_INFO << "The segmented trie has " << trie.getNumSegments() << " segments" << END_LOG;
+            } else if (!params.trieType.compare(ELIAS_FANO_TRIE_VALUE)) {
+                LOG_INFO << "Using the read only " << ELIAS_FANO_TRIE_VALUE << " trie, it is compressed once compacted" << END_LOG;
+                TFiveCacheEliasFanoTrie trie;
+                performTasks<N_GRAM_PARAM, true>(params, trie, trainFile, testFile);
+            } else {
+#if TRIE_POLICY_COMBINATIONS
+                if (!params.hashPolicy.compare(DJB2_HASH_VALUE)) {
+                    performHashMapTrieTasks<Djb2HashPolicy>(params, trainFile, testFile);
+                } else if (!params.hashPolicy.compare(PRIMES_HASH_VALUE)) {
+                    performHashMapTrieTasks<PrimesHashPolicy>(params, trainFile, testFile);
+                } else
+#endif
+                performHashMapTrieTasks<MurmurHashPolicy>(params, trainFile, testFile);
+            }
         } else {
             stringstream msg;
             msg << "One of the input files does not exist: " +